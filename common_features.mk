@@ -54,6 +54,11 @@ ifeq ($(strip $(COMBO_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/process_keycode/process_combo.c
 endif
 
+ifeq ($(strip $(CHORDING_ENABLE)), yes)
+    OPT_DEFS += -DCHORDING_ENABLE
+    SRC += $(QUANTUM_DIR)/process_keycode/process_chording.c
+endif
+
 ifeq ($(strip $(VIRTSER_ENABLE)), yes)
     OPT_DEFS += -DVIRTSER_ENABLE
 endif
@@ -150,4 +155,9 @@ QUANTUM_SRC:= \
 
 ifndef CUSTOM_MATRIX
     QUANTUM_SRC += $(QUANTUM_DIR)/matrix.c
+endif
+
+ifeq ($(strip $(DYNAMIC_KEYMAP_ENABLE)), yes)
+    OPT_DEFS += -DDYNAMIC_KEYMAP_ENABLE
+    QUANTUM_SRC += $(QUANTUM_DIR)/dynamic_keymap.c
 endif
\ No newline at end of file
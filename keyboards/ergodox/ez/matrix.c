@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "matrix.h"
 #include "ez.h"
 #include "i2cmaster.h"
+#include "twi_async.h"
 #ifdef DEBUG_MATRIX_SCAN_RATE
 #include  "timer.h"
 #endif
@@ -65,7 +66,19 @@ static uint8_t debounce_matrix[MATRIX_ROWS * MATRIX_COLS];
 static matrix_row_t read_cols(uint8_t row);
 static void init_cols(void);
 static void unselect_rows(void);
+static void unselect_teensy_rows(void);
 static void select_row(uint8_t row);
+static void init_mcp23018_scan(void);
+static void queue_mcp23018_scan(void);
+
+// rows 0-6 are on the mcp23018, rows 7-13 on the teensy
+#define MCP23018_ROWS 7
+
+// GPIOA values selecting each mcp23018 row, and the last one none of them
+static uint8_t mcp23018_select[MCP23018_ROWS + 1][2];
+static uint8_t mcp23018_gpiob = GPIOB;
+// GPIOB as read for each row
+static uint8_t mcp23018_cols[MCP23018_ROWS];
 
 static uint8_t mcp23018_reset_loop;
 
@@ -112,6 +125,7 @@ void matrix_init(void)
 
     unselect_rows();
     init_cols();
+    init_mcp23018_scan();
 
     // initialize matrix state: all keys off
     for (uint8_t i=0; i < MATRIX_ROWS; i++) {
@@ -171,6 +185,14 @@ void debounce_report(matrix_row_t change, uint8_t row) {
   }
 }
 
+static void update_row(uint8_t row, matrix_row_t cols)
+{
+    matrix_row_t mask = debounce_mask(row);
+    cols = (cols & mask) | (matrix[row] & ~mask);
+    debounce_report(cols ^ matrix[row], row);
+    matrix[row] = cols;
+}
+
 uint8_t matrix_scan(void)
 {
     if (mcp23018_status) { // if there was an error
@@ -202,15 +224,23 @@ uint8_t matrix_scan(void)
     }
 #endif
 
-    for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
+    if (!mcp23018_status) {
+        queue_mcp23018_scan();
+    }
+
+    // the teensy rows are scanned while the mcp23018 is read in the background
+    for (uint8_t i = MCP23018_ROWS; i < MATRIX_ROWS; i++) {
         select_row(i);
         wait_us(30);  // without this wait read unstable value.
-        matrix_row_t mask = debounce_mask(i);
-        matrix_row_t cols = (read_cols(i) & mask) | (matrix[i] & ~mask);
-        debounce_report(cols ^ matrix[i], i);
-        matrix[i] = cols;
+        update_row(i, read_cols(i));
+        unselect_teensy_rows();
+    }
 
-        unselect_rows();
+    if (!mcp23018_status) {
+        mcp23018_status = twi_async_wait();
+    }
+    for (uint8_t i = 0; i < MCP23018_ROWS; i++) {
+        update_row(i, read_cols(i));
     }
 
     matrix_scan_quantum();
@@ -277,19 +307,12 @@ static void  init_cols(void)
 
 static matrix_row_t read_cols(uint8_t row)
 {
-    if (row < 7) {
+    if (row < MCP23018_ROWS) {
         if (mcp23018_status) { // if there was an error
             return 0;
         } else {
-            uint8_t data = 0;
-            mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
-            mcp23018_status = i2c_write(GPIOB);             if (mcp23018_status) goto out;
-            mcp23018_status = i2c_start(I2C_ADDR_READ);     if (mcp23018_status) goto out;
-            data = i2c_readNak();
-            data = ~data;
-        out:
-            i2c_stop();
-            return data;
+            // read by queue_mcp23018_scan()
+            return (uint8_t)~mcp23018_cols[row];
         }
     } else {
         // read from teensy
@@ -329,7 +352,11 @@ static void unselect_rows(void)
         i2c_stop();
     }
 
-    // unselect on teensy
+    unselect_teensy_rows();
+}
+
+static void unselect_teensy_rows(void)
+{
     // Hi-Z(DDR:0, PORT:0) to unselect
     DDRB  &= ~(1<<0 | 1<<1 | 1<<2 | 1<<3);
     PORTB &= ~(1<<0 | 1<<1 | 1<<2 | 1<<3);
@@ -341,21 +368,8 @@ static void unselect_rows(void)
 
 static void select_row(uint8_t row)
 {
-    if (row < 7) {
-        // select on mcp23018
-        if (mcp23018_status) { // if there was an error
-            // do nothing
-        } else {
-            // set active row low  : 0
-            // set other rows hi-Z : 1
-            mcp23018_status = i2c_start(I2C_ADDR_WRITE);        if (mcp23018_status) goto out;
-            mcp23018_status = i2c_write(GPIOA);                 if (mcp23018_status) goto out;
-            mcp23018_status = i2c_write( 0xFF & ~(1<<row)
-                                  & ~(0<<7)
-                              );                                if (mcp23018_status) goto out;
-        out:
-            i2c_stop();
-        }
+    if (row < MCP23018_ROWS) {
+        // the mcp23018 rows are selected by queue_mcp23018_scan()
     } else {
         // select on teensy
         // Output low(DDR:1, PORT:0) to select
@@ -392,3 +406,34 @@ static void select_row(uint8_t row)
     }
 }
 
+static void init_mcp23018_scan(void)
+{
+    for (uint8_t row = 0; row <= MCP23018_ROWS; row++) {
+        // set active row low  : 0
+        // set other rows hi-Z : 1
+        mcp23018_select[row][0] = GPIOA;
+        mcp23018_select[row][1] = 0xFF & ~(1<<row);
+    }
+    mcp23018_select[MCP23018_ROWS][1] = 0xFF;
+}
+
+/* Queues the read of all the mcp23018 rows
+ *
+ * After selecting the first row, each row is one transaction that reads
+ * GPIOB and selects the next row, or none after the last one. The start,
+ * address and register bytes of the next transaction give the new row more
+ * time to settle than the wait on the teensy side.
+ */
+static void queue_mcp23018_scan(void)
+{
+    twi_segment_t segments[3] = {
+        { I2C_ADDR_WRITE, TWI_STOP, 2, mcp23018_select[0] },
+    };
+    twi_async_queue(segments, 1);
+    for (uint8_t row = 0; row < MCP23018_ROWS; row++) {
+        segments[0] = (twi_segment_t){ I2C_ADDR_WRITE, 0,        1, &mcp23018_gpiob };
+        segments[1] = (twi_segment_t){ I2C_ADDR_READ,  0,        1, &mcp23018_cols[row] };
+        segments[2] = (twi_segment_t){ I2C_ADDR_WRITE, TWI_STOP, 2, mcp23018_select[row + 1] };
+        twi_async_queue(segments, 3);
+    }
+}
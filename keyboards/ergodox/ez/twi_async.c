@@ -0,0 +1,109 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <compat/twi.h>
+#include "twi_async.h"
+
+#if (TWI_ASYNC_QUEUE_SIZE & (TWI_ASYNC_QUEUE_SIZE - 1)) || TWI_ASYNC_QUEUE_SIZE > 128
+#error "TWI_ASYNC_QUEUE_SIZE must be a power of two, no larger than 128"
+#endif
+
+#define QUEUE_MASK (TWI_ASYNC_QUEUE_SIZE - 1)
+
+#define TWCR_NEXT  ((1<<TWINT) | (1<<TWEN) | (1<<TWIE))
+#define TWCR_START (TWCR_NEXT | (1<<TWSTA))
+#define TWCR_STOP  ((1<<TWINT) | (1<<TWEN) | (1<<TWSTO))
+
+static twi_segment_t queue[TWI_ASYNC_QUEUE_SIZE];
+// head is only advanced by the main loop and tail by the interrupt
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_tail = 0;
+static volatile bool busy = false;
+static volatile uint8_t error = 0;
+static uint8_t position;
+
+bool twi_async_queue(const twi_segment_t *segments, uint8_t count) {
+    uint8_t head = queue_head;
+    if (TWI_ASYNC_QUEUE_SIZE - (uint8_t)(head - queue_tail) < count) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        queue[(uint8_t)(head + i) & QUEUE_MASK] = segments[i];
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        queue_head = head + count;
+        if (!busy) {
+            busy = true;
+            // A stop from the previous transfer may still be on the bus
+            while (TWCR & (1<<TWSTO));
+            TWCR = TWCR_START;
+        }
+    }
+    return true;
+}
+
+bool twi_async_busy(void) {
+    return busy;
+}
+
+uint8_t twi_async_wait(void) {
+    while (busy);
+    uint8_t result = error;
+    error = 0;
+    return result;
+}
+
+ISR(TWI_vect) {
+    twi_segment_t *segment = &queue[queue_tail & QUEUE_MASK];
+
+    switch (TW_STATUS) {
+        case TW_START:
+        case TW_REP_START:
+            position = 0;
+            TWDR = segment->address;
+            TWCR = TWCR_NEXT;
+            return;
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            if (position < segment->length) {
+                TWDR = segment->data[position++];
+                TWCR = TWCR_NEXT;
+                return;
+            }
+            break;
+        case TW_MR_DATA_ACK:
+            segment->data[position++] = TWDR;
+            // fall through
+        case TW_MR_SLA_ACK:
+            // acknowledge every byte but the last one
+            if (position + 1 < segment->length) {
+                TWCR = TWCR_NEXT | (1<<TWEA);
+            } else {
+                TWCR = TWCR_NEXT;
+            }
+            return;
+        case TW_MR_DATA_NACK:
+            segment->data[position++] = TWDR;
+            break;
+        default:
+            // not acknowledged or arbitration lost, give up on the whole queue
+            error = 1;
+            queue_tail = queue_head;
+            busy = false;
+            TWCR = TWCR_STOP;
+            return;
+    }
+
+    // the segment is done
+    uint8_t flags = segment->flags;
+    queue_tail++;
+    if (!(flags & TWI_STOP)) {
+        TWCR = TWCR_START;
+    } else if (queue_tail != queue_head) {
+        // a stop followed by a start
+        TWCR = TWCR_START | (1<<TWSTO);
+    } else {
+        busy = false;
+        TWCR = TWCR_STOP;
+    }
+}
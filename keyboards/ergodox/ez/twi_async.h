@@ -0,0 +1,47 @@
+#ifndef TWI_ASYNC_H
+#define TWI_ASYNC_H
+
+/* Interrupt driven TWI master
+ *
+ * Transfers are queued as a list of segments and carried out by the TWI
+ * interrupt, so the CPU is free to do other work while the bus is busy.
+ * Each segment is a (repeated) start condition, the address byte and length
+ * data bytes, written from or read into data. A segment with TWI_STOP ends
+ * the transaction with a stop condition, otherwise the next segment follows
+ * with a repeated start. Reads have to be at least one byte long.
+ *
+ * The blocking i2c_* functions must not be used while transfers are queued;
+ * call twi_async_wait() first.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TWI_ASYNC_QUEUE_SIZE
+#define TWI_ASYNC_QUEUE_SIZE 32
+#endif
+
+#define TWI_STOP 0x01
+
+typedef struct {
+    uint8_t address;    // device address and I2C_READ or I2C_WRITE
+    uint8_t flags;
+    uint8_t length;
+    uint8_t *data;
+} twi_segment_t;
+
+/* Queues the segments of one transaction, the last one must have TWI_STOP.
+ * The data buffers have to stay valid until the transfer is done.
+ * Returns false if the queue doesn't have room for all of them.
+ */
+bool twi_async_queue(const twi_segment_t *segments, uint8_t count);
+
+bool twi_async_busy(void);
+
+/* Waits until the queue is empty.
+ * Returns 0 when every transfer succeeded, or 1 if the device didn't
+ * respond, in which case the rest of the queue was dropped.
+ */
+uint8_t twi_async_wait(void);
+
+#endif
@@ -102,6 +102,10 @@ extern const uint8_t CIE1931_CURVE[];
 #define IS31_LED_MASK_SIZE 0x12
 #define IS31_SCREEN_WIDTH 16
 
+// Clean registers between two dirty ones are sent along when that is cheaper
+// than a new transfer, which costs the register byte plus start and stop
+#define IS31_SPAN_GAP 2
+
 #define IS31
 
 /*===========================================================================*/
@@ -113,6 +117,9 @@ typedef struct{
     uint8_t write_buffer[IS31_FRAME_SIZE];
     uint8_t frame_buffer[GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH];
     uint8_t page;
+    // The PWM registers that have changed since each of the two frames was
+    // written, one bit per register
+    uint8_t dirty[2][IS31_PWM_SIZE / 8];
 }__attribute__((__packed__)) PrivData;
 
 // Some common routines and macros
@@ -143,6 +150,27 @@ static GFXINLINE void write_ram(GDisplay *g, uint8_t page, uint16_t offset, uint
     write_data(g, (uint8_t*)PRIV(g), length + 1);
 }
 
+// Writes write_buffer[start, end) to the registers from reg + start on the
+// selected page. The register goes in the byte just before the span, which is
+// write_buffer_offset for the first one, so that it's a single transfer.
+static void write_span(GDisplay *g, uint8_t reg, uint8_t start, uint8_t end) {
+    uint8_t* tx = PRIV(g)->write_buffer + start - 1;
+    uint8_t saved = *tx;
+    *tx = reg + start;
+    write_data(g, tx, end - start + 1);
+    *tx = saved;
+}
+
+static void mark_dirty(GDisplay *g, uint8_t address) {
+    PRIV(g)->dirty[0][address / 8] |= 1 << (address % 8);
+    PRIV(g)->dirty[1][address / 8] |= 1 << (address % 8);
+    g->flags |= GDISP_FLG_NEEDFLUSH;
+}
+
+static GFXINLINE bool is_dirty(const uint8_t* dirty, uint8_t address) {
+    return dirty[address / 8] & (1 << (address % 8));
+}
+
 LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
 	// The private area is the display surface.
 	g->priv = gfxAlloc(sizeof(PrivData));
@@ -197,10 +225,6 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
 
 		PRIV(g)->page++;
 		PRIV(g)->page %= 2;
-		// TODO: some smarter algorithm for this
-		// We should run only one physical page at a time
-		// This way we don't need to send so much data, and
-		// we could use slightly less memory
 		uint8_t* src = PRIV(g)->frame_buffer;
 		for (int y=0;y<GDISP_SCREEN_HEIGHT;y++) {
 		    for (int x=0;x<GDISP_SCREEN_WIDTH;x++) {
@@ -209,7 +233,26 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
 		        ++src;
 		    }
 		}
-        write_ram(g, PRIV(g)->page, IS31_PWM_REG, IS31_PWM_SIZE);
+        // Only the registers changed since this frame was last shown are sent,
+        // in as few transfers as possible
+        uint8_t* dirty = PRIV(g)->dirty[PRIV(g)->page];
+        write_page(g, PRIV(g)->page);
+        uint8_t address = 0;
+        while (address < IS31_PWM_SIZE) {
+            if (!is_dirty(dirty, address)) {
+                address++;
+                continue;
+            }
+            uint8_t start = address;
+            uint8_t end = ++address;
+            while (address < IS31_PWM_SIZE && address - end <= IS31_SPAN_GAP) {
+                if (is_dirty(dirty, address))
+                    end = address + 1;
+                address++;
+            }
+            write_span(g, IS31_PWM_REG, start, end);
+        }
+        __builtin_memset(dirty, 0, IS31_PWM_SIZE / 8);
         gfxSleepMilliseconds(1);
         write_register(g, IS31_FUNCTIONREG, IS31_REG_PICTDISP, PRIV(g)->page);
 
@@ -232,8 +275,11 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
 			y = g->p.y;
 			break;
 		}
-		PRIV(g)->frame_buffer[y * GDISP_SCREEN_WIDTH + x] = gdispColor2Native(g->p.color);
-		g->flags |= GDISP_FLG_NEEDFLUSH;
+		uint8_t* dst = &PRIV(g)->frame_buffer[y * GDISP_SCREEN_WIDTH + x];
+		if (*dst != gdispColor2Native(g->p.color)) {
+			*dst = gdispColor2Native(g->p.color);
+			mark_dirty(g, get_led_address(g, x, y));
+		}
 	}
 #endif
 
@@ -303,7 +349,12 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
                 return;
 		    unsigned val = (unsigned)g->p.ptr;
 		    g->g.Backlight = val > 100 ? 100 : val;
-            g->flags |= GDISP_FLG_NEEDFLUSH;
+		    // Every LED changes brightness
+		    for (uint8_t y = 0; y < GDISP_SCREEN_HEIGHT; y++) {
+		        for (uint8_t x = 0; x < GDISP_SCREEN_WIDTH; x++) {
+		            mark_dirty(g, get_led_address(g, x, y));
+		        }
+		    }
 		    return;
 		}
 	}
@@ -56,11 +56,22 @@
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+#define ST7565_PAGES            (GDISP_SCREEN_HEIGHT / 8)
+
+// The columns [start, end) of a page that differ from the display RAM
+typedef struct{
+    uint8_t start;
+    uint8_t end;
+}DirtySpan;
+
 typedef struct{
     bool_t buffer2;
     uint8_t data_pos;
     uint8_t data[16];
     uint8_t ram[GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH / 8];
+    // One set for each of the two display buffers, as a change has to reach
+    // both of them before the spans can be forgotten
+    DirtySpan dirty[2][ST7565_PAGES];
 }PrivData;
 
 // Some common routines and macros
@@ -86,6 +97,34 @@ static GFXINLINE void flush_cmd(GDisplay* g) {
 #define xyaddr(x, y)		((x) + ((y)>>3)*GDISP_SCREEN_WIDTH)
 #define xybit(y)			(1<<((y)&7))
 
+static void mark_dirty(GDisplay* g, unsigned page, unsigned x) {
+    for (unsigned b = 0; b < 2; b++) {
+        DirtySpan* span = &PRIV(g)->dirty[b][page];
+        if (x < span->start)
+            span->start = x;
+        if (x >= span->end)
+            span->end = x + 1;
+    }
+    g->flags |= GDISP_FLG_NEEDFLUSH;
+}
+
+static void mark_all_dirty(GDisplay* g) {
+    for (unsigned p = 0; p < ST7565_PAGES; p++) {
+        mark_dirty(g, p, 0);
+        mark_dirty(g, p, GDISP_SCREEN_WIDTH - 1);
+    }
+}
+
+// Only touches the display when the byte actually changes
+static GFXINLINE void write_ram(GDisplay* g, coord_t x, coord_t y, bool_t set) {
+    uint8_t* dst = &RAM(g)[xyaddr(x, y)];
+    uint8_t value = set ? (*dst | xybit(y)) : (*dst & ~xybit(y));
+    if (value != *dst) {
+        *dst = value;
+        mark_dirty(g, y >> 3, x);
+    }
+}
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -102,6 +141,12 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
     g->priv = gfxAlloc(sizeof(PrivData));
     PRIV(g)->buffer2 = false;
     PRIV(g)->data_pos = 0;
+    for (unsigned p = 0; p < ST7565_PAGES; p++) {
+        PRIV(g)->dirty[0][p].start = PRIV(g)->dirty[1][p].start = GDISP_SCREEN_WIDTH;
+        PRIV(g)->dirty[0][p].end = PRIV(g)->dirty[1][p].end = 0;
+    }
+    // Nothing is known about the display RAM yet
+    mark_all_dirty(g);
 
     // Initialise the board interface
     init_board(g);
@@ -159,15 +204,22 @@ LLDSPEC void gdisp_lld_flush(GDisplay *g) {
     acquire_bus(g);
     enter_cmd_mode(g);
     unsigned dstOffset = (PRIV(g)->buffer2 ? 4 : 0);
-    for (p = 0; p < 4; p++) {
+    DirtySpan* dirty = PRIV(g)->dirty[PRIV(g)->buffer2 ? 1 : 0];
+    for (p = 0; p < ST7565_PAGES; p++) {
+        // Burst the changed columns of the page, the rest is already there
+        unsigned start = dirty[p].start;
+        if (start >= dirty[p].end)
+            continue;
         write_cmd(g, ST7565_PAGE | (p + dstOffset));
-        write_cmd(g, ST7565_COLUMN_MSB | 0);
-        write_cmd(g, ST7565_COLUMN_LSB | 0);
+        write_cmd(g, ST7565_COLUMN_MSB | (start >> 4));
+        write_cmd(g, ST7565_COLUMN_LSB | (start & 0xF));
         write_cmd(g, ST7565_RMW);
         flush_cmd(g);
         enter_data_mode(g);
-        write_data(g, RAM(g) + (p*GDISP_SCREEN_WIDTH), GDISP_SCREEN_WIDTH);
+        write_data(g, RAM(g) + (p*GDISP_SCREEN_WIDTH) + start, dirty[p].end - start);
         enter_cmd_mode(g);
+        dirty[p].start = GDISP_SCREEN_WIDTH;
+        dirty[p].end = 0;
     }
     unsigned line = (PRIV(g)->buffer2 ? 32 : 0);
     write_cmd(g, ST7565_START_LINE | line);
@@ -202,11 +254,7 @@ LLDSPEC void gdisp_lld_draw_pixel(GDisplay *g) {
         y = g->p.x;
         break;
     }
-    if (gdispColor2Native(g->p.color) != Black)
-        RAM(g)[xyaddr(x, y)] |= xybit(y);
-    else
-        RAM(g)[xyaddr(x, y)] &= ~xybit(y);
-    g->flags |= GDISP_FLG_NEEDFLUSH;
+    write_ram(g, x, y, gdispColor2Native(g->p.color) != Black);
 }
 #endif
 
@@ -250,18 +298,11 @@ LLDSPEC void gdisp_lld_blit_area(GDisplay *g) {
             uint8_t src = buffer[srcbit / 8];
             uint8_t bit = 7-(srcbit % 8);
             uint8_t bitset = (src >> bit) & 1;
-            uint8_t* dst = &(RAM(g)[xyaddr(dstx, dsty)]);
-            if (bitset) {
-                *dst |= xybit(dsty);
-            }
-            else {
-                *dst &= ~xybit(dsty);
-            }
+            write_ram(g, dstx, dsty, bitset);
 			dstx++;
             srcbit++;
         }
     }
-    g->flags |= GDISP_FLG_NEEDFLUSH;
 }
 
 #if GDISP_NEED_CONTROL && GDISP_HARDWARE_CONTROL
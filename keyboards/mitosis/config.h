@@ -73,13 +73,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define SERIAL_UART_UBRR (F_CPU / (16UL * SERIAL_UART_BAUD) - 1)
 #define SERIAL_UART_TXD_READY (UCSR1A & _BV(UDRE1))
 #define SERIAL_UART_RXD_PRESENT (UCSR1A & _BV(RXC1))
+#define SERIAL_UART_RXD_VECT USART1_RX_vect
 #define SERIAL_UART_INIT() do { \
     	/* baud rate */ \
     	UBRR1L = SERIAL_UART_UBRR; \
     	/* baud rate */ \
     	UBRR1H = SERIAL_UART_UBRR >> 8; \
-    	/* enable TX and RX */ \
-    	UCSR1B = _BV(TXEN1) | _BV(RXEN1); \
+    	/* enable TX, RX and the RX interrupt */ \
+    	UCSR1B = _BV(TXEN1) | _BV(RXEN1) | _BV(RXCIE1); \
     	/* 8-bit data */ \
     	UCSR1C = _BV(UCSZ11) | _BV(UCSZ10); \
   	} while(0)
@@ -17,8 +17,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #if defined(__AVR__)
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 #endif
 #include "wait.h"
 #include "print.h"
@@ -47,6 +50,56 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /* matrix state(1:on, 0:off) */
 static matrix_row_t matrix[MATRIX_ROWS];
 
+//the s character requests the RF slave to send the matrix
+#define UART_MATRIX_REQUEST 's'
+//there are 10 bytes corresponding to 10 columns, and an end byte
+#define UART_MATRIX_PACKET_SIZE 11
+//the key state bytes use the LSBs, so 0xE0 will only show up in the end
+//byte if the correct bytes were received
+#define UART_MATRIX_END 0xE0
+//ask again if no packet came in for this long, in ms. This only happened
+//in testing with a loose wire, but does no harm to leave it in here
+#ifndef UART_MATRIX_TIMEOUT
+#define UART_MATRIX_TIMEOUT 10
+#endif
+
+//the receive interrupt fills one slot while the other holds the latest
+//complete packet, which matrix_scan picks up
+static uint8_t uart_packets[2][UART_MATRIX_PACKET_SIZE];
+static uint8_t *uart_receiving = uart_packets[0];
+static uint8_t *uart_latest = uart_packets[1];
+static uint8_t uart_position = 0;
+static volatile bool uart_fresh = false;
+static uint16_t uart_last_packet;
+
+static void uart_request(void)
+{
+    uart_position = 0;
+    SERIAL_UART_DATA = UART_MATRIX_REQUEST;
+}
+
+ISR(SERIAL_UART_RXD_VECT)
+{
+    uint8_t data = SERIAL_UART_DATA;
+    if (uart_position >= UART_MATRIX_PACKET_SIZE) {
+        //out of sync, drop it until matrix_scan asks again
+        return;
+    }
+    uart_receiving[uart_position++] = data;
+    if (uart_position < UART_MATRIX_PACKET_SIZE) {
+        return;
+    }
+    if (data != UART_MATRIX_END) {
+        return;
+    }
+    uint8_t *packet = uart_latest;
+    uart_latest = uart_receiving;
+    uart_receiving = packet;
+    uart_fresh = true;
+    //ask for the next packet as soon as this one is in
+    uart_request();
+}
+
 __attribute__ ((weak))
 void matrix_init_quantum(void) {
     matrix_init_kb();
@@ -86,47 +139,41 @@ uint8_t matrix_cols(void) {
 }
 
 void matrix_init(void) {
+    SERIAL_UART_INIT();
+    uart_request();
+    uart_last_packet = timer_read();
 
     matrix_init_quantum();
 }
 
 uint8_t matrix_scan(void)
 {
-    SERIAL_UART_INIT();
-
-    uint32_t timeout = 0;
-
-    //the s character requests the RF slave to send the matrix
-    SERIAL_UART_DATA = 's';
-
-    //trust the external keystates entirely, erase the last data
-    uint8_t uart_data[11] = {0};
-
-    //there are 10 bytes corresponding to 10 columns, and an end byte
-    for (uint8_t i = 0; i < 11; i++) {
-        //wait for the serial data, timeout if it's been too long
-        //this only happened in testing with a loose wire, but does no
-        //harm to leave it in here
-        while(!SERIAL_UART_RXD_PRESENT){
-            timeout++;
-            if (timeout > 10000){
-                break;
-            }
-        } 
-        uart_data[i] = SERIAL_UART_DATA;
+    uint8_t uart_data[UART_MATRIX_PACKET_SIZE];
+    bool fresh = false;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (uart_fresh) {
+            memcpy(uart_data, uart_latest, sizeof(uart_data));
+            uart_fresh = false;
+            fresh = true;
+        }
     }
 
-    //check for the end packet, the key state bytes use the LSBs, so 0xE0
-    //will only show up here if the correct bytes were recieved
-    if (uart_data[10] == 0xE0)
-    {
+    if (fresh) {
+        uart_last_packet = timer_read();
+        //trust the external keystates entirely
         //shifting and transferring the keystates to the QMK matrix variable
         for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
             matrix[i] = (uint16_t) uart_data[i*2] | (uint16_t) uart_data[i*2+1] << 5;
         }
+    } else if (timer_elapsed(uart_last_packet) > UART_MATRIX_TIMEOUT) {
+        //a byte got lost or the request never arrived
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            uart_request();
+        }
+        uart_last_packet = timer_read();
     }
 
-
     matrix_scan_quantum();
     return 1;
 }
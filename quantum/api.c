@@ -71,6 +71,20 @@ void process_api(uint16_t length, uint8_t * data) {
                     #endif
                     break;
                 }
+                #ifdef DYNAMIC_KEYMAP_ENABLE
+                case DT_KEYMAP: {
+                    // too short to say which page it was, so there is nothing to ack
+                    if (length < 5) {
+                        return;
+                    }
+                    // ack with the page's offset and count, and the status
+                    uint8_t ack[4] = { data[2], data[3], data[4], 0 };
+                    ack[3] = dynamic_keymap_write_page(data + 2, length - 2);
+                    MT_SET_DATA_ACK(DT_KEYMAP, ack, 4);
+                    // don't fall through to MT_GET_DATA, the page isn't a read request
+                    return;
+                }
+                #endif
             }
         case MT_GET_DATA:
             switch (data[1]) {
@@ -79,12 +93,12 @@ void process_api(uint16_t length, uint8_t * data) {
                     break;
                 }
                 case DT_DEBUG: {
-                    uint8_t debug_bytes[1] = { eeprom_read_byte(EECONFIG_DEBUG) };
+                    uint8_t debug_bytes[1] = { eeconfig_read_byte(EECONFIG_DEBUG) };
                     MT_GET_DATA_ACK(DT_DEBUG, debug_bytes, 1);
                     break;
                 }
                 case DT_DEFAULT_LAYER: {
-                    uint8_t default_bytes[1] = { eeprom_read_byte(EECONFIG_DEFAULT_LAYER) };
+                    uint8_t default_bytes[1] = { eeconfig_read_byte(EECONFIG_DEFAULT_LAYER) };
                     MT_GET_DATA_ACK(DT_DEFAULT_LAYER, default_bytes, 1);
                     break;
                 }
@@ -96,7 +110,7 @@ void process_api(uint16_t length, uint8_t * data) {
                 }
                 case DT_AUDIO: {
                     #ifdef AUDIO_ENABLE
-                        uint8_t audio_bytes[1] = { eeprom_read_byte(EECONFIG_AUDIO) };
+                        uint8_t audio_bytes[1] = { eeconfig_read_byte(EECONFIG_AUDIO) };
                         MT_GET_DATA_ACK(DT_AUDIO, audio_bytes, 1);
                     #else
                         MT_GET_DATA_ACK(DT_AUDIO, NULL, 0);
@@ -105,7 +119,7 @@ void process_api(uint16_t length, uint8_t * data) {
                 }
                 case DT_BACKLIGHT: {
                     #ifdef BACKLIGHT_ENABLE
-                        uint8_t backlight_bytes[1] = { eeprom_read_byte(EECONFIG_BACKLIGHT) };
+                        uint8_t backlight_bytes[1] = { eeconfig_read_byte(EECONFIG_BACKLIGHT) };
                         MT_GET_DATA_ACK(DT_BACKLIGHT, backlight_bytes, 1);
                     #else
                         MT_GET_DATA_ACK(DT_BACKLIGHT, NULL, 0);
@@ -128,33 +142,28 @@ void process_api(uint16_t length, uint8_t * data) {
                     break;
                 }
                 case DT_KEYMAP_SIZE: {
-                    uint8_t keymap_size[2] = {MATRIX_ROWS, MATRIX_COLS};
-                    MT_GET_DATA_ACK(DT_KEYMAP_SIZE, keymap_size, 2);
+                    #ifdef DYNAMIC_KEYMAP_ENABLE
+                        uint8_t keymap_size[5] = {MATRIX_ROWS, MATRIX_COLS,
+                            DYNAMIC_KEYMAP_LAYER_COUNT, DYNAMIC_KEYMAP_PAGE_SIZE, DYNAMIC_KEYMAP_WINDOW};
+                        MT_GET_DATA_ACK(DT_KEYMAP_SIZE, keymap_size, 5);
+                    #else
+                        uint8_t keymap_size[2] = {MATRIX_ROWS, MATRIX_COLS};
+                        MT_GET_DATA_ACK(DT_KEYMAP_SIZE, keymap_size, 2);
+                    #endif
                     break;
                 }
-                // This may be too much
-                // case DT_KEYMAP: {
-                //     uint8_t keymap_data[MATRIX_ROWS * MATRIX_COLS * 4 + 3];
-                //     keymap_data[0] = data[2];
-                //     keymap_data[1] = MATRIX_ROWS;
-                //     keymap_data[2] = MATRIX_COLS;
-                //     for (int i = 0; i < MATRIX_ROWS; i++) {
-                //         for (int j = 0; j < MATRIX_COLS; j++) {
-                //             keymap_data[3 + (i*MATRIX_COLS*2) + (j*2)] = pgm_read_word(&keymaps[data[2]][i][j]) >> 8;
-                //             keymap_data[3 + (i*MATRIX_COLS*2) + (j*2) + 1] = pgm_read_word(&keymaps[data[2]][i][j]) & 0xFF;
-                //         }
-                //     }
-                //     MT_GET_DATA_ACK(DT_KEYMAP, keymap_data, MATRIX_ROWS * MATRIX_COLS * 4 + 3);
-                //     // uint8_t keymap_data[5];
-                //     // keymap_data[0] = data[2];
-                //     // keymap_data[1] = data[3];
-                //     // keymap_data[2] = data[4];
-                //     // keymap_data[3] = pgm_read_word(&keymaps[data[2]][data[3]][data[4]]) >> 8;
-                //     // keymap_data[4] = pgm_read_word(&keymaps[data[2]][data[3]][data[4]]) & 0xFF;
-
-                //     // MT_GET_DATA_ACK(DT_KEYMAP, keymap_data, 5);
-                //     break;
-                // }
+                #ifdef DYNAMIC_KEYMAP_ENABLE
+                case DT_KEYMAP: {
+                    // offset and count
+                    if (length < 5) {
+                        break;
+                    }
+                    uint8_t page[DYNAMIC_KEYMAP_PAGE_MAX];
+                    uint8_t page_length = dynamic_keymap_read_page((data[2] << 8) | data[3], data[4], page);
+                    MT_GET_DATA_ACK(DT_KEYMAP, page, page_length);
+                    break;
+                }
+                #endif
                 default:
                     break;
             }
@@ -17,56 +17,59 @@
 #include "sysex_tools.h"
 #include "print.h"
 
-void send_bytes_sysex(uint8_t message_type, uint8_t data_type, uint8_t * bytes, uint16_t length) {
-    // SEND_STRING("\nTX: ");
-    // for (uint8_t i = 0; i < length; i++) {
-    //     send_byte(bytes[i]);
-    //     SEND_STRING(" ");
-    // }
-    if (length > API_SYSEX_MAX_SIZE) {
-        xprintf("Sysex msg too big %d %d %d", message_type, data_type, length);
-        return;
-    }
+// The message is sent as it is encoded, three bytes per USB-MIDI packet, so
+// neither the message nor its encoding has to fit in memory at once
+static sysex_encoder_t sysex_encoder;
+static uint8_t sysex_packet[3];
+static uint8_t sysex_packet_count;
 
+static void send_sysex_raw(const uint8_t * bytes, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        sysex_packet[sysex_packet_count++] = bytes[i];
+        if (sysex_packet_count == 3) {
+            midi_send_data(&midi_device, 3, sysex_packet[0], sysex_packet[1], sysex_packet[2]);
+            sysex_packet_count = 0;
+        }
+    }
+}
 
-    // The buffer size required is calculated as the following
-    // API_SYSEX_MAX_SIZE is the maximum length
-    // In addition to that we have a two byte message header consisting of the message_type and data_type
-    // This has to be encoded with an additional overhead of one byte for every starting 7 bytes
-    // We just add one extra byte in case it's not divisible by 7
-    // Then we have an unencoded header consisting of 4 bytes
-    // Plus a one byte terminator
-    const unsigned message_header = 2;
-    const unsigned unencoded_message = API_SYSEX_MAX_SIZE + message_header;
-    const unsigned encoding_overhead = unencoded_message / 7 + 1;
-    const unsigned encoded_size = unencoded_message + encoding_overhead;
-    const unsigned unencoded_header = 4;
-    const unsigned terminator = 1;
-    const unsigned buffer_size = encoded_size + unencoded_header + terminator;
-    uint8_t buffer[encoded_size + unencoded_header + terminator];
+void send_bytes_sysex_begin(uint8_t message_type, uint8_t data_type) {
     // The unencoded header
-    buffer[0] = 0xF0;
-    buffer[1] = 0x00;
-    buffer[2] = 0x00;
-    buffer[3] = 0x00;
+    static const uint8_t header[] = { 0xF0, 0x00, 0x00, 0x00 };
+    sysex_packet_count = 0;
+    sysex_encoder_init(&sysex_encoder);
+    send_sysex_raw(header, sizeof(header));
+
+    const uint8_t message_header[] = { message_type, data_type };
+    send_bytes_sysex_data(message_header, sizeof(message_header));
+}
 
-    // We copy the message to the end of the array, this way we can do an inplace encoding, using the same
-    // buffer for both input and output
-    const unsigned message_size = length + message_header;
-    uint8_t* unencoded_start = buffer + buffer_size - message_size;
-    uint8_t* ptr = unencoded_start;
-    *(ptr++) = message_type;
-    *(ptr++) = data_type;
-    memcpy(ptr, bytes, length);
+void send_bytes_sysex_data(const uint8_t * bytes, uint16_t length) {
+    uint8_t encoded[8];
+    while (length > 0) {
+        // at most one section is completed by 7 bytes
+        uint8_t chunk = length < 7 ? length : 7;
+        send_sysex_raw(encoded, sysex_encoder_encode(&sysex_encoder, encoded, bytes, chunk));
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+void send_bytes_sysex_end(void) {
+    uint8_t encoded[8];
+    send_sysex_raw(encoded, sysex_encoder_finish(&sysex_encoder, encoded));
 
-    unsigned encoded_length = sysex_encode(buffer + unencoded_header, unencoded_start, message_size);
-    unsigned final_size = unencoded_header + encoded_length + terminator;
-    buffer[final_size - 1] = 0xF7;
-    midi_send_array(&midi_device, final_size, buffer);
+    const uint8_t terminator = 0xF7;
+    send_sysex_raw(&terminator, 1);
+    if (sysex_packet_count > 0) {
+        midi_send_data(&midi_device, sysex_packet_count, sysex_packet[0],
+            sysex_packet_count > 1 ? sysex_packet[1] : 0, 0);
+        sysex_packet_count = 0;
+    }
+}
 
-    // SEND_STRING("\nTD: ");
-    // for (uint8_t i = 0; i < encoded_length + 5; i++) {
-    //     send_byte(buffer[i]);
-    //     SEND_STRING(" ");
-    // }
+void send_bytes_sysex(uint8_t message_type, uint8_t data_type, uint8_t * bytes, uint16_t length) {
+    send_bytes_sysex_begin(message_type, data_type);
+    send_bytes_sysex_data(bytes, length);
+    send_bytes_sysex_end();
 }
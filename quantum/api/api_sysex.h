@@ -21,6 +21,11 @@
 
 void send_bytes_sysex(uint8_t message_type, uint8_t data_type, uint8_t * bytes, uint16_t length);
 
+// Sends a message in pieces, for payloads that are produced as they are sent
+void send_bytes_sysex_begin(uint8_t message_type, uint8_t data_type);
+void send_bytes_sysex_data(const uint8_t * bytes, uint16_t length);
+void send_bytes_sysex_end(void);
+
 #define SEND_BYTES(mt, dt, b, l) send_bytes_sysex(mt, dt, b, l)
 
 #endif
@@ -0,0 +1,254 @@
+#include <string.h>
+#include "dynamic_keymap.h"
+#include "keymap.h"
+#include "eeprom.h"
+
+#define KEYS_PER_LAYER (MATRIX_ROWS * MATRIX_COLS)
+#define KEY_BIT(index) (1 << ((index) % 8))
+
+/* keys that are held, by matrix position */
+static uint8_t held[(KEYS_PER_LAYER + 7) / 8];
+/* keys that were changed while they were held */
+static uint8_t pending[DYNAMIC_KEYMAP_BITMAP_SIZE];
+static uint16_t pending_count;
+
+#ifdef DYNAMIC_KEYMAP_MIRROR
+static uint16_t mirror[DYNAMIC_KEYMAP_KEY_COUNT];
+#else
+static uint8_t overridden[DYNAMIC_KEYMAP_BITMAP_SIZE];
+/* the number of overrides before each byte of overridden */
+static uint8_t rank[DYNAMIC_KEYMAP_BITMAP_SIZE];
+static uint16_t overrides[DYNAMIC_KEYMAP_CAPACITY];
+static uint8_t override_count;
+
+static const uint8_t nibble_bits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+/* position of the key in overrides, whether it has one or not */
+static uint8_t override_position(uint16_t index)
+{
+    uint8_t before = overridden[index / 8] & (KEY_BIT(index) - 1);
+    return rank[index / 8] + nibble_bits[before & 0x0F] + nibble_bits[before >> 4];
+}
+#endif
+
+static uint16_t *dynamic_keymap_address(uint16_t index)
+{
+    return DYNAMIC_KEYMAP_EEPROM_ADDR + index;
+}
+
+static uint16_t flash_keycode(uint16_t index)
+{
+    uint8_t layer = index / KEYS_PER_LAYER;
+    uint8_t row = (index / MATRIX_COLS) % MATRIX_ROWS;
+    uint8_t col = index % MATRIX_COLS;
+    return pgm_read_word(&keymaps[layer][row][col]);
+}
+
+#ifndef DYNAMIC_KEYMAP_MIRROR
+static bool needs_slot(uint16_t index, uint16_t keycode)
+{
+    if (keycode == DYNAMIC_KEYMAP_NONE || overridden[index / 8] & KEY_BIT(index)) {
+        return false;
+    }
+    return keycode != flash_keycode(index);
+}
+#endif
+
+/* Puts what is stored in EEPROM for the key into the mirror */
+static void load(uint16_t index)
+{
+    uint16_t keycode = eeprom_read_word(dynamic_keymap_address(index));
+#ifdef DYNAMIC_KEYMAP_MIRROR
+    mirror[index] = keycode == DYNAMIC_KEYMAP_NONE ? flash_keycode(index) : keycode;
+#else
+    uint8_t byte = index / 8;
+    uint8_t position = override_position(index);
+    bool has_override = overridden[byte] & KEY_BIT(index);
+
+    if (keycode == DYNAMIC_KEYMAP_NONE || keycode == flash_keycode(index)) {
+        if (has_override) {
+            memmove(&overrides[position], &overrides[position + 1], (override_count - position - 1) * sizeof(overrides[0]));
+            override_count--;
+            overridden[byte] &= ~KEY_BIT(index);
+            for (uint8_t i = byte + 1; i < DYNAMIC_KEYMAP_BITMAP_SIZE; i++) {
+                rank[i]--;
+            }
+        }
+    } else if (has_override) {
+        overrides[position] = keycode;
+    } else if (override_count < DYNAMIC_KEYMAP_CAPACITY) {
+        memmove(&overrides[position + 1], &overrides[position], (override_count - position) * sizeof(overrides[0]));
+        overrides[position] = keycode;
+        override_count++;
+        overridden[byte] |= KEY_BIT(index);
+        for (uint8_t i = byte + 1; i < DYNAMIC_KEYMAP_BITMAP_SIZE; i++) {
+            rank[i]++;
+        }
+    }
+#endif
+}
+
+void dynamic_keymap_init(void)
+{
+    memset(held, 0, sizeof(held));
+    memset(pending, 0, sizeof(pending));
+    pending_count = 0;
+#ifndef DYNAMIC_KEYMAP_MIRROR
+    memset(overridden, 0, sizeof(overridden));
+    memset(rank, 0, sizeof(rank));
+    override_count = 0;
+#endif
+    if (eeprom_read_word(DYNAMIC_KEYMAP_MAGIC_ADDR) != DYNAMIC_KEYMAP_MAGIC_NUMBER) {
+        // loads every key as it goes
+        dynamic_keymap_reset();
+        return;
+    }
+    for (uint16_t i = 0; i < DYNAMIC_KEYMAP_KEY_COUNT; i++) {
+        load(i);
+    }
+}
+
+void dynamic_keymap_record(keypos_t key, bool pressed)
+{
+    uint8_t position = key.row * MATRIX_COLS + key.col;
+    if (pressed) {
+        held[position / 8] |= KEY_BIT(position);
+    } else {
+        held[position / 8] &= ~KEY_BIT(position);
+    }
+}
+
+static bool is_held(uint16_t index)
+{
+    uint8_t position = index % KEYS_PER_LAYER;
+    return held[position / 8] & KEY_BIT(position);
+}
+
+/* Called between scans, so the release that let a change through has been
+ * processed with the old keycode.
+ */
+void dynamic_keymap_task(void)
+{
+    if (pending_count == 0) {
+        return;
+    }
+    for (uint16_t i = 0; i < DYNAMIC_KEYMAP_KEY_COUNT; i++) {
+        if ((pending[i / 8] & KEY_BIT(i)) && !is_held(i)) {
+            pending[i / 8] &= ~KEY_BIT(i);
+            pending_count--;
+            load(i);
+        }
+    }
+}
+
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t col)
+{
+    uint16_t index = (layer * MATRIX_ROWS + row) * MATRIX_COLS + col;
+#ifdef DYNAMIC_KEYMAP_MIRROR
+    return mirror[index];
+#else
+    if (overridden[index / 8] & KEY_BIT(index)) {
+        return overrides[override_position(index)];
+    }
+    return pgm_read_word(&keymaps[layer][row][col]);
+#endif
+}
+
+bool dynamic_keymap_set_keycode(uint16_t index, uint16_t keycode)
+{
+    if (index >= DYNAMIC_KEYMAP_KEY_COUNT) {
+        return false;
+    }
+#ifndef DYNAMIC_KEYMAP_MIRROR
+    // keys waiting for their release may take a slot each
+    if (needs_slot(index, keycode) && override_count + pending_count >= DYNAMIC_KEYMAP_CAPACITY) {
+        return false;
+    }
+#endif
+    eeprom_update_word(dynamic_keymap_address(index), keycode);
+    if (!is_held(index)) {
+        load(index);
+    } else if (!(pending[index / 8] & KEY_BIT(index))) {
+        pending[index / 8] |= KEY_BIT(index);
+        pending_count++;
+    }
+    return true;
+}
+
+void dynamic_keymap_reset(void)
+{
+    for (uint16_t i = 0; i < DYNAMIC_KEYMAP_KEY_COUNT; i++) {
+        dynamic_keymap_set_keycode(i, DYNAMIC_KEYMAP_NONE);
+    }
+    eeprom_update_word(DYNAMIC_KEYMAP_MAGIC_ADDR, DYNAMIC_KEYMAP_MAGIC_NUMBER);
+}
+
+/* CRC-8, polynomial 0x07 */
+uint8_t dynamic_keymap_crc(uint8_t crc, const uint8_t *data, uint8_t length)
+{
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/* over everything but the crc itself */
+static uint8_t dynamic_keymap_page_crc(const uint8_t *page)
+{
+    uint8_t crc = dynamic_keymap_crc(0, page, 3);
+    return dynamic_keymap_crc(crc, page + DYNAMIC_KEYMAP_PAGE_HEADER, page[2] * 2);
+}
+
+uint8_t dynamic_keymap_read_page(uint16_t offset, uint8_t count, uint8_t *page)
+{
+    if (offset >= DYNAMIC_KEYMAP_KEY_COUNT) {
+        count = 0;
+    } else if (count > DYNAMIC_KEYMAP_KEY_COUNT - offset) {
+        count = DYNAMIC_KEYMAP_KEY_COUNT - offset;
+    }
+    if (count > DYNAMIC_KEYMAP_PAGE_SIZE) {
+        count = DYNAMIC_KEYMAP_PAGE_SIZE;
+    }
+    page[0] = offset >> 8;
+    page[1] = offset & 0xFF;
+    page[2] = count;
+
+    uint8_t *data = page + DYNAMIC_KEYMAP_PAGE_HEADER;
+    for (uint16_t i = offset; i < offset + count; i++) {
+        uint8_t layer = i / (MATRIX_ROWS * MATRIX_COLS);
+        keypos_t key = {
+            .row = (i / MATRIX_COLS) % MATRIX_ROWS,
+            .col = i % MATRIX_COLS,
+        };
+        uint16_t keycode = keymap_key_to_keycode(layer, key);
+        *data++ = keycode >> 8;
+        *data++ = keycode & 0xFF;
+    }
+    page[3] = dynamic_keymap_page_crc(page);
+    return DYNAMIC_KEYMAP_PAGE_HEADER + count * 2;
+}
+
+uint8_t dynamic_keymap_write_page(const uint8_t *page, uint8_t length)
+{
+    if (length < DYNAMIC_KEYMAP_PAGE_HEADER || length - DYNAMIC_KEYMAP_PAGE_HEADER < page[2] * 2) {
+        return DYNAMIC_KEYMAP_BAD_CRC;
+    }
+    if (dynamic_keymap_page_crc(page) != page[3]) {
+        return DYNAMIC_KEYMAP_BAD_CRC;
+    }
+    uint16_t offset = (page[0] << 8) | page[1];
+    uint8_t count = page[2];
+    if (offset > DYNAMIC_KEYMAP_KEY_COUNT || count > DYNAMIC_KEYMAP_KEY_COUNT - offset) {
+        return DYNAMIC_KEYMAP_BAD_RANGE;
+    }
+    const uint8_t *data = page + DYNAMIC_KEYMAP_PAGE_HEADER;
+    for (uint8_t i = 0; i < count; i++, data += 2) {
+        if (!dynamic_keymap_set_keycode(offset + i, (data[0] << 8) | data[1])) {
+            return DYNAMIC_KEYMAP_FULL;
+        }
+    }
+    return DYNAMIC_KEYMAP_OK;
+}
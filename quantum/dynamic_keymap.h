@@ -0,0 +1,111 @@
+#ifndef DYNAMIC_KEYMAP_H
+#define DYNAMIC_KEYMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "eeconfig.h"
+#include "keyboard.h"
+
+/* Dynamic keymap
+ *
+ * Keycodes written over the API are stored in EEPROM and take precedence
+ * over the keymaps in flash, so a board can be reconfigured without
+ * reflashing. Keys are addressed by their index in the layer major keymap,
+ * (layer * MATRIX_ROWS + row) * MATRIX_COLS + col, and transferred in pages
+ * of up to DYNAMIC_KEYMAP_PAGE_SIZE keycodes. See docs/dynamic_keymap.md.
+ *
+ * The keymap in use is mirrored in RAM, so a lookup never touches EEPROM.
+ * When the whole keymap fits in DYNAMIC_KEYMAP_RAM_SIZE it is mirrored as
+ * is, otherwise only the keys that differ from flash are kept, in key order,
+ * with a bitmap of them and a count of the ones before each bitmap byte.
+ */
+
+/* the layers that can be read and changed, no more than there are in keymaps */
+#ifndef DYNAMIC_KEYMAP_LAYER_COUNT
+#define DYNAMIC_KEYMAP_LAYER_COUNT 4
+#endif
+
+#ifndef DYNAMIC_KEYMAP_EEPROM_ADDR
+#define DYNAMIC_KEYMAP_EEPROM_ADDR ((uint16_t *)(EECONFIG_SIZE + 2))
+#endif
+/* the word before the keycodes says they were written by this keymap, so
+ * whatever other firmware left there isn't taken for overrides
+ */
+#define DYNAMIC_KEYMAP_MAGIC_ADDR (DYNAMIC_KEYMAP_EEPROM_ADDR - 1)
+
+/* keycodes per page, a page has to fit in one API message */
+#ifndef DYNAMIC_KEYMAP_PAGE_SIZE
+#define DYNAMIC_KEYMAP_PAGE_SIZE 8
+#endif
+
+/* pages the host may send before it waits for the first one to be acked */
+#ifndef DYNAMIC_KEYMAP_WINDOW
+#define DYNAMIC_KEYMAP_WINDOW 4
+#endif
+
+#define DYNAMIC_KEYMAP_KEY_COUNT (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS)
+#define DYNAMIC_KEYMAP_BITMAP_SIZE ((DYNAMIC_KEYMAP_KEY_COUNT + 7) / 8)
+
+/* bytes of RAM the mirror may use, by default the whole keymap when that is
+ * no more than 512 bytes, otherwise room for a quarter of the keys to differ
+ */
+#ifndef DYNAMIC_KEYMAP_RAM_SIZE
+#  if DYNAMIC_KEYMAP_KEY_COUNT * 2 <= 512
+#    define DYNAMIC_KEYMAP_RAM_SIZE (DYNAMIC_KEYMAP_KEY_COUNT * 2)
+#  else
+#    define DYNAMIC_KEYMAP_RAM_SIZE (2 * DYNAMIC_KEYMAP_BITMAP_SIZE + DYNAMIC_KEYMAP_KEY_COUNT / 2)
+#  endif
+#endif
+
+#if DYNAMIC_KEYMAP_KEY_COUNT * 2 <= DYNAMIC_KEYMAP_RAM_SIZE
+#define DYNAMIC_KEYMAP_MIRROR
+#else
+/* the number of keys that can differ from flash */
+#if (DYNAMIC_KEYMAP_RAM_SIZE - 2 * DYNAMIC_KEYMAP_BITMAP_SIZE) / 2 > 255
+#define DYNAMIC_KEYMAP_CAPACITY 255
+#else
+#define DYNAMIC_KEYMAP_CAPACITY ((DYNAMIC_KEYMAP_RAM_SIZE - 2 * DYNAMIC_KEYMAP_BITMAP_SIZE) / 2)
+#endif
+#endif
+
+/* what an erased cell reads as, the key isn't overridden */
+#define DYNAMIC_KEYMAP_NONE 0xFFFF
+
+/* changes with the size of the keymap, which moves every keycode */
+#define DYNAMIC_KEYMAP_MAGIC_NUMBER (0xD700 ^ DYNAMIC_KEYMAP_KEY_COUNT)
+
+/* page: offset high, offset low, keycode count, crc, keycodes high byte first */
+#define DYNAMIC_KEYMAP_PAGE_HEADER 4
+#define DYNAMIC_KEYMAP_PAGE_MAX (DYNAMIC_KEYMAP_PAGE_HEADER + DYNAMIC_KEYMAP_PAGE_SIZE * 2)
+
+enum dynamic_keymap_status {
+    DYNAMIC_KEYMAP_OK,
+    DYNAMIC_KEYMAP_BAD_CRC,
+    DYNAMIC_KEYMAP_BAD_RANGE,
+    DYNAMIC_KEYMAP_FULL,
+};
+
+/* Loads the mirror from EEPROM, or resets it when the magic doesn't match */
+void dynamic_keymap_init(void);
+/* Keeps the keys that are held on their old keycodes until they are released */
+void dynamic_keymap_record(keypos_t key, bool pressed);
+/* Applies the changes to keys that have been released since */
+void dynamic_keymap_task(void);
+
+/* Returns the keycode in use, for layers below DYNAMIC_KEYMAP_LAYER_COUNT */
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t col);
+/* Returns false when there is no room left for the change */
+bool dynamic_keymap_set_keycode(uint16_t index, uint16_t keycode);
+/* Removes every override, eeconfig_init() calls this too */
+void dynamic_keymap_reset(void);
+
+/* Continues crc over data, starting from 0 */
+uint8_t dynamic_keymap_crc(uint8_t crc, const uint8_t *data, uint8_t length);
+/* Fills page with up to count keycodes of the keymap in use, starting at offset.
+ * Returns the length of the page, the count is 0 when offset is out of range.
+ */
+uint8_t dynamic_keymap_read_page(uint16_t offset, uint8_t count, uint8_t *page);
+/* Stores the keycodes of a page, returns a dynamic_keymap_status */
+uint8_t dynamic_keymap_write_page(const uint8_t *page, uint8_t length);
+
+#endif
@@ -172,6 +172,11 @@ void action_function(keyrecord_t *record, uint8_t id, uint8_t opt)
 __attribute__ ((weak))
 uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key)
 {
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    if (layer < DYNAMIC_KEYMAP_LAYER_COUNT) {
+        return dynamic_keymap_get_keycode(layer, key.row, key.col);
+    }
+#endif
     // Read entire word (16bits)
     return pgm_read_word(&keymaps[(layer)][(key.row)][(key.col)]);
 }
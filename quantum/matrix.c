@@ -26,6 +26,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "matrix.h"
 #include "timer.h"
 
+#ifdef MATRIX_KEY_INTERRUPT
+#   if (DIODE_DIRECTION != COL2ROW) && (DIODE_DIRECTION != ROW2COL)
+#       error "MATRIX_KEY_INTERRUPT needs COL2ROW or ROW2COL"
+#   endif
+#   if defined(__AVR__)
+#       include <avr/interrupt.h>
+#       include <avr/sleep.h>
+#   endif
+#endif
+
 
 /* Set 0 if debouncing isn't needed */
 
@@ -70,6 +80,21 @@ static matrix_row_t matrix[MATRIX_ROWS];
 static matrix_row_t matrix_debouncing[MATRIX_ROWS];
 
 
+#ifdef MATRIX_KEY_INTERRUPT
+/* Every key is up and every row (col with ROW2COL) is selected, so a key
+ * going down pulls its input low. The scans only read the inputs until
+ * then, and sleep if a pin change interrupt can wake them.
+ */
+static bool waiting_for_key = false;
+/* the inputs in PCMSK0, 0 when some of them aren't on PORTB */
+static uint8_t input_pcint_mask = 0;
+
+static void start_waiting_for_key(void);
+static bool any_key_down(void);
+static void sleep_until_key(void);
+static void stop_waiting_for_key(void);
+#endif
+
 #if (DIODE_DIRECTION == COL2ROW)
     static void init_cols(void);
     static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row);
@@ -169,11 +194,40 @@ void matrix_init(void) {
         matrix_debouncing[i] = 0;
     }
 
+#ifdef MATRIX_KEY_INTERRUPT
+    waiting_for_key = false;
+#   if (DIODE_DIRECTION == COL2ROW)
+    const uint8_t* inputs = col_pins;
+    const uint8_t input_count = MATRIX_COLS;
+#   else
+    const uint8_t* inputs = row_pins;
+    const uint8_t input_count = MATRIX_ROWS;
+#   endif
+    input_pcint_mask = 0;
+    for (uint8_t i = 0; i < input_count; i++) {
+        if ((inputs[i] >> 4) != (B0 >> 4)) {
+            input_pcint_mask = 0;
+            break;
+        }
+        input_pcint_mask |= _BV(inputs[i] & 0xF);
+    }
+#endif
+
     matrix_init_quantum();
 }
 
 uint8_t matrix_scan(void)
 {
+#ifdef MATRIX_KEY_INTERRUPT
+    if (waiting_for_key) {
+        sleep_until_key();
+        if (!any_key_down()) {
+            matrix_scan_quantum();
+            return 1;
+        }
+        stop_waiting_for_key();
+    }
+#endif
 
 #if (DIODE_DIRECTION == COL2ROW)
 
@@ -220,6 +274,10 @@ uint8_t matrix_scan(void)
         }
 #   endif
 
+#ifdef MATRIX_KEY_INTERRUPT
+    start_waiting_for_key();
+#endif
+
     matrix_scan_quantum();
     return 1;
 }
@@ -410,3 +468,80 @@ static void unselect_cols(void)
 }
 
 #endif
+
+#ifdef MATRIX_KEY_INTERRUPT
+
+#if (DIODE_DIRECTION == COL2ROW)
+#   define INPUT_PINS   col_pins
+#   define INPUT_COUNT  MATRIX_COLS
+#   define OUTPUT_PINS  row_pins
+#   define OUTPUT_COUNT MATRIX_ROWS
+#   define unselect_outputs() unselect_rows()
+#else
+#   define INPUT_PINS   row_pins
+#   define INPUT_COUNT  MATRIX_ROWS
+#   define OUTPUT_PINS  col_pins
+#   define OUTPUT_COUNT MATRIX_COLS
+#   define unselect_outputs() unselect_cols()
+#endif
+
+/* only wakes the CPU, the scan reads the pins */
+EMPTY_INTERRUPT(PCINT0_vect);
+
+static void start_waiting_for_key(void)
+{
+#   if (DEBOUNCING_DELAY > 0)
+    if (debouncing) return;
+#   endif
+    for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
+        if (matrix[i] || matrix_debouncing[i]) return;
+    }
+
+    for (uint8_t x = 0; x < OUTPUT_COUNT; x++) {
+        uint8_t pin = OUTPUT_PINS[x];
+        _SFR_IO8((pin >> 4) + 1) |=  _BV(pin & 0xF); // OUT
+        _SFR_IO8((pin >> 4) + 2) &= ~_BV(pin & 0xF); // LOW
+    }
+    wait_us(30);
+    if (input_pcint_mask) {
+        PCMSK0 |= input_pcint_mask;
+        PCIFR = _BV(PCIF0);
+        PCICR |= _BV(PCIE0);
+    }
+    waiting_for_key = true;
+}
+
+static bool any_key_down(void)
+{
+    for (uint8_t x = 0; x < INPUT_COUNT; x++) {
+        uint8_t pin = INPUT_PINS[x];
+        if (!(_SFR_IO8(pin >> 4) & _BV(pin & 0xF))) return true;
+    }
+    return false;
+}
+
+static void sleep_until_key(void)
+{
+    if (!input_pcint_mask) return;
+    // a key going down after the check leaves the interrupt pending, which
+    // wakes the sleep straight away
+    cli();
+    if (!any_key_down()) {
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+    sei();
+}
+
+static void stop_waiting_for_key(void)
+{
+    PCICR &= ~_BV(PCIE0);
+    PCMSK0 &= ~input_pcint_mask;
+    unselect_outputs();
+    waiting_for_key = false;
+}
+
+#endif
@@ -16,61 +16,54 @@
 
 #include "process_chording.h"
 
-bool keys_chord(uint8_t keys[]) {
-  uint8_t keys_size = sizeof(keys)/sizeof(keys[0]);
-  bool pass = true;
-  uint8_t in = 0;
-  for (uint8_t i = 0; i < chord_key_count; i++) {
-    bool found = false;
-    for (uint8_t j = 0; j < keys_size; j++) {
-      if (chord_keys[i] == (keys[j] & 0xFF)) {
-        in++; // detects key in chord
-        found = true;
-        break;
-      }
+#if CHORD_COUNT > 0xFFFF
+#error "CHORD_COUNT must fit in 16 bits"
+#endif
+
+/* the keys of the chord so far, and the ones of them still held */
+static chord_mask_t chord = 0;
+static chord_mask_t chord_down = 0;
+
+__attribute__ ((weak))
+void chording_unmatched_user(chord_mask_t mask) {}
+
+static void chord_released(chord_mask_t mask) {
+#if CHORD_COUNT > 0
+  uint16_t low = 0;
+  uint16_t high = CHORD_COUNT;
+  while (low < high) {
+    uint16_t middle = low + (high - low) / 2;
+    chord_mask_t entry = pgm_read_dword(&chord_dictionary[middle].mask);
+    if (entry == mask) {
+      send_string(chord_dictionary[middle].output);
+      return;
     }
-    if (found)
-      continue;
-    if (chord_keys[i] != 0)  {
-      pass = false; // makes sure rest are blank
+    if (entry < mask) {
+      low = middle + 1;
+    } else {
+      high = middle;
     }
   }
-  return (pass && (in == keys_size));
+#endif
+  chording_unmatched_user(mask);
 }
 
 bool process_chording(uint16_t keycode, keyrecord_t *record) {
-  if (keycode >= QK_CHORDING && keycode <= QK_CHORDING_MAX) {
-    if (record->event.pressed) {
-      if (!chording) {
-        chording = true;
-        for (uint8_t i = 0; i < CHORDING_MAX; i++)
-          chord_keys[i] = 0;
-        chord_key_count = 0;
-        chord_key_down = 0;
-      }
-      chord_keys[chord_key_count] = (keycode & 0xFF);
-      chord_key_count++;
-      chord_key_down++;
-      return false;
-    } else {
-      if (chording) {
-        chord_key_down--;
-        if (chord_key_down == 0) {
-          chording = false;
-          // Chord Dictionary
-          if (keys_chord((uint8_t[]){KC_ENTER, KC_SPACE})) {
-            register_code(KC_A);
-            unregister_code(KC_A);
-            return false;
-          }
-          for (uint8_t i = 0; i < chord_key_count; i++) {
-            register_code(chord_keys[i]);
-            unregister_code(chord_keys[i]);
-            return false;
-          }
-        }
-      }
+  uint8_t index = keycode & 0xFF;
+  if (index >= sizeof(chord_mask_t) * 8) {
+    return true;
+  }
+  chord_mask_t key = CHORD_KEY(index);
+  if (record->event.pressed) {
+    chord |= key;
+    chord_down |= key;
+  } else if (chord_down & key) {
+    chord_down &= ~key;
+    if (!chord_down) {
+      chord_mask_t mask = chord;
+      chord = 0;
+      chord_released(mask);
     }
   }
-  return true;
+  return false;
 }
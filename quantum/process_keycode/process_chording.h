@@ -17,16 +17,44 @@
 #ifndef PROCESS_CHORDING_H
 #define PROCESS_CHORDING_H
 
+#include <stdint.h>
+#include "progmem.h"
 #include "quantum.h"
 
-// Chording stuff
-#define CHORDING_MAX 4
-bool chording = false;
+/* Chord keys are CH(0) to CH(31). Every key pressed before the last one is
+ * released makes up the chord, which is looked up by the mask of its keys in
+ * chord_dictionary. The dictionary lives in flash and is sorted by mask, so
+ * a lookup is a binary search however many chords there are.
+ */
+typedef uint32_t chord_mask_t;
+
+#define CH(n)        (QK_CHORDING | (n))
+#define CHORD_KEY(n) ((chord_mask_t)1 << (n))
+
+/* the longest output of a chord, including the terminating NUL */
+#ifndef CHORDING_OUTPUT_SIZE
+#define CHORDING_OUTPUT_SIZE 8
+#endif
+
+typedef struct {
+    chord_mask_t mask;
+    /* typed with send_string() */
+    char output[CHORDING_OUTPUT_SIZE];
+} chord_t;
 
-uint8_t chord_keys[CHORDING_MAX] = {0};
-uint8_t chord_key_count = 0;
-uint8_t chord_key_down = 0;
+#define CHORD(mask, output) {(mask), output}
+
+#ifndef CHORD_COUNT
+#define CHORD_COUNT 0
+#endif
+
+#if CHORD_COUNT > 0
+/* in ascending order of mask */
+extern const chord_t chord_dictionary[CHORD_COUNT] PROGMEM;
+#endif
 
 bool process_chording(uint16_t keycode, keyrecord_t *record);
+/* Called for a chord that isn't in the dictionary */
+void chording_unmatched_user(chord_mask_t mask);
 
 #endif
@@ -16,13 +16,11 @@
 
 #include "process_combo.h"
 #include "print.h"
-
-
-#define COMBO_TIMER_ELAPSED -1
+#include "telemetry.h"
 
 
 __attribute__ ((weak))
-combo_t key_combos[] = {
+combo_t key_combos[COMBO_COUNT] = {
 
 };
 
@@ -46,6 +44,27 @@ static inline void send_combo(uint16_t action, bool pressed)
     }
 }
 
+/* A combo key was held for longer than COMBO_TERM without completing the combo */
+static void combo_timeout(timer_wheel_entry_t *entry)
+{
+    combo_t *combo = TIMER_WHEEL_CONTAINER(entry, combo_t, timeout);
+    telemetry_record(TELEMETRY_COMBO, combo - key_combos, TELEMETRY_COMBO_TIMEOUT);
+
+    /* This disables the combo, meaning key events for this
+     * combo will be handled by the next processors in the chain 
+     */
+    combo->disabled = true;
+
+#ifdef COMBO_ALLOW_ACTION_KEYS
+    process_action(&combo->prev_record, 
+        store_or_get_action(combo->prev_record.event.pressed, 
+                            combo->prev_record.event.key));
+#else
+    unregister_code16(combo->prev_key);
+    register_code16(combo->prev_key);
+#endif
+}
+
 #define ALL_COMBO_KEYS_ARE_DOWN     (((1<<count)-1) == combo->state)
 #define NO_COMBO_KEYS_ARE_DOWN      (0 == combo->state)
 #define KEY_STATE_DOWN(key)         do{ combo->state |= (1<<key); } while(0)
@@ -64,18 +83,20 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
     /* Return if not a combo key */
     if (-1 == (int8_t)index) return false;
 
-    /* The combos timer is used to signal whether the combo is active */
-    bool is_combo_active = COMBO_TIMER_ELAPSED == combo->timer ? false : true;
+    bool is_combo_active = !combo->disabled;
 
     if (record->event.pressed) {
         KEY_STATE_DOWN(index);
 
         if (is_combo_active) {
             if (ALL_COMBO_KEYS_ARE_DOWN) { /* Combo was pressed */
+                telemetry_record(TELEMETRY_COMBO, current_combo_index, TELEMETRY_COMBO_FIRED);
                 send_combo(combo->keycode, true);
-                combo->timer = COMBO_TIMER_ELAPSED;
+                timer_wheel_cancel(&combo->timeout);
+                combo->disabled = true;
             } else { /* Combo key was pressed */
                 combo->timer = timer_read();
+                timer_wheel_schedule(&combo->timeout, COMBO_TERM, combo_timeout);
 #ifdef COMBO_ALLOW_ACTION_KEYS
                 combo->prev_record = *record;
 #else
@@ -95,18 +116,21 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
             record->event.pressed = false;
             process_action(record, store_or_get_action(record->event.pressed, record->event.key));
 #else
+            begin_keyboard_report();
             register_code16(keycode);
-            send_keyboard_report();
+            flush_keyboard_report();
             unregister_code16(keycode);
+            commit_keyboard_report();
 #endif
-            combo->timer = 0;            
+            timer_wheel_cancel(&combo->timeout);
         }
 
         KEY_STATE_UP(index);        
     }
 
     if (NO_COMBO_KEYS_ARE_DOWN) {
-        combo->timer = 0;
+        timer_wheel_cancel(&combo->timeout);
+        combo->disabled = false;
     }
 
     return is_combo_active;
@@ -123,28 +147,3 @@ bool process_combo(uint16_t keycode, keyrecord_t *record)
 
     return !is_combo_key;
 }
-
-void matrix_scan_combo(void)
-{
-    for (int i = 0; i < COMBO_COUNT; ++i) {
-        combo_t *combo = &key_combos[i];
-        if (combo->timer && 
-            combo->timer != COMBO_TIMER_ELAPSED && 
-            timer_elapsed(combo->timer) > COMBO_TERM) {
-            
-            /* This disables the combo, meaning key events for this
-             * combo will be handled by the next processors in the chain 
-             */
-            combo->timer = COMBO_TIMER_ELAPSED;
-
-#ifdef COMBO_ALLOW_ACTION_KEYS
-            process_action(&combo->prev_record, 
-                store_or_get_action(combo->prev_record.event.pressed, 
-                                    combo->prev_record.event.key));
-#else
-            unregister_code16(combo->prev_key);
-            register_code16(combo->prev_key);
-#endif
-        }
-    }
-}
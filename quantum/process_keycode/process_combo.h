@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include "progmem.h"
 #include "quantum.h"
+#include "action_tapping.h"
+#include "timer_wheel.h"
 
 typedef struct
 {
@@ -32,7 +34,12 @@ typedef struct
 #else
     uint8_t state;
 #endif
+    /* when the last combo key was pressed */
     uint16_t timer;
+    /* runs while a combo key is waiting for the rest of the combo */
+    timer_wheel_entry_t timeout;
+    /* timed out or fired, the keys go to the next processors until released */
+    bool disabled;
 #ifdef COMBO_ALLOW_ACTION_KEYS
     keyrecord_t prev_record;
 #else
@@ -53,7 +60,6 @@ typedef struct
 #endif
 
 bool process_combo(uint16_t keycode, keyrecord_t *record);
-void matrix_scan_combo(void);
 void process_combo_event(uint8_t combo_index, bool pressed);
 
 #endif
@@ -25,10 +25,20 @@ void leader_end(void) {}
 // Leader key stuff
 bool leading = false;
 uint16_t leader_time = 0;
+/* runs out LEADER_TIMEOUT after the leader key */
+static timer_wheel_entry_t leader_timer;
 
 uint16_t leader_sequence[5] = {0, 0, 0, 0, 0};
 uint8_t leader_sequence_size = 0;
 
+bool is_leader_on(void) {
+  return leading;
+}
+
+bool has_leader_timed_out(void) {
+  return !timer_wheel_scheduled(&leader_timer);
+}
+
 bool process_leader(uint16_t keycode, keyrecord_t *record) {
   // Leader key set-up
   if (record->event.pressed) {
@@ -36,6 +46,7 @@ bool process_leader(uint16_t keycode, keyrecord_t *record) {
       leader_start();
       leading = true;
       leader_time = timer_read();
+      timer_wheel_schedule(&leader_timer, LEADER_TIMEOUT, NULL);
       leader_sequence_size = 0;
       leader_sequence[0] = 0;
       leader_sequence[1] = 0;
@@ -44,7 +55,7 @@ bool process_leader(uint16_t keycode, keyrecord_t *record) {
       leader_sequence[4] = 0;
       return false;
     }
-    if (leading && timer_elapsed(leader_time) < LEADER_TIMEOUT) {
+    if (leading && !has_leader_timed_out()) {
       leader_sequence[leader_sequence_size] = keycode;
       leader_sequence_size++;
       return false;
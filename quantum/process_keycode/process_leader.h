@@ -21,6 +21,9 @@
 
 bool process_leader(uint16_t keycode, keyrecord_t *record);
 
+bool is_leader_on(void);
+bool has_leader_timed_out(void);
+
 void leader_start(void);
 void leader_end(void);
 
@@ -34,6 +37,6 @@ void leader_end(void);
 #define SEQ_FIVE_KEYS(key1, key2, key3, key4, key5) if (leader_sequence[0] == (key1) && leader_sequence[1] == (key2) && leader_sequence[2] == (key3) && leader_sequence[3] == (key4) && leader_sequence[4] == (key5))
 
 #define LEADER_EXTERNS() extern bool leading; extern uint16_t leader_time; extern uint16_t leader_sequence[5]; extern uint8_t leader_sequence_size
-#define LEADER_DICTIONARY() if (leading && timer_elapsed(leader_time) > LEADER_TIMEOUT)
+#define LEADER_DICTIONARY() if (leading && has_leader_timed_out())
 
 #endif
@@ -39,13 +39,14 @@ void process_midi_all_notes_off(void)
 
 #ifdef MIDI_ADVANCED
 
-#include "timer.h"
+#include "timer_wheel.h"
 
 static uint8_t tone_status[MIDI_TONE_COUNT];
 
 static uint8_t midi_modulation;
 static int8_t midi_modulation_step;
-static uint16_t midi_modulation_timer;
+/* runs every modulation interval while the modulation is changing */
+static timer_wheel_entry_t midi_modulation_timer;
 
 inline uint8_t compute_velocity(uint8_t setting)
 {
@@ -67,15 +68,11 @@ void midi_init(void)
 
     midi_modulation = 0;
     midi_modulation_step = 0;
-    midi_modulation_timer = 0;
+    timer_wheel_cancel(&midi_modulation_timer);
 }
 
-void midi_task(void)
+static void midi_modulation_tick(timer_wheel_entry_t *entry)
 {
-    if (timer_elapsed(midi_modulation_timer) < midi_config.modulation_interval)
-        return;
-    midi_modulation_timer = timer_read();
-
     if (midi_modulation_step != 0)
     {
         dprintf("midi modulation %d\n", midi_modulation);
@@ -91,6 +88,8 @@ void midi_task(void)
 
         if (midi_modulation > 127)
             midi_modulation = 127;
+
+        timer_wheel_schedule(entry, midi_config.modulation_interval, midi_modulation_tick);
     }
 }
 
@@ -227,6 +226,8 @@ bool process_midi(uint16_t keycode, keyrecord_t *record)
             return false;
         case MI_MOD:
             midi_modulation_step = record->event.pressed ? 1 : -1;
+            if (!timer_wheel_scheduled(&midi_modulation_timer))
+                timer_wheel_schedule(&midi_modulation_timer, midi_config.modulation_interval, midi_modulation_tick);
             return false;
         case MI_MODSD:
             if (record->event.pressed) {
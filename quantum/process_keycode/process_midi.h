@@ -42,7 +42,6 @@ typedef union {
 midi_config_t midi_config;
 
 void midi_init(void);
-void midi_task(void);
 bool process_midi(uint16_t keycode, keyrecord_t *record);
 
 #define MIDI_INVALID_NOTE 0xFF
@@ -23,4 +23,6 @@
 
 bool process_printer(uint16_t keycode, keyrecord_t *record);
 
+bool is_printer_on(void);
+
 #endif
@@ -56,6 +56,10 @@ void disable_printing() {
 	printing_enabled = false;
 }
 
+bool is_printer_on(void) {
+	return printing_enabled;
+}
+
 uint8_t shifted_numbers[10] = {0x21, 0x40, 0x23, 0x24, 0x25, 0x5E, 0x26, 0x2A, 0x28, 0x29};
 
 // uint8_t keycode_to_ascii[0xFF][2];
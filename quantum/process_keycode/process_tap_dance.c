@@ -72,6 +72,16 @@ static inline void process_tap_dance_action_on_reset (qk_tap_dance_action_t *act
   send_keyboard_report();
 }
 
+static void tap_dance_timeout (timer_wheel_entry_t *entry) {
+  qk_tap_dance_state_t *state = TIMER_WHEEL_CONTAINER(entry, qk_tap_dance_state_t, timeout);
+  qk_tap_dance_action_t *action = TIMER_WHEEL_CONTAINER(state, qk_tap_dance_action_t, state);
+
+  if (state->count) {
+    process_tap_dance_action_on_dance_finished (action);
+    reset_tap_dance (state);
+  }
+}
+
 bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
   uint16_t idx = keycode - QK_TAP_DANCE;
   qk_tap_dance_action_t *action;
@@ -91,6 +101,9 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
       action->state.keycode = keycode;
       action->state.count++;
       action->state.timer = timer_read();
+      timer_wheel_schedule (&action->state.timeout,
+                            action->custom_tapping_term > 0 ? action->custom_tapping_term : TAPPING_TERM,
+                            tap_dance_timeout);
       action->state.oneshot_mods = get_oneshot_mods();
       process_tap_dance_action_on_each_tap (action);
 
@@ -102,6 +115,9 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
       }
 
       last_td = keycode;
+    } else if (action->state.count && !timer_wheel_scheduled (&action->state.timeout)) {
+      // the dance timed out while the key was held
+      reset_tap_dance (&action->state);
     }
 
     break;
@@ -128,27 +144,6 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 }
 
 
-
-void matrix_scan_tap_dance () {
-  if (highest_td == -1)
-    return;
-  uint16_t tap_user_defined;
-
-for (uint8_t i = 0; i <= highest_td; i++) {
-    qk_tap_dance_action_t *action = &tap_dance_actions[i];
-    if(action->custom_tapping_term > 0 ) {
-      tap_user_defined = action->custom_tapping_term;
-    }
-    else{
-      tap_user_defined = TAPPING_TERM;
-    }
-    if (action->state.count && timer_elapsed (action->state.timer) > tap_user_defined) {
-      process_tap_dance_action_on_dance_finished (action);
-      reset_tap_dance (&action->state);
-    }
-  }
-}
-
 void reset_tap_dance (qk_tap_dance_state_t *state) {
   qk_tap_dance_action_t *action;
 
@@ -158,6 +153,7 @@ void reset_tap_dance (qk_tap_dance_state_t *state) {
   action = &tap_dance_actions[state->keycode - QK_TAP_DANCE];
 
   process_tap_dance_action_on_reset (action);
+  timer_wheel_cancel (&state->timeout);
 
   state->count = 0;
   state->interrupted = false;
@@ -20,6 +20,7 @@
 
 #include <stdbool.h>
 #include <inttypes.h>
+#include "timer_wheel.h"
 
 typedef struct
 {
@@ -27,6 +28,7 @@ typedef struct
   uint8_t oneshot_mods;
   uint16_t keycode;
   uint16_t timer;
+  timer_wheel_entry_t timeout;
   bool interrupted;
   bool pressed;
   bool finished;
@@ -80,7 +82,6 @@ extern qk_tap_dance_action_t tap_dance_actions[];
 /* To be used internally */
 
 bool process_tap_dance(uint16_t keycode, keyrecord_t *record);
-void matrix_scan_tap_dance (void);
 void reset_tap_dance (qk_tap_dance_state_t *state);
 
 void qk_tap_dance_pair_finished (qk_tap_dance_state_t *state, void *user_data);
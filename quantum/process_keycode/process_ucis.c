@@ -18,6 +18,10 @@
 
 qk_ucis_state_t qk_ucis_state;
 
+bool is_ucis_on(void) {
+  return qk_ucis_state.in_progress;
+}
+
 void qk_ucis_start(void) {
   qk_ucis_state.count = 0;
   qk_ucis_state.in_progress = true;
@@ -43,6 +43,7 @@ extern qk_ucis_state_t qk_ucis_state;
 extern const qk_ucis_symbol_t ucis_symbol_table[];
 
 void qk_ucis_start(void);
+bool is_ucis_on(void);
 void qk_ucis_start_user(void);
 void qk_ucis_symbol_fallback (void);
 void register_ucis(const char *hex);
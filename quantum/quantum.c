@@ -80,21 +80,25 @@ static inline void qk_unregister_mods(uint8_t kc) {
 }
 
 void register_code16 (uint16_t code) {
+  begin_keyboard_report();
   if (IS_MOD(code) || code == KC_NO) {
       do_code16 (code, qk_register_mods);
   } else {
       do_code16 (code, qk_register_weak_mods);
   }
   register_code (code);
+  commit_keyboard_report();
 }
 
 void unregister_code16 (uint16_t code) {
+  begin_keyboard_report();
   unregister_code (code);
   if (IS_MOD(code) || code == KC_NO) {
       do_code16 (code, qk_unregister_mods);
   } else {
       do_code16 (code, qk_unregister_weak_mods);
   }
+  commit_keyboard_report();
 }
 
 __attribute__ ((weak))
@@ -119,6 +123,9 @@ void reset_keyboard(void) {
   shutdown_user();
 #endif
   wait_ms(250);
+#ifdef EECONFIG_CACHE_ENABLE
+  eeconfig_flush();
+#endif
 #ifdef CATERINA_BOOTLOADER
   *(uint16_t *)0x0800 = 0x7777; // these two are a-star-specific
 #endif
@@ -134,6 +141,64 @@ void reset_keyboard(void) {
   #define RSPC_KEY KC_0
 #endif
 
+/* Keycode processors
+ *
+ * The features are called in this order until one of them returns false,
+ * but only for the keycodes in their range, or while their on() function
+ * says that they want to see every key. Features that look at every key all
+ * of the time cover the whole range.
+ */
+typedef struct {
+  bool (*process)(uint16_t keycode, keyrecord_t *record);
+  bool (*on)(void);
+  uint16_t min;
+  uint16_t max;
+} keycode_processor_t;
+
+#define EVERY_KEYCODE 0x0000, 0xFFFF
+#define NO_KEYCODE    0xFFFF, 0x0000
+
+static const keycode_processor_t keycode_processors[] = {
+#if defined(MIDI_ENABLE) && defined(MIDI_ADVANCED)
+  { process_midi,        NULL,           MIDI_TONE_MIN, MI_MODSU },
+#endif
+#ifdef AUDIO_ENABLE
+  { process_audio,       NULL,           AU_ON, MUV_DE },
+#endif
+#if defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))
+  { process_music,       is_music_on,    MU_ON, MU_TOG },
+#endif
+#ifdef TAP_DANCE_ENABLE
+  // Any other key interrupts the dance
+  { process_tap_dance,   NULL,           EVERY_KEYCODE },
+#endif
+#ifndef DISABLE_LEADER
+  { process_leader,      is_leader_on,   KC_LEAD, KC_LEAD },
+#endif
+#ifdef CHORDING_ENABLE
+  { process_chording,    NULL,           QK_CHORDING, QK_CHORDING_MAX },
+#endif
+#ifdef COMBO_ENABLE
+  { process_combo,       NULL,           EVERY_KEYCODE },
+#endif
+#ifdef UNICODE_ENABLE
+  { process_unicode,     NULL,           QK_UNICODE + 1, QK_UNICODE_MAX },
+#endif
+#ifdef UCIS_ENABLE
+  { process_ucis,        is_ucis_on,     NO_KEYCODE },
+#endif
+#ifdef PRINTING_ENABLE
+  { process_printer,     is_printer_on,  PRINT_ON, PRINT_OFF },
+#endif
+#ifdef UNICODEMAP_ENABLE
+  { process_unicode_map, NULL,           QK_UNICODE_MAP, 0xFFFF },
+#endif
+  // Keeps the array from being empty
+  { NULL,                NULL,           NO_KEYCODE },
+};
+
+#define KEYCODE_PROCESSOR_COUNT (sizeof(keycode_processors) / sizeof(keycode_processors[0]) - 1)
+
 static bool shift_interrupted[2] = {0, 0};
 static uint16_t scs_timer[2] = {0, 0};
 
@@ -143,6 +208,10 @@ bool process_record_quantum(keyrecord_t *record) {
   keypos_t key = record->event.key;
   uint16_t keycode;
 
+  #ifdef DYNAMIC_KEYMAP_ENABLE
+    dynamic_keymap_record(key, record->event.pressed);
+  #endif
+
   #if !defined(NO_ACTION_LAYER) && defined(PREVENT_STUCK_MODIFIERS)
     /* TODO: Use store_or_get_action() or a similar function. */
     if (!disable_action_cache) {
@@ -167,45 +236,18 @@ bool process_record_quantum(keyrecord_t *record) {
     //   return false;
     // }
 
-  if (!(
-    process_record_kb(keycode, record) &&
-  #if defined(MIDI_ENABLE) && defined(MIDI_ADVANCED)
-    process_midi(keycode, record) &&
-  #endif
-  #ifdef AUDIO_ENABLE
-    process_audio(keycode, record) &&
-  #endif
-  #if defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))
-    process_music(keycode, record) &&
-  #endif
-  #ifdef TAP_DANCE_ENABLE
-    process_tap_dance(keycode, record) &&
-  #endif
-  #ifndef DISABLE_LEADER
-    process_leader(keycode, record) &&
-  #endif
-  #ifndef DISABLE_CHORDING
-    process_chording(keycode, record) &&
-  #endif
-  #ifdef COMBO_ENABLE
-    process_combo(keycode, record) &&
-  #endif
-  #ifdef UNICODE_ENABLE
-    process_unicode(keycode, record) &&
-  #endif
-  #ifdef UCIS_ENABLE
-    process_ucis(keycode, record) &&
-  #endif
-  #ifdef PRINTING_ENABLE
-    process_printer(keycode, record) &&
-  #endif
-  #ifdef UNICODEMAP_ENABLE
-    process_unicode_map(keycode, record) &&
-  #endif
-      true)) {
+  if (!process_record_kb(keycode, record)) {
     return false;
   }
 
+  for (const keycode_processor_t *p = keycode_processors; p < keycode_processors + KEYCODE_PROCESSOR_COUNT; p++) {
+    if ((keycode >= p->min && keycode <= p->max) || (p->on && p->on())) {
+      if (!p->process(keycode, record)) {
+        return false;
+      }
+    }
+  }
+
   // Shift / paren setup
 
   switch(keycode) {
@@ -405,11 +447,14 @@ bool process_record_quantum(keyrecord_t *record) {
             shift_interrupted[1] = true;
           }
         #endif
+        begin_keyboard_report();
         if (!shift_interrupted[0] && timer_elapsed(scs_timer[0]) < TAPPING_TERM) {
           register_code(LSPO_KEY);
+          flush_keyboard_report();
           unregister_code(LSPO_KEY);
         }
         unregister_mods(MOD_BIT(KC_LSFT));
+        commit_keyboard_report();
       }
       return false;
       // break;
@@ -428,11 +473,14 @@ bool process_record_quantum(keyrecord_t *record) {
             shift_interrupted[1] = true;
           }
         #endif
+        begin_keyboard_report();
         if (!shift_interrupted[1] && timer_elapsed(scs_timer[1]) < TAPPING_TERM) {
           register_code(RSPC_KEY);
+          flush_keyboard_report();
           unregister_code(RSPC_KEY);
         }
         unregister_mods(MOD_BIT(KC_RSFT));
+        commit_keyboard_report();
       }
       return false;
       // break;
@@ -536,16 +584,21 @@ void send_string(const char *str) {
           shift = !!( pgm_read_word(&ascii_to_shift_lut[hi]) & (0x8000u>>lo) );
         }
 
+        // shift goes down and up together with the key
+        begin_keyboard_report();
         if (shift) {
             register_code(KC_LSFT);
             register_code(keycode);
+            flush_keyboard_report();
             unregister_code(keycode);
             unregister_code(KC_LSFT);
         }
         else {
             register_code(keycode);
+            flush_keyboard_report();
             unregister_code(keycode);
         }
+        commit_keyboard_report();
         ++str;
     }
 }
@@ -595,16 +648,21 @@ void send_string(const char *str) {
         uint8_t ascii_code = pgm_read_byte(str);
         if (!ascii_code) break;
         keycode = pgm_read_byte(&ascii_to_qwerty_keycode_lut[ascii_code]);
+        // shift goes down and up together with the key
+        begin_keyboard_report();
         if (pgm_read_byte(&ascii_to_qwerty_shift_lut[ascii_code])) {
             register_code(KC_LSFT);
             register_code(keycode);
+            flush_keyboard_report();
             unregister_code(keycode);
             unregister_code(KC_LSFT);
         }
         else {
             register_code(keycode);
+            flush_keyboard_report();
             unregister_code(keycode);
         }
+        commit_keyboard_report();
         ++str;
     }
 }
@@ -705,6 +763,9 @@ void matrix_init_quantum() {
   #ifdef BACKLIGHT_ENABLE
     backlight_init_ports();
   #endif
+  #ifdef DYNAMIC_KEYMAP_ENABLE
+    dynamic_keymap_init();
+  #endif
   matrix_init_kb();
 }
 
@@ -713,12 +774,8 @@ void matrix_scan_quantum() {
     matrix_scan_music();
   #endif
 
-  #ifdef TAP_DANCE_ENABLE
-    matrix_scan_tap_dance();
-  #endif
-
-  #ifdef COMBO_ENABLE
-    matrix_scan_combo();
+  #ifdef DYNAMIC_KEYMAP_ENABLE
+    dynamic_keymap_task();
   #endif
 
   #if defined(BACKLIGHT_ENABLE) && defined(BACKLIGHT_PIN)
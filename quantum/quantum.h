@@ -35,6 +35,7 @@
 #include <stddef.h>
 #include "bootloader.h"
 #include "timer.h"
+#include "timer_wheel.h"
 #include "config_common.h"
 #include "led.h"
 #include "action_util.h"
@@ -67,8 +68,7 @@ extern uint32_t default_layer_state;
 	#include "process_leader.h"
 #endif
 
-#define DISABLE_CHORDING
-#ifndef DISABLE_CHORDING
+#ifdef CHORDING_ENABLE
 	#include "process_chording.h"
 #endif
 
@@ -94,6 +94,10 @@ extern uint32_t default_layer_state;
 	#include "process_combo.h"
 #endif
 
+#ifdef DYNAMIC_KEYMAP_ENABLE
+	#include "dynamic_keymap.h"
+#endif
+
 #define SEND_STRING(str) send_string(PSTR(str))
 void send_string(const char *str);
 
@@ -18,6 +18,7 @@
 #include <util/delay.h>
 #include "progmem.h"
 #include "timer.h"
+#include "timer_wheel.h"
 #include "rgblight.h"
 #include "debug.h"
 #include "led_tables.h"
@@ -102,10 +103,10 @@ void setrgb(uint8_t r, uint8_t g, uint8_t b, LED_TYPE *led1) {
 
 
 uint32_t eeconfig_read_rgblight(void) {
-  return eeprom_read_dword(EECONFIG_RGBLIGHT);
+  return eeconfig_read_dword(EECONFIG_RGBLIGHT);
 }
 void eeconfig_update_rgblight(uint32_t val) {
-  eeprom_update_dword(EECONFIG_RGBLIGHT, val);
+  eeconfig_update_dword(EECONFIG_RGBLIGHT, val);
 }
 void eeconfig_update_rgblight_default(void) {
   dprintf("eeconfig_update_rgblight_default\n");
@@ -388,6 +389,36 @@ void rgblight_set(void) {
 
 #ifdef RGBLIGHT_ANIMATIONS
 
+/* steps the animation every interval of the current effect */
+static timer_wheel_entry_t rgblight_animation_timer;
+
+/* milliseconds between the steps of the current effect, 0 if it isn't animated */
+static uint16_t rgblight_effect_interval(void) {
+  uint8_t mode = rgblight_config.mode;
+  if (mode >= 2 && mode <= 5) {
+    return pgm_read_byte(&RGBLED_BREATHING_INTERVALS[mode - 2]);
+  } else if (mode >= 6 && mode <= 8) {
+    return pgm_read_byte(&RGBLED_RAINBOW_MOOD_INTERVALS[mode - 6]);
+  } else if (mode >= 9 && mode <= 14) {
+    return pgm_read_byte(&RGBLED_RAINBOW_MOOD_INTERVALS[(mode - 9) / 2]);
+  } else if (mode >= 15 && mode <= 20) {
+    return pgm_read_byte(&RGBLED_SNAKE_INTERVALS[(mode - 15) / 2]);
+  } else if (mode >= 21 && mode <= 23) {
+    return pgm_read_byte(&RGBLED_KNIGHT_INTERVALS[mode - 21]);
+  } else if (mode == 24) {
+    return RGBLIGHT_EFFECT_CHRISTMAS_INTERVAL;
+  }
+  return 0;
+}
+
+static void rgblight_animation_tick(timer_wheel_entry_t *entry) {
+  rgblight_task();
+  uint16_t interval = rgblight_effect_interval();
+  if (rgblight_timer_enabled && interval) {
+    timer_wheel_schedule(entry, interval, rgblight_animation_tick);
+  }
+}
+
 // Animation timer -- AVR Timer3
 void rgblight_timer_init(void) {
   // static uint8_t rgblight_timer_is_init = 0;
@@ -406,17 +437,23 @@ void rgblight_timer_init(void) {
   // SREG = sreg;
 
   rgblight_timer_enabled = true;
+  timer_wheel_schedule(&rgblight_animation_timer, 0, rgblight_animation_tick);
 }
 void rgblight_timer_enable(void) {
   rgblight_timer_enabled = true;
+  timer_wheel_schedule(&rgblight_animation_timer, 0, rgblight_animation_tick);
   dprintf("TIMER3 enabled.\n");
 }
 void rgblight_timer_disable(void) {
   rgblight_timer_enabled = false;
+  timer_wheel_cancel(&rgblight_animation_timer);
   dprintf("TIMER3 disabled.\n");
 }
 void rgblight_timer_toggle(void) {
   rgblight_timer_enabled ^= rgblight_timer_enabled;
+  if (!rgblight_timer_enabled) {
+    timer_wheel_cancel(&rgblight_animation_timer);
+  }
   dprintf("TIMER3 toggled.\n");
 }
 
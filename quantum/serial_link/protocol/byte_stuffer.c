@@ -26,6 +26,7 @@ SOFTWARE.
 #include "serial_link/protocol/frame_validator.h"
 #include "serial_link/protocol/physical.h"
 #include <stdbool.h>
+#include <string.h>
 
 // This implements the "Consistent overhead byte stuffing protocol"
 // https://en.wikipedia.org/wiki/Consistent_Overhead_Byte_Stuffing
@@ -102,6 +103,39 @@ void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
     }
 }
 
+void byte_stuffer_recv(uint8_t link, const uint8_t* data, uint16_t size) {
+    byte_stuffer_state_t* state = &states[link];
+    const uint8_t* end = data + size;
+    while (data < end) {
+        // The bytes before the end of the block are data as long as they
+        // aren't zero, so they are copied in one go. The rest is handled a
+        // byte at a time, which gives exactly the same result.
+        uint16_t run = 0;
+        if (state->next_zero > 1) {
+            run = state->next_zero - 1;
+            if (run > (uint16_t)(end - data)) {
+                run = end - data;
+            }
+            if (run > MAX_FRAME_SIZE - state->data_pos) {
+                run = MAX_FRAME_SIZE - state->data_pos;
+            }
+            const uint8_t* zero = (const uint8_t*)memchr(data, 0, run);
+            if (zero) {
+                run = zero - data;
+            }
+        }
+        if (run > 0) {
+            memcpy(state->data + state->data_pos, data, run);
+            state->data_pos += run;
+            state->next_zero -= run;
+            data += run;
+        }
+        else {
+            byte_stuffer_recv_byte(link, *data++);
+        }
+    }
+}
+
 static void send_block(uint8_t link, uint8_t* start, uint8_t* end, uint8_t num_non_zero) {
     send_data(link, &num_non_zero, 1);
     if (end > start) {
@@ -32,6 +32,10 @@ void router_set_master(bool master) {
    is_master = master;
 }
 
+bool router_is_master(void) {
+    return is_master;
+}
+
 void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size){
     if (is_master) {
         if (link == DOWN_LINK) {
@@ -25,14 +25,43 @@ SOFTWARE.
 #include "serial_link/protocol/transport.h"
 #include "serial_link/protocol/frame_router.h"
 #include "serial_link/protocol/triple_buffered_object.h"
+#include "timer.h"
 #include <string.h>
 
 #define MAX_REMOTE_OBJECTS 16
 static remote_object_t* remote_objects[MAX_REMOTE_OBJECTS];
 static uint32_t num_remote_objects = 0;
 
+#define WINDOW_MASK (TRANSPORT_WINDOW - 1)
+
+typedef struct {
+    uint8_t id;
+    bool acked;
+    // when it was last sent, compared with the other frames to the same node
+    uint16_t order;
+    uint32_t time;
+} transport_frame_t;
+
+// The link to one node, 0 is the master and 1 to NUM_SLAVES are the slaves
+typedef struct {
+    // Frames sent to the node
+    uint8_t base;       // the oldest frame not acknowledged
+    uint8_t next;       // the sequence number of the next new frame
+    uint16_t order;
+    transport_frame_t window[TRANSPORT_WINDOW];
+    // Frames received from the node
+    uint8_t expected;   // every frame before this one has arrived
+    uint8_t received;   // bit i: frame expected + i has arrived
+    bool ack_pending;
+} transport_link_t;
+
+static transport_link_t links[NUM_SLAVES + 1];
+static transport_stats_t stats;
+
 void reinitialize_serial_link_transport(void) {
     num_remote_objects = 0;
+    memset(links, 0, sizeof(links));
+    memset(&stats, 0, sizeof(stats));
 }
 
 void add_remote_objects(remote_object_t** _remote_objects, uint32_t _num_remote_objects) {
@@ -73,56 +102,244 @@ void add_remote_objects(remote_object_t** _remote_objects, uint32_t _num_remote_
     }
 }
 
+// The buffer of the frames from this node to the given one
+static triple_buffer_object_t* local_object(remote_object_t* obj, uint8_t node) {
+    uint8_t* start = obj->buffer;
+    if (obj->object_type == MASTER_TO_SINGLE_SLAVE) {
+        start += (node - 1) * LOCAL_OBJECT_SIZE(obj->object_size);
+    }
+    return (triple_buffer_object_t*)start;
+}
+
+// The router takes a bitmask of the slaves a frame goes down to, where bit 0
+// is the slave next to the master. The slaves pass on the frames that aren't
+// for them, acks included.
+static uint8_t router_destination(uint8_t node) {
+    return node == 0 ? 0 : 1 << (node - 1);
+}
+
+// The master only reaches the slaves, and a slave only the master
+static bool link_reachable(uint8_t node, bool master) {
+    return master ? node != 0 : node == 0;
+}
+
+static void send_frame(uint8_t destination, uint8_t id, uint8_t* ptr, uint8_t sequence) {
+    remote_object_t* obj = remote_objects[id];
+    ptr[obj->object_size] = sequence;
+    ptr[obj->object_size + 1] = id;
+    router_send_frame(destination, ptr, obj->object_size + 2);
+}
+
+// Sends the frame with the newest state of its object, which is what was read
+// from the triple buffer last
+static void transmit(uint8_t node, uint8_t sequence) {
+    transport_link_t* link = &links[node];
+    transport_frame_t* frame = &link->window[sequence & WINDOW_MASK];
+    remote_object_t* obj = remote_objects[frame->id];
+    uint8_t* ptr = (uint8_t*)triple_buffer_last_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, local_object(obj, node));
+    frame->order = link->order++;
+    frame->time = timer_read32();
+    send_frame(router_destination(node), frame->id, ptr, sequence);
+}
+
+static void retransmit(uint8_t node, uint8_t sequence) {
+    stats.retransmitted++;
+    transmit(node, sequence);
+}
+
+static void send_object(uint8_t node, uint8_t id) {
+    transport_link_t* link = &links[node];
+    if ((uint8_t)(link->next - link->base) == TRANSPORT_WINDOW) {
+        // the change stays in the triple buffer until the window opens
+        return;
+    }
+    remote_object_t* obj = remote_objects[id];
+    if (triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, local_object(obj, node))) {
+        uint8_t sequence = link->next++;
+        transport_frame_t* frame = &link->window[sequence & WINDOW_MASK];
+        frame->id = id;
+        frame->acked = false;
+        stats.sent++;
+        transmit(node, sequence);
+    }
+}
+
+static void recv_sequence(uint8_t node, uint8_t sequence) {
+    transport_link_t* link = &links[node];
+    uint8_t offset = sequence - link->expected;
+    if (offset < TRANSPORT_WINDOW) {
+        link->received |= 1 << offset;
+        while (link->received & 1) {
+            link->received >>= 1;
+            link->expected++;
+        }
+    }
+    else if (offset < 128) {
+        // The sender is further ahead than its window, so it was restarted
+        // or this node was
+        link->expected = sequence + 1;
+        link->received = 0;
+    }
+    // Anything else is a frame that was sent again because the ack was lost.
+    // The data is used in every case, frames are never reordered, so it's
+    // always newer than what came before.
+    link->ack_pending = true;
+}
+
+static void recv_ack(uint8_t node, uint8_t expected, uint8_t received) {
+    transport_link_t* link = &links[node];
+    uint8_t in_flight = link->next - link->base;
+    uint8_t i;
+    stats.acks++;
+    if ((uint8_t)(expected - link->base) > in_flight) {
+        // The node has lost track of the sequence numbers, so number the
+        // frames in flight from where it expects them and send them again
+        transport_frame_t window[TRANSPORT_WINDOW];
+        for (i = 0; i < in_flight; i++) {
+            window[i] = link->window[(link->base + i) & WINDOW_MASK];
+        }
+        for (i = 0; i < in_flight; i++) {
+            link->window[(expected + i) & WINDOW_MASK] = window[i];
+        }
+        link->base = expected;
+        link->next = expected + in_flight;
+        for (i = 0; i < in_flight; i++) {
+            retransmit(node, link->base + i);
+        }
+        return;
+    }
+
+    bool any_acked = false;
+    uint16_t newest = 0;
+    for (i = 0; i < in_flight; i++) {
+        uint8_t sequence = link->base + i;
+        transport_frame_t* frame = &link->window[sequence & WINDOW_MASK];
+        int8_t offset = sequence - expected;
+        if (offset < 0 || (received >> offset) & 1) {
+            frame->acked = true;
+            if (!any_acked || (int16_t)(frame->order - newest) > 0) {
+                newest = frame->order;
+            }
+            any_acked = true;
+        }
+    }
+    // The link doesn't reorder frames, so any frame sent before one that
+    // arrived is lost
+    for (i = 0; i < in_flight && any_acked; i++) {
+        uint8_t sequence = link->base + i;
+        transport_frame_t* frame = &link->window[sequence & WINDOW_MASK];
+        if (!frame->acked && (int16_t)(frame->order - newest) < 0) {
+            retransmit(node, sequence);
+        }
+    }
+    while (link->base != link->next && link->window[link->base & WINDOW_MASK].acked) {
+        link->base++;
+    }
+}
+
 void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size) {
+    if (size < 2) {
+        return;
+    }
     uint8_t id = data[size-1];
+    if (id == TRANSPORT_ACK_ID) {
+        if (size == 3 && from <= NUM_SLAVES) {
+            recv_ack(from, data[0], data[1]);
+        }
+        return;
+    }
     if (id < num_remote_objects) {
         remote_object_t* obj = remote_objects[id];
-        if (obj->object_size == size - 1) {
+        if (obj->object_size == size - 2) {
             uint8_t* start;
             if (obj->object_type == MASTER_TO_ALL_SLAVES) {
                 start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
             }
             else if(obj->object_type == SLAVE_TO_MASTER) {
+                if (from == 0 || from > NUM_SLAVES) {
+                    return;
+                }
                 start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
                 start += (from - 1) * REMOTE_OBJECT_SIZE(obj->object_size);
+                recv_sequence(from, data[size-2]);
             }
             else {
                 start = obj->buffer + NUM_SLAVES * LOCAL_OBJECT_SIZE(obj->object_size);
+                recv_sequence(0, data[size-2]);
             }
             triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
             void* ptr = triple_buffer_begin_write_internal(obj->object_size, tb);
-            memcpy(ptr, data, size - 1);
+            memcpy(ptr, data, obj->object_size);
             triple_buffer_end_write_internal(tb);
         }
     }
 }
 
 void update_transport(void) {
+    // Only send what the router would pass on
+    bool master = router_is_master();
     unsigned int i;
     for(i=0;i<num_remote_objects;i++) {
         remote_object_t* obj = remote_objects[i];
-        if (obj->object_type == MASTER_TO_ALL_SLAVES || obj->object_type == SLAVE_TO_MASTER) {
-            triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer;
-            uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
-            if (ptr) {
-                ptr[obj->object_size] = i;
-                uint8_t dest = obj->object_type == MASTER_TO_ALL_SLAVES ? 0xFF : 0;
-                router_send_frame(dest, ptr, obj->object_size + 1);
+        if (obj->object_type == MASTER_TO_ALL_SLAVES) {
+            if (master) {
+                triple_buffer_object_t* tb = local_object(obj, 0xFF);
+                uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
+                if (ptr) {
+                    send_frame(0xFF, i, ptr, 0);
+                }
             }
         }
-        else {
-            uint8_t* start = obj->buffer;
+        else if (obj->object_type == SLAVE_TO_MASTER) {
+            if (!master) {
+                send_object(0, i);
+            }
+        }
+        else if (master) {
             unsigned int j;
             for (j=0;j<NUM_SLAVES;j++) {
-                triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
-                uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
-                if (ptr) {
-                    ptr[obj->object_size] = i;
-                    uint8_t dest = j + 1;
-                    router_send_frame(dest, ptr, obj->object_size + 1);
-                }
-                start += LOCAL_OBJECT_SIZE(obj->object_size);
+                send_object(j + 1, i);
             }
         }
     }
+
+    uint32_t now = timer_read32();
+    for (i=0;i<=NUM_SLAVES;i++) {
+        transport_link_t* link = &links[i];
+        if (!link_reachable(i, master)) {
+            // Left from before this node changed roles. The router would
+            // drop the frames, so there is nothing to wait for.
+            link->base = link->next;
+            link->ack_pending = false;
+            continue;
+        }
+        uint8_t sequence;
+        for (sequence = link->base; sequence != link->next; sequence++) {
+            transport_frame_t* frame = &link->window[sequence & WINDOW_MASK];
+            if (!frame->acked && now - frame->time >= TRANSPORT_RETRANSMIT_TIMEOUT) {
+                retransmit(i, sequence);
+            }
+        }
+        if (link->ack_pending) {
+            // room for the router and the validator
+            uint8_t ack[3 + 5] = {link->expected, link->received, TRANSPORT_ACK_ID};
+            link->ack_pending = false;
+            router_send_frame(router_destination(i), ack, 3);
+        }
+    }
+}
+
+bool transport_waiting_for_ack(void) {
+    bool master = router_is_master();
+    unsigned int i;
+    for (i=0;i<=NUM_SLAVES;i++) {
+        if (link_reachable(i, master) && links[i].base != links[i].next) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const transport_stats_t* transport_stats(void) {
+    return &stats;
 }
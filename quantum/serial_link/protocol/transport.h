@@ -31,6 +31,29 @@ SOFTWARE.
 #define NUM_SLAVES 8
 #define LOCAL_OBJECT_EXTRA 16
 
+// Frames to a single node carry a sequence number, and the node acknowledges
+// them. A frame is sent again as soon as an ack shows that a later one
+// arrived without it, or when no ack came within TRANSPORT_RETRANSMIT_TIMEOUT
+// milliseconds. Frames to all slaves are not acknowledged.
+
+// Frames in flight to each node, at most 8. Further changes wait in the triple
+// buffer, so only the newest state is sent once the window opens. 4 matrix
+// frames fit in the 128 byte serial queues of the Infinity ErgoDox.
+#ifndef TRANSPORT_WINDOW
+#define TRANSPORT_WINDOW 4
+#endif
+
+#if TRANSPORT_WINDOW > 8 || TRANSPORT_WINDOW & (TRANSPORT_WINDOW - 1)
+#error "TRANSPORT_WINDOW must be a power of two, at most 8"
+#endif
+
+#ifndef TRANSPORT_RETRANSMIT_TIMEOUT
+#define TRANSPORT_RETRANSMIT_TIMEOUT 2
+#endif
+
+// The object id of ack frames
+#define TRANSPORT_ACK_ID 0xFF
+
 // master -> slave = 1 local(target all), 1 remote object
 // slave -> master = 1 local(target 0), multiple remote objects
 // master -> single slave (multiple local, target id), 1 remote object
@@ -43,7 +66,9 @@ typedef enum {
 typedef struct {
     remote_object_type object_type;
     uint16_t object_size;
-    uint8_t buffer[] __attribute__((aligned(4)));
+    // zero length rather than flexible, as it's followed by the storage in
+    // the REMOTE_OBJECT_HELPER struct, which C++ doesn't allow otherwise
+    uint8_t buffer[0] __attribute__((aligned(4)));
 } remote_object_t;
 
 #define REMOTE_OBJECT_SIZE(objectsize) \
@@ -148,5 +173,16 @@ void add_remote_objects(remote_object_t** remote_objects, uint32_t num_remote_ob
 void reinitialize_serial_link_transport(void);
 void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size);
 void update_transport(void);
+// True while frames are waiting for an ack, update_transport() should then be
+// called again within TRANSPORT_RETRANSMIT_TIMEOUT
+bool transport_waiting_for_ack(void);
+
+typedef struct {
+    uint32_t sent;          // frames sent for the first time
+    uint32_t retransmitted; // frames sent again
+    uint32_t acks;          // ack frames received
+} transport_stats_t;
+
+const transport_stats_t* transport_stats(void);
 
 #endif
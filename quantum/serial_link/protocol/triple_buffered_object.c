@@ -62,6 +62,12 @@ void* triple_buffer_read_internal(uint16_t object_size, triple_buffer_object_t*
     }
 }
 
+void* triple_buffer_last_read_internal(uint16_t object_size, triple_buffer_object_t* object) {
+    // only the reader changes the read index
+    uint8_t read_index = GET_READ_INDEX();
+    return object->buffer + object_size * read_index;
+}
+
 void* triple_buffer_begin_write_internal(uint16_t object_size, triple_buffer_object_t* object) {
     uint8_t write_index = GET_WRITE_INDEX();
     return object->buffer + object_size * write_index;
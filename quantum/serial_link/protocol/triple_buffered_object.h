@@ -46,6 +46,8 @@ void triple_buffer_init(triple_buffer_object_t* object);
 void* triple_buffer_begin_write_internal(uint16_t object_size, triple_buffer_object_t* object);
 void triple_buffer_end_write_internal(triple_buffer_object_t* object);
 void* triple_buffer_read_internal(uint16_t object_size, triple_buffer_object_t* object);
+// The buffer returned by the last read, it stays valid until the next read
+void* triple_buffer_last_read_internal(uint16_t object_size, triple_buffer_object_t* object);
 
 
 #endif
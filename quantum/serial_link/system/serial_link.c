@@ -32,6 +32,9 @@ SOFTWARE.
 #include <stdbool.h>
 #include "print.h"
 #include "config.h"
+#ifdef SCAN_SCHEDULER_ENABLE
+#include "scan_scheduler.h"
+#endif
 
 static event_source_t new_data_event;
 static bool serial_link_connected;
@@ -66,16 +69,16 @@ static SerialConfig config = {
 
 //#define DEBUG_LINK_ERRORS
 
+// Bytes taken from the serial queue at once, at higher baud rates more bytes
+// arrive each time the thread wakes up
+#ifndef SERIAL_LINK_READ_SIZE
+#define SERIAL_LINK_READ_SIZE 64
+#endif
+
 static uint32_t read_from_serial(SerialDriver* driver, uint8_t link) {
-    const uint32_t buffer_size = 16;
-    uint8_t buffer[buffer_size];
-    uint32_t bytes_read = sdAsynchronousRead(driver, buffer, buffer_size);
-    uint8_t* current = buffer;
-    uint8_t* end = current + bytes_read;
-    while(current < end) {
-        byte_stuffer_recv_byte(link, *current);
-        current++;
-    }
+    uint8_t buffer[SERIAL_LINK_READ_SIZE];
+    uint32_t bytes_read = sdAsynchronousRead(driver, buffer, sizeof(buffer));
+    byte_stuffer_recv(link, buffer, bytes_read);
     return bytes_read;
 }
 
@@ -137,7 +140,9 @@ static THD_FUNCTION(serialThread, arg) {
         eventflags_t flags1 = 0;
         eventflags_t flags2 = 0;
         if (need_wait) {
-            eventmask_t mask = chEvtWaitAnyTimeout(ALL_EVENTS, MS2ST(1000));
+            // wake up in time to send frames that weren't acknowledged again
+            systime_t timeout = transport_waiting_for_ack() ? MS2ST(TRANSPORT_RETRANSMIT_TIMEOUT) : MS2ST(1000);
+            eventmask_t mask = chEvtWaitAnyTimeout(ALL_EVENTS, timeout);
             if (mask & EVENT_MASK(1)) {
                 flags1 = chEvtGetAndClearFlags(&sd1_listener);
                 print_error("DOWNLINK", flags1, &SD1);
@@ -156,6 +161,12 @@ static THD_FUNCTION(serialThread, arg) {
         need_wait &= read_from_serial(&SD2, UP_LINK) == 0;
         need_wait &= read_from_serial(&SD1, DOWN_LINK) == 0;
         update_transport();
+#ifdef SCAN_SCHEDULER_ENABLE
+        if (!need_wait) {
+            // the remote matrix may have changed
+            scan_scheduler_wakeup();
+        }
+#endif
     }
 }
 
@@ -26,6 +26,9 @@ SOFTWARE.
 #include "gmock/gmock.h"
 #include <vector>
 #include <algorithm>
+#include <random>
+#include <chrono>
+#include <iostream>
 extern "C" {
 #include "serial_link/protocol/byte_stuffer.h"
 #include "serial_link/protocol/frame_validator.h"
@@ -35,6 +38,7 @@ extern "C" {
 using testing::_;
 using testing::ElementsAreArray;
 using testing::Args;
+using testing::Invoke;
 
 class ByteStuffer : public ::testing::Test{
 public:
@@ -481,3 +485,94 @@ TEST_F(ByteStuffer, sends_and_receives_full_roundtrip_254_bytes_and_then_zero) {
        byte_stuffer_recv_byte(1, d);
     }
 }
+
+typedef std::vector<std::vector<uint8_t>> Frames;
+
+// Encoded frames of every size up to more than the maximum, with runs of
+// zeroes, and with some of the bytes on the wire corrupted
+static std::vector<uint8_t> random_stream(ByteStuffer* test, std::mt19937& rng) {
+    std::uniform_int_distribution<int> size(0, MAX_FRAME_SIZE + 100);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::bernoulli_distribution zero(0.05);
+    std::bernoulli_distribution corrupt(0.002);
+    test->sent_data.clear();
+    for (int i = 0; i < 200; i++) {
+        std::vector<uint8_t> frame(i < 20 ? i : size(rng));
+        for (auto& b : frame) {
+            b = zero(rng) ? 0 : byte(rng);
+        }
+        byte_stuffer_send_frame(0, frame.data(), frame.size());
+    }
+    std::vector<uint8_t> stream = test->sent_data;
+    for (auto& b : stream) {
+        if (corrupt(rng)) {
+            b = zero(rng) ? 0 : byte(rng);
+        }
+    }
+    return stream;
+}
+
+TEST_F(ByteStuffer, bulk_receive_gives_the_same_frames_as_single_bytes) {
+    Frames frames;
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .WillRepeatedly(Invoke([&frames](uint8_t link, uint8_t* data, uint16_t size) {
+            frames.push_back(std::vector<uint8_t>(data, data + size));
+        }));
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> chunk(1, 300);
+    for (int round = 0; round < 20; round++) {
+        std::vector<uint8_t> stream = random_stream(this, rng);
+
+        init_byte_stuffer();
+        frames.clear();
+        for (auto& d : stream) {
+            byte_stuffer_recv_byte(1, d);
+        }
+        Frames expected;
+        std::swap(expected, frames);
+        ASSERT_GT(expected.size(), 100);
+
+        init_byte_stuffer();
+        size_t pos = 0;
+        while (pos < stream.size()) {
+            uint16_t size = std::min<size_t>(chunk(rng), stream.size() - pos);
+            byte_stuffer_recv(1, stream.data() + pos, size);
+            pos += size;
+        }
+        ASSERT_EQ(frames, expected) << "round " << round;
+    }
+}
+
+// Prints the throughput of both decoders. The timing on a shared machine is
+// too noisy to assert on.
+TEST_F(ByteStuffer, DISABLED_bulk_receive_throughput) {
+    const int num_frames = 10000;
+    uint8_t frame[1000];
+    for (int i = 0; i < sizeof(frame); i++) {
+        frame[i] = i % 200 ? i : 0;
+    }
+    for (int i = 0; i < num_frames; i++) {
+        byte_stuffer_send_frame(0, frame, sizeof(frame));
+    }
+    uint32_t received = 0;
+    EXPECT_CALL(*this, validator_recv_frame(_, _, _))
+        .WillRepeatedly(Invoke([&received](uint8_t link, uint8_t* data, uint16_t size) {
+            received++;
+        }));
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& d : sent_data) {
+        byte_stuffer_recv_byte(1, d);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < sent_data.size(); pos += 128) {
+        byte_stuffer_recv(1, sent_data.data() + pos, std::min<size_t>(128, sent_data.size() - pos));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(received, 2 * num_frames);
+    std::chrono::duration<double> per_byte = middle - start;
+    std::chrono::duration<double> bulk = end - middle;
+    std::cout << "per byte: " << sent_data.size() / per_byte.count() / 1e6 << " MB/s, "
+        << "bulk: " << sent_data.size() / bulk.count() / 1e6 << " MB/s" << std::endl;
+}
@@ -0,0 +1,240 @@
+#include "gtest/gtest.h"
+#include <random>
+#include <deque>
+#include <vector>
+#include <iostream>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+#include "host_driver.h"
+#include "timer.h"
+}
+
+// A master and a slave connected by a serial cable that flips bits, running
+// the whole protocol stack from the byte stuffer to the transport.
+
+// The rate of the Infinity ErgoDox
+static const uint32_t default_baud = 562500;
+static const uint64_t scan_time_ns = 1000000;
+// The serial thread wakes up this often and takes what has arrived
+static const uint64_t wake_ns = 20000;
+// serial_link_update() sends the matrix at least this often
+static const uint64_t keepalive_ns = 5000000;
+
+static uint64_t now_ns;
+static std::deque<uint8_t> down_wire;
+static std::deque<uint8_t> up_wire;
+
+namespace master_node {
+#include "simulated_node.h"
+
+uint32_t timer_read32(void) {
+    return now_ns / 1000000;
+}
+
+void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+    if (link == DOWN_LINK) {
+        down_wire.insert(down_wire.end(), data, data + size);
+    }
+}
+}
+
+namespace slave_node {
+#include "simulated_node.h"
+
+uint32_t timer_read32(void) {
+    return now_ns / 1000000;
+}
+
+void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+    if (link == UP_LINK) {
+        up_wire.insert(up_wire.end(), data, data + size);
+    }
+}
+}
+
+class Wire {
+public:
+    Wire(std::deque<uint8_t>& bytes, double bit_error_rate, std::mt19937& rng)
+        : bytes(bytes), errors(bit_error_rate), rng(rng) {
+        next_error = draw();
+    }
+
+    // One byte time, the byte goes into the serial queue of the other end
+    void transfer(std::vector<uint8_t>& queue) {
+        if (bytes.empty()) {
+            return;
+        }
+        uint8_t byte = bytes.front();
+        bytes.pop_front();
+        while (next_error < 8) {
+            byte ^= 1 << next_error;
+            flipped++;
+            next_error += 1 + draw();
+        }
+        next_error -= 8;
+        queue.push_back(byte);
+    }
+
+    uint64_t flipped = 0;
+
+private:
+    uint64_t draw() {
+        return errors.p() > 0 ? errors(rng) : UINT64_MAX / 2;
+    }
+
+    std::deque<uint8_t>& bytes;
+    std::geometric_distribution<uint64_t> errors;
+    std::mt19937& rng;
+    uint64_t next_error;
+};
+
+struct SimulationResult {
+    uint32_t changes;
+    uint32_t delivered;
+    double mean_staleness_us;
+    double max_staleness_us;
+    uint64_t flipped_bits;
+    const master_node::transport_stats_t* master;
+    const slave_node::transport_stats_t* slave;
+};
+
+// The slave changes its matrix on a random fifth of the scans. The staleness
+// of a change is the time until the master has it, or a later state.
+static SimulationResult simulate(double bit_error_rate, uint32_t seconds, uint32_t baud = default_baud) {
+    // 8 data bits with a start and a stop bit
+    const uint64_t byte_time_ns = 10 * 1000000000ull / baud;
+    std::mt19937 rng(1234);
+    std::bernoulli_distribution change(0.2);
+    now_ns = 0;
+    down_wire.clear();
+    up_wire.clear();
+    Wire down(down_wire, bit_error_rate, rng);
+    Wire up(up_wire, bit_error_rate, rng);
+
+    master_node::reinitialize_serial_link_transport();
+    master_node::add_remote_objects(master_node::node_objects, 1);
+    master_node::init_byte_stuffer();
+    master_node::router_set_master(true);
+    slave_node::reinitialize_serial_link_transport();
+    slave_node::add_remote_objects(slave_node::node_objects, 1);
+    slave_node::init_byte_stuffer();
+    slave_node::router_set_master(false);
+
+    std::vector<uint64_t> written = {0};
+    uint32_t seen = 0;
+    double total_staleness = 0;
+    double max_staleness = 0;
+    uint64_t next_scan = 0;
+    uint64_t next_wake = 0;
+    std::vector<uint8_t> master_queue;
+    std::vector<uint8_t> slave_queue;
+    uint64_t last_write = 0;
+    const uint64_t end = seconds * 1000000000ull;
+    // leave time for the last change to arrive
+    const uint64_t drain = end + 50000000;
+
+    for (; now_ns < drain; now_ns += byte_time_ns) {
+        if (now_ns >= next_scan && now_ns < end) {
+            next_scan += scan_time_ns;
+            bool changed = change(rng);
+            if (changed || now_ns - last_write >= keepalive_ns) {
+                if (changed) {
+                    written.push_back(now_ns);
+                }
+                last_write = now_ns;
+                slave_node::matrix_object_t* m = slave_node::begin_write_keyboard_matrix();
+                m->count = written.size() - 1;
+                memset(m->rows, m->count, sizeof(m->rows));
+                slave_node::end_write_keyboard_matrix();
+            }
+        }
+        down.transfer(slave_queue);
+        up.transfer(master_queue);
+        if (now_ns < next_wake) {
+            continue;
+        }
+        next_wake += wake_ns;
+        slave_node::byte_stuffer_recv(UP_LINK, slave_queue.data(), slave_queue.size());
+        slave_queue.clear();
+        master_node::byte_stuffer_recv(DOWN_LINK, master_queue.data(), master_queue.size());
+        master_queue.clear();
+        slave_node::update_transport();
+        master_node::update_transport();
+
+        master_node::matrix_object_t* m = master_node::read_keyboard_matrix(0);
+        if (m) {
+            EXPECT_LT(m->count, written.size());
+            EXPECT_EQ(m->rows[0], (uint8_t)m->count);
+            while (seen < m->count) {
+                seen++;
+                double staleness = (now_ns - written[seen]) / 1000.0;
+                total_staleness += staleness;
+                if (staleness > max_staleness) {
+                    max_staleness = staleness;
+                }
+            }
+        }
+    }
+
+    SimulationResult result;
+    result.changes = written.size() - 1;
+    result.delivered = seen;
+    result.mean_staleness_us = seen ? total_staleness / seen : 0;
+    result.max_staleness_us = max_staleness;
+    result.flipped_bits = down.flipped + up.flipped;
+    result.master = master_node::transport_stats();
+    result.slave = slave_node::transport_stats();
+    return result;
+}
+
+static void print(const char* name, const SimulationResult& result) {
+    std::cout << name << ": " << result.changes << " changes, staleness mean "
+        << result.mean_staleness_us << "us max " << result.max_staleness_us << "us, "
+        << result.flipped_bits << " bits flipped, "
+        << result.slave->sent << " frames, " << result.slave->retransmitted << " retransmitted, "
+        << result.slave->acks << " acks" << std::endl;
+}
+
+TEST(LinkSimulation, CleanLinkNeverRetransmits) {
+    SimulationResult result = simulate(0, 2);
+    EXPECT_GT(result.changes, 300);
+    EXPECT_EQ(result.delivered, result.changes);
+    EXPECT_EQ(result.slave->retransmitted, 0);
+    EXPECT_LT(result.max_staleness_us, 1000);
+}
+
+// The keepalive period is how long a lost change took to arrive before frames
+// were acknowledged
+TEST(LinkSimulation, ChangesArriveBeforeTheKeepaliveDespiteBitErrors) {
+    SimulationResult result = simulate(1e-4, 10);
+    EXPECT_GT(result.slave->retransmitted, 0);
+    EXPECT_EQ(result.delivered, result.changes);
+    EXPECT_LT(result.max_staleness_us, keepalive_ns / 1000);
+}
+
+TEST(LinkSimulation, VeryNoisyLinkStillDeliversEveryChange) {
+    SimulationResult result = simulate(2e-3, 10);
+    EXPECT_EQ(result.delivered, result.changes);
+}
+
+// Prints the staleness and the retransmissions at each bit error rate, to
+// compare settings with
+TEST(LinkSimulation, DISABLED_Report) {
+    print("no errors", simulate(0, 2));
+    print("1e-4 bit errors", simulate(1e-4, 10));
+    print("2e-3 bit errors", simulate(2e-3, 10));
+    print("3000000 baud", simulate(0, 2, 3000000));
+}
+
+TEST(LinkSimulation, HigherBaudRatesCutTheLatency) {
+    SimulationResult result = simulate(0, 2);
+    double default_staleness = result.mean_staleness_us;
+    result = simulate(0, 2, 3000000);
+    EXPECT_EQ(result.delivered, result.changes);
+    EXPECT_LT(result.mean_staleness_us, default_staleness / 3);
+    EXPECT_LT(result.max_staleness_us, scan_time_ns / 1000 / 4);
+}
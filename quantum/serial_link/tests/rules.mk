@@ -20,3 +20,6 @@ serial_link_transport_SRC := \
 	$(SERIAL_PATH)/tests/transport_tests.cpp \
 	$(SERIAL_PATH)/protocol/transport.c \
 	$(SERIAL_PATH)/protocol/triple_buffered_object.c 
+
+serial_link_link_simulation_SRC := \
+	$(SERIAL_PATH)/tests/link_simulation_tests.cpp
@@ -0,0 +1,32 @@
+// Included inside a namespace once for every simulated node, so that each
+// node has its own copy of the protocol stack and of its static state. There
+// is deliberately no include guard.
+
+#undef SERIAL_LINK_H
+#undef SERIAL_LINK_PHYSICAL_H
+#undef SERIAL_LINK_BYTE_STUFFER_H
+#undef SERIAL_LINK_FRAME_VALIDATOR_H
+#undef SERIAL_LINK_FRAME_ROUTER_H
+#undef SERIAL_LINK_TRIPLE_BUFFERED_OBJECT_H
+#undef SERIAL_LINK_TRANSPORT_H
+
+uint32_t timer_read32(void);
+void signal_data_written(void) {}
+
+#include "serial_link/protocol/physical.h"
+#include "serial_link/protocol/byte_stuffer.c"
+#include "serial_link/protocol/frame_validator.c"
+#include "serial_link/protocol/frame_router.c"
+#include "serial_link/protocol/triple_buffered_object.c"
+#include "serial_link/protocol/transport.c"
+
+typedef struct {
+    uint32_t count;
+    uint8_t rows[6];
+} matrix_object_t;
+
+SLAVE_TO_MASTER_OBJECT(keyboard_matrix, matrix_object_t);
+
+static remote_object_t* node_objects[] = {
+    REMOTE_OBJECT(keyboard_matrix),
+};
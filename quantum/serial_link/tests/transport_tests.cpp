@@ -28,6 +28,8 @@ SOFTWARE.
 using testing::_;
 using testing::ElementsAreArray;
 using testing::Args;
+using testing::AnyNumber;
+using testing::InSequence;
 
 extern "C" {
 #include "serial_link/protocol/transport.h"
@@ -70,11 +72,36 @@ public:
     void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) {
         router_send_frame(destination);
         std::copy(data, data + size, std::back_inserter(sent_data));
+        frames.push_back(std::vector<uint8_t>(data, data + size));
+    }
+
+    void write_slave_to_master(uint32_t value) {
+        EXPECT_CALL(*this, signal_data_written());
+        begin_write_slave_to_master()->test = value;
+        end_write_slave_to_master();
+    }
+
+    void ack(uint8_t expected, uint8_t received) {
+        uint8_t frame[] = {expected, received, TRANSPORT_ACK_ID};
+        transport_recv_frame(0, frame, sizeof(frame));
+    }
+
+    static uint32_t value(const std::vector<uint8_t>& frame) {
+        uint32_t result;
+        memcpy(&result, frame.data(), sizeof(result));
+        return result;
+    }
+
+    static uint8_t sequence(const std::vector<uint8_t>& frame) {
+        return frame[frame.size() - 2];
     }
 
     static Transport* Instance;
 
     std::vector<uint8_t> sent_data;
+    std::vector<std::vector<uint8_t>> frames;
+    bool master = true;
+    uint32_t now = 0;
 };
 
 Transport* Transport::Instance = nullptr;
@@ -87,6 +114,14 @@ void signal_data_written(void) {
 void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) {
     Transport::Instance->router_send_frame(destination, data, size);
 }
+
+bool router_is_master(void) {
+    return Transport::Instance->master;
+}
+
+uint32_t timer_read32(void) {
+    return Transport::Instance->now;
+}
 }
 
 TEST_F(Transport, write_to_local_signals_an_event) {
@@ -116,6 +151,7 @@ TEST_F(Transport, writes_from_master_to_all_slaves) {
 }
 
 TEST_F(Transport, writes_from_slave_to_master) {
+    master = false;
     update_transport();
     test_object1* obj = begin_write_slave_to_master();
     obj->test = 7;
@@ -136,7 +172,8 @@ TEST_F(Transport, writes_from_master_to_single_slave) {
     obj->test = 7;
     EXPECT_CALL(*this, signal_data_written());
     end_write_master_to_single_slave(3);
-    EXPECT_CALL(*this, router_send_frame(4));
+    // the fourth slave from the master
+    EXPECT_CALL(*this, router_send_frame(8));
     update_transport();
     transport_recv_frame(0, sent_data.data(), sent_data.size());
     test_object1* obj2 = read_master_to_single_slave();
@@ -150,7 +187,7 @@ TEST_F(Transport, ignores_object_with_invalid_id) {
     obj->test = 7;
     EXPECT_CALL(*this, signal_data_written());
     end_write_master_to_single_slave(3);
-    EXPECT_CALL(*this, router_send_frame(4));
+    EXPECT_CALL(*this, router_send_frame(8));
     update_transport();
     sent_data[sent_data.size() - 1] = 44;
     transport_recv_frame(0, sent_data.data(), sent_data.size());
@@ -186,3 +223,148 @@ TEST_F(Transport, ignores_object_with_size_too_big) {
     test_object1* obj2 = read_master_to_slave();
     EXPECT_EQ(obj2, nullptr);
 }
+
+TEST_F(Transport, frames_to_a_single_node_wait_for_an_ack) {
+    master = false;
+    EXPECT_CALL(*this, router_send_frame(0)).Times(3);
+    for (uint32_t i = 0; i < 3; i++) {
+        write_slave_to_master(i);
+        update_transport();
+    }
+    ASSERT_EQ(frames.size(), 3);
+    for (uint8_t i = 0; i < 3; i++) {
+        EXPECT_EQ(sequence(frames[i]), i);
+    }
+    EXPECT_TRUE(transport_waiting_for_ack());
+    ack(2, 0);
+    EXPECT_TRUE(transport_waiting_for_ack());
+    ack(3, 0);
+    EXPECT_FALSE(transport_waiting_for_ack());
+    EXPECT_EQ(transport_stats()->sent, 3);
+    EXPECT_EQ(transport_stats()->retransmitted, 0);
+}
+
+TEST_F(Transport, full_window_holds_back_changes) {
+    master = false;
+    EXPECT_CALL(*this, router_send_frame(0)).Times(AnyNumber());
+    for (uint32_t i = 0; i < TRANSPORT_WINDOW + 3; i++) {
+        write_slave_to_master(i);
+        update_transport();
+    }
+    ASSERT_EQ(frames.size(), TRANSPORT_WINDOW);
+    ack(1, 0);
+    update_transport();
+    ASSERT_EQ(frames.size(), TRANSPORT_WINDOW + 1);
+    // only the newest state is sent
+    EXPECT_EQ(value(frames.back()), TRANSPORT_WINDOW + 2);
+    EXPECT_EQ(sequence(frames.back()), TRANSPORT_WINDOW);
+}
+
+TEST_F(Transport, frame_missing_from_an_ack_is_sent_again_at_once) {
+    master = false;
+    EXPECT_CALL(*this, router_send_frame(0)).Times(AnyNumber());
+    for (uint32_t i = 0; i < 3; i++) {
+        write_slave_to_master(i);
+        update_transport();
+    }
+    // frames 1 and 2 arrived, but not 0
+    ack(0, 0x6);
+    ASSERT_EQ(frames.size(), 4);
+    EXPECT_EQ(sequence(frames[3]), 0);
+    EXPECT_EQ(value(frames[3]), 2);
+    EXPECT_EQ(transport_stats()->retransmitted, 1);
+    // a later ack that still misses it doesn't send it again
+    ack(0, 0x6);
+    EXPECT_EQ(frames.size(), 4);
+    ack(3, 0);
+    EXPECT_FALSE(transport_waiting_for_ack());
+}
+
+TEST_F(Transport, frame_without_an_ack_is_sent_again_after_the_timeout) {
+    master = false;
+    EXPECT_CALL(*this, router_send_frame(0)).Times(AnyNumber());
+    write_slave_to_master(5);
+    update_transport();
+    now += TRANSPORT_RETRANSMIT_TIMEOUT - 1;
+    update_transport();
+    EXPECT_EQ(frames.size(), 1);
+    now += 1;
+    update_transport();
+    ASSERT_EQ(frames.size(), 2);
+    EXPECT_EQ(frames[1], frames[0]);
+    ack(1, 0);
+    now += TRANSPORT_RETRANSMIT_TIMEOUT;
+    update_transport();
+    EXPECT_EQ(frames.size(), 2);
+}
+
+TEST_F(Transport, received_frames_are_acknowledged) {
+    // the ack goes down to the third slave only
+    EXPECT_CALL(*this, router_send_frame(4)).Times(AnyNumber());
+    uint8_t frame[] = {1, 0, 0, 0, 0, 2};
+    transport_recv_frame(3, frame, sizeof(frame));
+    frame[4] = 2;
+    transport_recv_frame(3, frame, sizeof(frame));
+    update_transport();
+    ASSERT_EQ(frames.size(), 1);
+    EXPECT_EQ(frames[0], std::vector<uint8_t>({1, 0x2, TRANSPORT_ACK_ID}));
+    frame[4] = 1;
+    transport_recv_frame(3, frame, sizeof(frame));
+    // a duplicate is acknowledged again
+    transport_recv_frame(3, frame, sizeof(frame));
+    update_transport();
+    ASSERT_EQ(frames.size(), 2);
+    EXPECT_EQ(frames[1], std::vector<uint8_t>({3, 0, TRANSPORT_ACK_ID}));
+    EXPECT_EQ(read_slave_to_master(2)->test, 1);
+}
+
+TEST_F(Transport, frames_are_renumbered_for_a_restarted_node) {
+    master = false;
+    EXPECT_CALL(*this, router_send_frame(0)).Times(AnyNumber());
+    for (uint32_t i = 0; i < 2; i++) {
+        write_slave_to_master(i);
+        update_transport();
+    }
+    ack(200, 0);
+    ASSERT_EQ(frames.size(), 4);
+    EXPECT_EQ(sequence(frames[2]), 200);
+    EXPECT_EQ(sequence(frames[3]), 201);
+    ack(202, 0);
+    EXPECT_FALSE(transport_waiting_for_ack());
+}
+
+TEST_F(Transport, frames_to_a_slave_are_sent_again_to_that_slave_only) {
+    EXPECT_CALL(*this, signal_data_written()).Times(AnyNumber());
+    InSequence s;
+    EXPECT_CALL(*this, router_send_frame(1));
+    EXPECT_CALL(*this, router_send_frame(4));
+    EXPECT_CALL(*this, router_send_frame(4));
+    begin_write_master_to_single_slave(0)->test = 1;
+    end_write_master_to_single_slave(0);
+    begin_write_master_to_single_slave(2)->test = 2;
+    end_write_master_to_single_slave(2);
+    update_transport();
+    // the first slave acknowledges, the third one doesn't
+    uint8_t frame[] = {1, 0, TRANSPORT_ACK_ID};
+    transport_recv_frame(1, frame, sizeof(frame));
+    now += TRANSPORT_RETRANSMIT_TIMEOUT;
+    update_transport();
+    ASSERT_EQ(frames.size(), 3);
+    EXPECT_EQ(frames[2], frames[1]);
+}
+
+TEST_F(Transport, frames_from_before_a_slave_became_master_are_dropped) {
+    master = false;
+    EXPECT_CALL(*this, router_send_frame(0)).Times(1);
+    write_slave_to_master(5);
+    update_transport();
+    EXPECT_TRUE(transport_waiting_for_ack());
+    // USB was connected to this half, the frame can't reach a master anymore
+    master = true;
+    EXPECT_FALSE(transport_waiting_for_ack());
+    now += TRANSPORT_RETRANSMIT_TIMEOUT;
+    update_transport();
+    EXPECT_FALSE(transport_waiting_for_ack());
+    EXPECT_EQ(frames.size(), 1);
+    EXPECT_EQ(transport_stats()->retransmitted, 0);
+}
@@ -0,0 +1,51 @@
+#ifndef QUANTUM_TESTS_MATRIX_SIM_H_
+#define QUANTUM_TESTS_MATRIX_SIM_H_
+
+/* The configuration and the AVR registers that quantum/matrix.c uses,
+ * backed by the simulated keyboard in matrix_tests.cpp.
+ */
+
+#include <stdint.h>
+#include "config_common.h"
+
+#define MATRIX_ROWS 3
+#define MATRIX_COLS 4
+#define DIODE_DIRECTION COL2ROW
+#define MATRIX_ROW_PINS { D0, D1, F6 }
+#define MATRIX_COL_PINS { B0, B1, B4, B7 }
+#define DEBOUNCING_DELAY 5
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint8_t* matrix_sim_register(uint8_t address);
+void matrix_sim_cli(void);
+void matrix_sim_sei(void);
+void matrix_sim_sleep(void);
+void matrix_sim_pcint(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define _SFR_IO8(address) (*matrix_sim_register(address))
+#define _BV(bit) (1 << (bit))
+
+#define PCMSK0 _SFR_IO8(0x40)
+#define PCICR  _SFR_IO8(0x41)
+#define PCIFR  _SFR_IO8(0x42)
+#define PCIE0  0
+#define PCIF0  0
+
+#define cli() matrix_sim_cli()
+#define sei() matrix_sim_sei()
+#define SLEEP_MODE_IDLE 0
+#define set_sleep_mode(mode)
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu() matrix_sim_sleep()
+#define EMPTY_INTERRUPT(vector) void vector(void) {}
+#define PCINT0_vect matrix_sim_pcint
+
+#endif /* QUANTUM_TESTS_MATRIX_SIM_H_ */
@@ -0,0 +1,309 @@
+#include "gtest/gtest.h"
+#include <functional>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "matrix.h"
+#include "timer.h"
+}
+
+/* A simulated keyboard behind the port registers. The rows and columns are
+ * wired like a COL2ROW matrix: a column input reads low when a switch on it
+ * is closed and its row is driven low.
+ */
+
+enum HookPoint {
+    HOOK_CLI,
+    HOOK_SEI,
+    HOOK_SLEEP,
+};
+
+static const uint8_t row_pins[MATRIX_ROWS] = MATRIX_ROW_PINS;
+static const uint8_t col_pins[MATRIX_COLS] = MATRIX_COL_PINS;
+
+static uint8_t io[256];
+/* writes to PCIFR clear flags instead of setting them */
+static uint8_t pcifr_write;
+static bool switches[MATRIX_ROWS][MATRIX_COLS];
+static bool interrupts_enabled;
+/* sei() lets one more instruction run before a pending interrupt */
+static bool interrupt_delayed;
+static bool pcint_pending;
+static uint32_t now;
+static unsigned pcint_count;
+static unsigned timer_wakes;
+static unsigned pin_reads;
+static std::function<void(HookPoint)> hook;
+
+static bool row_driven_low(uint8_t row) {
+    uint8_t pin = row_pins[row];
+    uint8_t bit = 1 << (pin & 0xF);
+    return (io[(pin >> 4) + 1] & bit) && !(io[(pin >> 4) + 2] & bit);
+}
+
+static bool col_level(uint8_t col) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (switches[row][col] && row_driven_low(row)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint8_t port_levels(uint8_t port) {
+    // unconnected inputs float high
+    uint8_t levels = io[port + 2] | ~io[port + 1];
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        if ((col_pins[col] >> 4) == port && !col_level(col)) {
+            levels &= ~(1 << (col_pins[col] & 0xF));
+        }
+    }
+    return levels;
+}
+
+static void deliver_interrupts() {
+    if (pcifr_write) {
+        pcint_pending = pcint_pending && !(pcifr_write & _BV(PCIF0));
+        pcifr_write = 0;
+    }
+    if (interrupt_delayed) {
+        interrupt_delayed = false;
+        return;
+    }
+    if (interrupts_enabled && pcint_pending && (io[0x41] & _BV(PCIE0))) {
+        pcint_pending = false;
+        pcint_count++;
+        matrix_sim_pcint();
+    }
+}
+
+static void set_switch(uint8_t row, uint8_t col, bool closed) {
+    uint8_t port = B0 >> 4;
+    uint8_t before = port_levels(port);
+    switches[row][col] = closed;
+    if ((before ^ port_levels(port)) & io[0x40]) {
+        pcint_pending = true;
+    }
+    deliver_interrupts();
+}
+
+extern "C" {
+
+uint8_t* matrix_sim_register(uint8_t address) {
+    deliver_interrupts();
+    if (address == 0x42) {
+        return &pcifr_write;
+    }
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        if ((col_pins[col] >> 4) == address) {
+            pin_reads++;
+            io[address] = port_levels(address);
+            break;
+        }
+    }
+    return &io[address];
+}
+
+void matrix_sim_cli(void) {
+    deliver_interrupts();
+    interrupts_enabled = false;
+    if (hook) hook(HOOK_CLI);
+}
+
+void matrix_sim_sei(void) {
+    if (hook) hook(HOOK_SEI);
+    interrupt_delayed = !interrupts_enabled;
+    interrupts_enabled = true;
+}
+
+void matrix_sim_sleep(void) {
+    EXPECT_TRUE(interrupts_enabled) << "sleeping with interrupts disabled never wakes";
+    interrupt_delayed = false;
+    unsigned before = pcint_count;
+    if (hook) hook(HOOK_SLEEP);
+    deliver_interrupts();
+    if (pcint_count == before) {
+        // only the millisecond timer wakes it
+        now++;
+        timer_wakes++;
+    }
+}
+
+uint16_t timer_read(void) {
+    return now;
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return TIMER_DIFF_16(now, last);
+}
+
+}
+
+class MatrixInterrupt : public testing::Test {
+public:
+    MatrixInterrupt() {
+        std::fill(std::begin(io), std::end(io), 0);
+        for (auto& row : switches) {
+            std::fill(std::begin(row), std::end(row), false);
+        }
+        pcifr_write = 0;
+        interrupts_enabled = true;
+        interrupt_delayed = false;
+        pcint_pending = false;
+        now = 1000;
+        pcint_count = 0;
+        timer_wakes = 0;
+        pin_reads = 0;
+        hook = nullptr;
+        matrix_init();
+    }
+
+    ~MatrixInterrupt() {
+        hook = nullptr;
+    }
+
+    // a scan of the main loop, which takes a millisecond unless it slept
+    void scan() {
+        uint32_t before = now;
+        matrix_scan();
+        if (now == before) {
+            now++;
+        }
+    }
+
+    void scan_for(uint32_t ms) {
+        uint32_t end = now + ms;
+        while (now < end) {
+            scan();
+        }
+    }
+
+    bool rows_selected() {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            if (!row_driven_low(row)) return false;
+        }
+        return true;
+    }
+};
+
+TEST_F(MatrixInterrupt, IdleScansOnlyReadTheColumns) {
+    scan_for(10);
+    ASSERT_TRUE(rows_selected());
+    pin_reads = 0;
+    timer_wakes = 0;
+    for (int i = 0; i < 100; i++) {
+        scan();
+        EXPECT_TRUE(rows_selected());
+    }
+    // the check before sleeping and the one after waking
+    EXPECT_EQ(pin_reads, 100 * 2 * MATRIX_COLS);
+    EXPECT_EQ(timer_wakes, 100);
+}
+
+TEST_F(MatrixInterrupt, KeyDownWakesTheSleep) {
+    scan_for(10);
+    hook = [](HookPoint point) {
+        if (point == HOOK_SLEEP) {
+            set_switch(1, 2, true);
+            hook = nullptr;
+        }
+    };
+    uint32_t before = now;
+    matrix_scan();
+    EXPECT_EQ(now, before);
+    EXPECT_EQ(pcint_count, 1);
+    scan_for(DEBOUNCING_DELAY + 2);
+    EXPECT_EQ(matrix_get_row(1), 1 << 2);
+    EXPECT_FALSE(rows_selected());
+}
+
+TEST_F(MatrixInterrupt, KeyDownBeforeTheSleepIsNotMissed) {
+    scan_for(10);
+    // between the check and the sleep, with interrupts disabled
+    hook = [](HookPoint point) {
+        if (point == HOOK_SEI) {
+            set_switch(0, 3, true);
+            hook = nullptr;
+        }
+    };
+    uint32_t before = now;
+    timer_wakes = 0;
+    matrix_scan();
+    EXPECT_EQ(now, before);
+    EXPECT_EQ(pcint_count, 1);
+    EXPECT_EQ(timer_wakes, 0);
+    scan_for(DEBOUNCING_DELAY + 2);
+    EXPECT_EQ(matrix_get_row(0), 1 << 3);
+}
+
+TEST_F(MatrixInterrupt, HeldKeysAreScannedUntilReleased) {
+    scan_for(10);
+    set_switch(2, 0, true);
+    scan_for(DEBOUNCING_DELAY + 2);
+    EXPECT_EQ(matrix_get_row(2), 1);
+    unsigned wakes = timer_wakes;
+    scan_for(100);
+    EXPECT_EQ(timer_wakes, wakes);
+    EXPECT_EQ(matrix_get_row(2), 1);
+    set_switch(2, 0, false);
+    scan_for(DEBOUNCING_DELAY + 2);
+    EXPECT_EQ(matrix_get_row(2), 0);
+    EXPECT_TRUE(rows_selected());
+}
+
+TEST_F(MatrixInterrupt, NoEdgesAreMissed) {
+    std::mt19937 random(1234);
+    struct Edge {
+        uint8_t row;
+        uint8_t col;
+        HookPoint point;
+        bool in_loop;
+    };
+    for (int i = 0; i < 2000; i++) {
+        Edge edge = {
+            uint8_t(random() % MATRIX_ROWS),
+            uint8_t(random() % MATRIX_COLS),
+            HookPoint(random() % 3),
+            random() % 2 == 0,
+        };
+        // mostly release what is held, so the matrix keeps going idle
+        std::vector<std::pair<uint8_t, uint8_t>> closed_keys;
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                if (switches[row][col]) closed_keys.push_back({row, col});
+            }
+        }
+        if (!closed_keys.empty() && random() % 4 != 0) {
+            auto key = closed_keys[random() % closed_keys.size()];
+            edge.row = key.first;
+            edge.col = key.second;
+        }
+        bool closed = !switches[edge.row][edge.col];
+        if (edge.in_loop) {
+            set_switch(edge.row, edge.col, closed);
+        } else {
+            // at the next cli(), sei() or sleep, if the scan gets there
+            hook = [edge, closed](HookPoint point) {
+                if (point == edge.point) {
+                    set_switch(edge.row, edge.col, closed);
+                    hook = nullptr;
+                }
+            };
+            scan();
+            if (hook) {
+                hook = nullptr;
+                set_switch(edge.row, edge.col, closed);
+            }
+        }
+        scan_for(DEBOUNCING_DELAY + 2);
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            matrix_row_t expected = 0;
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                expected |= switches[row][col] << col;
+            }
+            ASSERT_EQ(matrix_get_row(row), expected) << "edge " << i << " row " << int(row);
+        }
+    }
+    EXPECT_GT(pcint_count, 300);
+}
@@ -0,0 +1,16 @@
+QUANTUM_TEST_PATH := $(QUANTUM_PATH)/tests
+
+quantum_matrix_DEFS := -DMATRIX_KEY_INTERRUPT -DNO_PRINT -DNO_DEBUG
+quantum_matrix_CONFIG := $(QUANTUM_TEST_PATH)/matrix_sim.h
+quantum_matrix_SRC :=\
+	$(QUANTUM_TEST_PATH)/matrix_tests.cpp \
+	$(QUANTUM_PATH)/matrix.c \
+	$(TMK_PATH)/common/util.c
+quantum_matrix_INC := $(QUANTUM_PATH) $(TMK_PATH)/common
+
+quantum_variable_trace_DEFS := -DTELEMETRY_ENABLE -DNUM_TRACED_VARIABLES=2 -DNO_PRINT -DNO_DEBUG
+quantum_variable_trace_SRC :=\
+	$(QUANTUM_TEST_PATH)/variable_trace_tests.cpp \
+	$(QUANTUM_PATH)/variable_trace.c \
+	$(TMK_PATH)/common/telemetry.c
+quantum_variable_trace_INC := $(QUANTUM_PATH) $(TMK_PATH)/common
@@ -0,0 +1,3 @@
+TEST_LIST +=\
+	quantum_matrix \
+	quantum_variable_trace
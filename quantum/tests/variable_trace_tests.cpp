@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+#include <string.h>
+#include <vector>
+
+extern "C" {
+#include "variable_trace.h"
+#include "telemetry.h"
+
+static uint32_t now = 0;
+
+uint32_t timer_read32(void) {
+    return now;
+}
+}
+
+static const uint8_t packet_size = 64;
+
+class VariableTrace : public testing::Test {
+public:
+    VariableTrace() {
+        remove_traced_variable("a", "test", 0);
+        remove_traced_variable("b", "test", 0);
+        a = 0x12345678;
+        b = 0;
+        records();
+        now = 100;
+    }
+
+    // everything logged since the last call
+    std::vector<telemetry_record_t> records() {
+        std::vector<telemetry_record_t> result;
+        uint8_t packet[packet_size];
+        while (uint8_t count = telemetry_fill_packet(packet, packet_size)) {
+            for (uint8_t i = 0; i < count; i++) {
+                telemetry_record_t record;
+                memcpy(&record, packet + TELEMETRY_PACKET_HEADER + i * sizeof(record), sizeof(record));
+                result.push_back(record);
+            }
+        }
+        return result;
+    }
+
+    uint32_t a;
+    uint8_t b;
+};
+
+TEST_F(VariableTrace, InitialValueIsLogged) {
+    add_traced_variable("a", &a, sizeof(a), "test", 10);
+    auto logged = records();
+    ASSERT_EQ(logged.size(), 2);
+    EXPECT_EQ(logged[0].type, TELEMETRY_TRACE_VALUE);
+    EXPECT_EQ(logged[0].arg, 0);
+    EXPECT_EQ(logged[0].value, 0x5678);
+    EXPECT_EQ(logged[1].arg, 2);
+    EXPECT_EQ(logged[1].value, 0x1234);
+}
+
+TEST_F(VariableTrace, UnchangedVariablesLogNothing) {
+    add_traced_variable("a", &a, sizeof(a), "test", 10);
+    records();
+    for (int i = 0; i < 1000; i++) {
+        verify_traced_variables("test", 20);
+    }
+    EXPECT_EQ(records().size(), 0);
+}
+
+TEST_F(VariableTrace, ChangesAreLoggedWithTimeAndLines) {
+    add_traced_variable("a", &a, sizeof(a), "test", 10);
+    add_traced_variable("b", &b, sizeof(b), "test", 11);
+    verify_traced_variables("test", 20);
+    records();
+    b = 0xAB;
+    now = 150;
+    verify_traced_variables("test", 30);
+    auto logged = records();
+    ASSERT_EQ(logged.size(), 3);
+    EXPECT_EQ(logged[0].type, TELEMETRY_TRACE_VALUE);
+    EXPECT_EQ(logged[0].arg, 1 << 4);
+    EXPECT_EQ(logged[0].value, 0xAB);
+    EXPECT_EQ(logged[0].time, 150);
+    EXPECT_EQ(logged[1].type, TELEMETRY_TRACE_LINE);
+    EXPECT_EQ(logged[1].arg, 1);
+    EXPECT_EQ(logged[1].value, 20);
+    EXPECT_EQ(logged[2].type, TELEMETRY_TRACE_LINE);
+    EXPECT_EQ(logged[2].arg, 1 | TELEMETRY_TRACE_LINE_AFTER);
+    EXPECT_EQ(logged[2].value, 30);
+
+    verify_traced_variables("test", 40);
+    EXPECT_EQ(records().size(), 0);
+}
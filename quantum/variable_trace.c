@@ -18,6 +18,22 @@
 #include <stddef.h>
 #include <string.h>
 
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#else
+#define strcmp_P strcmp
+#endif
+
+#ifdef TELEMETRY_ENABLE
+/* The changes are logged as telemetry events, with the variable index and
+ * the byte offset in the arg
+ */
+#include "telemetry.h"
+#if NUM_TRACED_VARIABLES > 16 || MAX_VARIABLE_TRACE_SIZE > 16
+#error "Telemetry can only trace 16 variables of up to 16 bytes"
+#endif
+#else
+
 #ifdef NO_PRINT
 #error "You need undef NO_PRINT to use the variable trace feature"
 #endif
@@ -26,8 +42,11 @@
 #error "The console needs to be enabled in the makefile to use the variable trace feature"
 #endif
 
+#endif
 
-#define NUM_TRACED_VARIABLES 1
+#ifndef NUM_TRACED_VARIABLES
+    #define NUM_TRACED_VARIABLES 1
+#endif
 #ifndef MAX_VARIABLE_TRACE_SIZE
     #define MAX_VARIABLE_TRACE_SIZE 4
 #endif
@@ -44,6 +63,50 @@ typedef struct {
 
 static traced_variable_t traced_variables[NUM_TRACED_VARIABLES];
 
+#ifdef TELEMETRY_ENABLE
+
+static void log_value(uint8_t index, const uint8_t* addr, uint8_t size) {
+    for (uint8_t offset = 0; offset < size; offset += 2) {
+        uint16_t value = addr[offset];
+        if (offset + 1 < size) {
+            value |= addr[offset + 1] << 8;
+        }
+        telemetry_record(TELEMETRY_TRACE_VALUE, index << 4 | offset, value);
+    }
+}
+
+static void log_change(uint8_t index, const traced_variable_t* t, const char* func, int line) {
+    log_value(index, t->addr, t->size);
+    telemetry_record(TELEMETRY_TRACE_LINE, index, t->line);
+    telemetry_record(TELEMETRY_TRACE_LINE, index | TELEMETRY_TRACE_LINE_AFTER, line);
+}
+
+#else
+
+static void log_change(uint8_t index, const traced_variable_t* t, const char* func, int line) {
+#if defined(__AVR__)
+    xprintf("Traced variable \"%S\" has been modified\n", t->name);
+    xprintf("Between %S:%d\n", t->func, t->line);
+    xprintf("And %S:%d\n", func, line);
+#else
+    xprintf("Traced variable \"%s\" has been modified\n", t->name);
+    xprintf("Between %s:%d\n", t->func, t->line);
+    xprintf("And %s:%d\n", func, line);
+#endif
+    xprintf("Previous value ");
+    for (int j=0; j<t->size;j++) {
+        print_hex8(t->last_value[j]);
+    }
+    xprintf("\nNew value ");
+    uint8_t* addr = (uint8_t*)(t->addr);
+    for (int j=0; j<t->size;j++) {
+        print_hex8(addr[j]);
+    }
+    xprintf("\n");
+}
+
+#endif
+
 void add_traced_variable(const char* name, void* addr, unsigned size, const char* func, int line) {
     verify_traced_variables(func, line);
     if (size > MAX_VARIABLE_TRACE_SIZE) {
@@ -59,7 +122,7 @@ void add_traced_variable(const char* name, void* addr, unsigned size, const char
         if (index == -1 && traced_variables[i].addr == NULL){
             index = i;
         }
-        else if (strcmp_P(name, traced_variables[i].name)==0) {
+        else if (traced_variables[i].name && strcmp_P(name, traced_variables[i].name)==0) {
             index = i;
             break;
         }
@@ -77,13 +140,16 @@ void add_traced_variable(const char* name, void* addr, unsigned size, const char
     t->func = func;
     t->line = line;
     memcpy(&t->last_value[0], addr, size);
+#ifdef TELEMETRY_ENABLE
+    log_value(index, t->last_value, size);
+#endif
 
 }
 
 void remove_traced_variable(const char* name, const char* func, int line) {
     verify_traced_variables(func, line);
     for (int i = 0; i < NUM_TRACED_VARIABLES; i++) {
-        if (strcmp_P(name, traced_variables[i].name)==0) {
+        if (traced_variables[i].name && strcmp_P(name, traced_variables[i].name)==0) {
             traced_variables[i].name = 0;
             traced_variables[i].addr = NULL;
             break;
@@ -96,27 +162,8 @@ void verify_traced_variables(const char* func, int line) {
         traced_variable_t* t = &traced_variables[i];
         if (t->addr != NULL && t->name != NULL) {
             if (memcmp(t->last_value, t->addr, t->size)!=0){
-#if defined(__AVR__)
-               xprintf("Traced variable \"%S\" has been modified\n", t->name);
-               xprintf("Between %S:%d\n", t->func, t->line);
-               xprintf("And %S:%d\n", func, line);
-
-#else
-               xprintf("Traced variable \"%s\" has been modified\n", t->name);
-               xprintf("Between %s:%d\n", t->func, t->line);
-               xprintf("And %s:%d\n", func, line);
-#endif
-               xprintf("Previous value ");
-               for (int j=0; j<t->size;j++) {
-                   print_hex8(t->last_value[j]);
-               }
-               xprintf("\nNew value ");
-               uint8_t* addr = (uint8_t*)(t->addr);
-               for (int j=0; j<t->size;j++) {
-                   print_hex8(addr[j]);
-               }
-               xprintf("\n");
-               memcpy(t->last_value, addr, t->size);
+               log_change(i, t, func, line);
+               memcpy(t->last_value, t->addr, t->size);
            }
         }
 
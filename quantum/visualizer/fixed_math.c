@@ -0,0 +1,43 @@
+#include "fixed_math.h"
+
+// sin() of the first quarter turn in 64 steps, the rest is interpolated
+static const int16_t quarter_sine[65] = {
+    0, 804, 1608, 2411, 3212, 4011, 4808, 5602,
+    6393, 7180, 7962, 8740, 9512, 10279, 11039, 11793,
+    12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531,
+    18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+    23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791,
+    27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+    30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972,
+    32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+    32767,
+};
+
+uint32_t fixed_progress(int position, int length) {
+    if (length <= 0 || position >= length) {
+        return FIXED_ONE;
+    }
+    if (position <= 0) {
+        return 0;
+    }
+    return ((uint32_t)position << 16) / (uint32_t)length;
+}
+
+int fixed_lerp(int from, int to, uint32_t progress) {
+    // division rather than a shift, so that it rounds towards from either way
+    return from + (int32_t)(to - from) * (int32_t)progress / (int32_t)FIXED_ONE;
+}
+
+int16_t fixed_sin(uint16_t angle) {
+    uint16_t x = angle & 0x3FFF;
+    // the second and fourth quarter mirror the first
+    if (angle & 0x4000) {
+        x = 0x4000 - x;
+    }
+    uint8_t index = x >> 8;
+    int16_t value = quarter_sine[index];
+    if (index < 64) {
+        value += ((int32_t)(quarter_sine[index + 1] - value) * (x & 0xFF)) >> 8;
+    }
+    return (angle & 0x8000) ? -value : value;
+}
@@ -0,0 +1,32 @@
+#ifndef FIXED_MATH_H
+#define FIXED_MATH_H
+
+#include <stdint.h>
+
+/* Integer math for the visualizer keyframes
+ *
+ * Keyframes run every few milliseconds for every LED, so they avoid float
+ * and the soft-float library. Time within a frame is a Q16 fraction, where
+ * FIXED_ONE is the end of the frame, and angles are a uint16_t fraction of a
+ * full turn, so they wrap around by themselves.
+ */
+
+#define FIXED_ONE 0x10000UL
+#define FIXED_TURN(degrees) ((uint16_t)((degrees) * 0x10000UL / 360))
+
+/* How far position is into a frame of the given length, in [0, FIXED_ONE] */
+uint32_t fixed_progress(int position, int length);
+/* from at progress 0 and to at FIXED_ONE */
+int fixed_lerp(int from, int to, uint32_t progress);
+
+/* Q15, so -32767 to 32767 */
+int16_t fixed_sin(uint16_t angle);
+static inline int16_t fixed_cos(uint16_t angle) {
+    return fixed_sin(angle + FIXED_TURN(90));
+}
+/* (cos(angle) + 1) / 2 scaled to 0-255, for waves of brightness */
+static inline uint8_t fixed_cos_luma(uint16_t angle) {
+    return ((int32_t)(fixed_cos(angle) + 32768) * 255 + 32768) >> 16;
+}
+
+#endif
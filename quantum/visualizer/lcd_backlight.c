@@ -23,7 +23,7 @@ SOFTWARE.
 */
 
 #include "lcd_backlight.h"
-#include <math.h>
+#include "fixed_math.h"
 
 static uint8_t current_hue = 0;
 static uint8_t current_saturation = 0;
@@ -38,41 +38,56 @@ void lcd_backlight_init(void) {
 // This code is based on Brian Neltner's blogpost and example code
 // "Why every LED light should be using HSI colorspace".
 // http://blog.saikoled.com/post/43693602826/why-every-led-light-should-be-using-hsi
-static void hsi_to_rgb(float h, float s, float i, uint16_t* r_out, uint16_t* g_out, uint16_t* b_out) {
-    unsigned int r, g, b;
-    h = fmodf(h, 360.0f); // cycle h around to 0-360 degrees
-    h = 3.14159f * h / 180.0f; // Convert to radians.
-    s = s > 0.0f ? (s < 1.0f ? s : 1.0f) : 0.0f; // clamp s and i to interval [0,1]
-    i = i > 0.0f ? (i < 1.0f ? i : 1.0f) : 0.0f;
+// The hue is 0-255 for a full turn, the saturation 0-255 and the intensity
+// 0-65025, the product of two 0-255 values.
+static void hsi_to_rgb(uint8_t hue, uint8_t saturation, uint16_t intensity, uint16_t* r_out, uint16_t* g_out, uint16_t* b_out) {
+    // The hue circle is split into three sectors of 120 degrees, with the
+    // same math for each of them, but the colors rotated
+    uint16_t h = hue * 3;
+    uint8_t sector = h / 255;
+    h = (uint32_t)(h % 255) * 0x10000 / (3 * 255);
+    if (sector == 3) {
+        sector = 0;
+    }
 
     // Math! Thanks in part to Kyle Miller.
-    if(h < 2.09439f) {
-        r = 65535.0f * i/3.0f *(1.0f + s * cos(h) / cosf(1.047196667f - h));
-        g = 65535.0f * i/3.0f *(1.0f + s *(1.0f - cosf(h) / cos(1.047196667f - h)));
-        b = 65535.0f * i/3.0f *(1.0f - s);
-    } else if(h < 4.188787) {
-        h = h - 2.09439;
-        g = 65535.0f * i/3.0f *(1.0f + s * cosf(h) / cosf(1.047196667f - h));
-        b = 65535.0f * i/3.0f *(1.0f + s * (1.0f - cosf(h) / cosf(1.047196667f - h)));
-        r = 65535.0f * i/3.0f *(1.0f - s);
-    } else {
-        h = h - 4.188787;
-        b = 65535.0f*i/3.0f * (1.0f + s * cosf(h) / cosf(1.047196667f - h));
-        r = 65535.0f*i/3.0f * (1.0f + s * (1.0f - cosf(h) / cosf(1.047196667f - h)));
-        g = 65535.0f*i/3.0f * (1.0f - s);
+    // cos(h) / cos(60 - h) is between -1 and 2, so the Q14 products fit
+    int32_t ratio = ((int32_t)fixed_cos(h) << 14) / fixed_cos(FIXED_TURN(60) - h);
+    int32_t s = ((int32_t)saturation << 14) / 255;
+    int32_t s_ratio = (s * ratio) >> 14;
+    int32_t base = (uint32_t)intensity * 65535 / (3 * 65025);
+    uint32_t first = base + ((base * s_ratio) >> 14);
+    uint32_t second = base + ((base * (s - s_ratio)) >> 14);
+    uint32_t rest = base - ((base * s) >> 14);
+    if (first > 65535) {
+        first = 65535;
+    }
+    if (second > 65535) {
+        second = 65535;
+    }
+
+    switch (sector) {
+    case 0:
+        *r_out = first;
+        *g_out = second;
+        *b_out = rest;
+        break;
+    case 1:
+        *g_out = first;
+        *b_out = second;
+        *r_out = rest;
+        break;
+    default:
+        *b_out = first;
+        *r_out = second;
+        *g_out = rest;
+        break;
     }
-    *r_out = r > 65535 ? 65535 : r;
-    *g_out = g > 65535 ? 65535 : g;
-    *b_out = b > 65535 ? 65535 : b;
 }
 
 void lcd_backlight_color(uint8_t hue, uint8_t saturation, uint8_t intensity) {
     uint16_t r, g, b;
-    float hue_f = 360.0f * (float)hue / 255.0f;
-    float saturation_f = (float)saturation / 255.0f;
-    float intensity_f = (float)intensity / 255.0f;
-    intensity_f *= (float)current_brightness / 255.0f;
-    hsi_to_rgb(hue_f, saturation_f, intensity_f, &r, &g, &b);
+    hsi_to_rgb(hue, saturation, intensity * current_brightness, &r, &g, &b);
 	current_hue = hue;
 	current_saturation = saturation;
 	current_intensity = intensity;
@@ -17,8 +17,7 @@
 #include "lcd_backlight_keyframes.h"
 
 bool backlight_keyframe_animate_color(keyframe_animation_t* animation, visualizer_state_t* state) {
-    int frame_length = animation->frame_lengths[animation->current_frame];
-    int current_pos = frame_length - animation->time_left_in_frame;
+    uint32_t progress = keyframe_animation_progress(animation);
     uint8_t t_h = LCD_HUE(state->target_lcd_color);
     uint8_t t_s = LCD_SAT(state->target_lcd_color);
     uint8_t t_i = LCD_INT(state->target_lcd_color);
@@ -33,13 +32,10 @@ bool backlight_keyframe_animate_color(keyframe_animation_t* animation, visualize
     int d_s = t_s - p_s;
     int d_i = t_i - p_i;
 
-    int hue = (d_h * current_pos) / frame_length;
-    int sat = (d_s * current_pos) / frame_length;
-    int intensity = (d_i * current_pos) / frame_length;
+    int hue = fixed_lerp(p_h, p_h + d_h, progress);
+    int sat = fixed_lerp(p_s, t_s, progress);
+    int intensity = fixed_lerp(p_i, t_i, progress);
     //dprintf("%X -> %X = %X\n", p_h, t_h, hue);
-    hue += p_h;
-    sat += p_s;
-    intensity += p_i;
     state->current_lcd_color = LCD_COLOR(hue, sat, intensity);
     lcd_backlight_color(
             LCD_HUE(state->current_lcd_color),
@@ -22,16 +22,11 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include "gfx.h"
-#include "math.h"
+#include "fixed_math.h"
 #include "led_keyframes.h"
 
 static uint8_t fade_led_color(keyframe_animation_t* animation, int from, int to) {
-    int frame_length = animation->frame_lengths[animation->current_frame];
-    int current_pos = frame_length - animation->time_left_in_frame;
-    int delta = to - from;
-    int luma = (delta * current_pos) / frame_length;
-    luma += from;
-    return luma;
+    return fixed_lerp(from, to, keyframe_animation_progress(animation));
 }
 
 static void keyframe_fade_all_leds_from_to(keyframe_animation_t* animation, uint8_t from, uint8_t to) {
@@ -47,12 +42,13 @@ static void keyframe_fade_all_leds_from_to(keyframe_animation_t* animation, uint
 static uint8_t crossfade_start_frame[NUM_ROWS][NUM_COLS];
 static uint8_t crossfade_end_frame[NUM_ROWS][NUM_COLS];
 
-static uint8_t compute_gradient_color(float t, float index, float num) {
-    const float two_pi = M_PI * 2.0f;
-    float normalized_index = (1.0f - index / (num - 1.0f)) * two_pi;
-    float x = t * two_pi + normalized_index;
-    float v = 0.5 * (cosf(x) + 1.0f);
-    return (uint8_t)(255.0f * v);
+static uint8_t compute_gradient_color(uint32_t t, int index, int num) {
+    // one turn over the frame, and one turn across the LEDs
+    uint16_t x = t;
+    if (num > 1) {
+        x -= (uint32_t)index * 0x10000 / (num - 1);
+    }
+    return fixed_cos_luma(x);
 }
 
 bool led_keyframe_fade_in_all(keyframe_animation_t* animation, visualizer_state_t* state) {
@@ -69,9 +65,7 @@ bool led_keyframe_fade_out_all(keyframe_animation_t* animation, visualizer_state
 
 bool led_keyframe_left_to_right_gradient(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)state;
-    float frame_length = animation->frame_lengths[animation->current_frame];
-    float current_pos = frame_length - animation->time_left_in_frame;
-    float t = current_pos / frame_length;
+    uint32_t t = keyframe_animation_progress(animation);
     for (int i=0; i< NUM_COLS; i++) {
         uint8_t color = compute_gradient_color(t, i, NUM_COLS);
         gdispGDrawLine(LED_DISPLAY, i, 0, i, NUM_ROWS - 1, LUMA2COLOR(color));
@@ -81,9 +75,7 @@ bool led_keyframe_left_to_right_gradient(keyframe_animation_t* animation, visual
 
 bool led_keyframe_top_to_bottom_gradient(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)state;
-    float frame_length = animation->frame_lengths[animation->current_frame];
-    float current_pos = frame_length - animation->time_left_in_frame;
-    float t = current_pos / frame_length;
+    uint32_t t = keyframe_animation_progress(animation);
     for (int i=0; i< NUM_ROWS; i++) {
         uint8_t color = compute_gradient_color(t, i, NUM_ROWS);
         gdispGDrawLine(LED_DISPLAY, 0, i, NUM_COLS - 1, i, LUMA2COLOR(color));
@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+#include <math.h>
+
+extern "C" {
+#include "fixed_math.h"
+#include "lcd_backlight.h"
+
+static uint16_t hal_r, hal_g, hal_b;
+
+void lcd_backlight_hal_init(void) {
+}
+
+void lcd_backlight_hal_color(uint16_t r, uint16_t g, uint16_t b) {
+    hal_r = r;
+    hal_g = g;
+    hal_b = b;
+}
+}
+
+// The float implementations the fixed point ones replaced
+
+static uint8_t float_gradient_color(float t, float index, float num) {
+    const float two_pi = M_PI * 2.0f;
+    float normalized_index = (1.0f - index / (num - 1.0f)) * two_pi;
+    float x = t * two_pi + normalized_index;
+    float v = 0.5 * (cosf(x) + 1.0f);
+    return (uint8_t)(255.0f * v);
+}
+
+static void float_hsi_to_rgb(float h, float s, float i, uint16_t* r_out, uint16_t* g_out, uint16_t* b_out) {
+    unsigned int r, g, b;
+    h = fmodf(h, 360.0f);
+    h = 3.14159f * h / 180.0f;
+    s = s > 0.0f ? (s < 1.0f ? s : 1.0f) : 0.0f;
+    i = i > 0.0f ? (i < 1.0f ? i : 1.0f) : 0.0f;
+
+    if(h < 2.09439f) {
+        r = 65535.0f * i/3.0f *(1.0f + s * cos(h) / cosf(1.047196667f - h));
+        g = 65535.0f * i/3.0f *(1.0f + s *(1.0f - cosf(h) / cos(1.047196667f - h)));
+        b = 65535.0f * i/3.0f *(1.0f - s);
+    } else if(h < 4.188787) {
+        h = h - 2.09439;
+        g = 65535.0f * i/3.0f *(1.0f + s * cosf(h) / cosf(1.047196667f - h));
+        b = 65535.0f * i/3.0f *(1.0f + s * (1.0f - cosf(h) / cosf(1.047196667f - h)));
+        r = 65535.0f * i/3.0f *(1.0f - s);
+    } else {
+        h = h - 4.188787;
+        b = 65535.0f*i/3.0f * (1.0f + s * cosf(h) / cosf(1.047196667f - h));
+        r = 65535.0f*i/3.0f * (1.0f + s * (1.0f - cosf(h) / cosf(1.047196667f - h)));
+        g = 65535.0f*i/3.0f * (1.0f - s);
+    }
+    *r_out = r > 65535 ? 65535 : r;
+    *g_out = g > 65535 ? 65535 : g;
+    *b_out = b > 65535 ? 65535 : b;
+}
+
+TEST(FixedMath, SineFollowsTheFloatVersion) {
+    for (uint32_t angle = 0; angle < 0x10000; angle++) {
+        float expected = 32767.0f * sinf(angle * 2.0f * M_PI / 0x10000);
+        ASSERT_NEAR(fixed_sin(angle), expected, 4) << "angle " << angle;
+        ASSERT_NEAR(fixed_cos(angle), 32767.0f * cosf(angle * 2.0f * M_PI / 0x10000), 4) << "angle " << angle;
+    }
+}
+
+TEST(FixedMath, ProgressCoversTheWholeFrame) {
+    EXPECT_EQ(fixed_progress(0, 300), 0);
+    EXPECT_EQ(fixed_progress(150, 300), FIXED_ONE / 2);
+    EXPECT_EQ(fixed_progress(300, 300), FIXED_ONE);
+    EXPECT_EQ(fixed_progress(-5, 300), 0);
+    EXPECT_EQ(fixed_progress(301, 300), FIXED_ONE);
+    EXPECT_EQ(fixed_progress(0, 0), FIXED_ONE);
+}
+
+TEST(FixedMath, LerpMatchesIntegerFades) {
+    const int length = 1000;
+    for (int pos = 0; pos <= length; pos++) {
+        uint32_t progress = fixed_progress(pos, length);
+        for (int from : {0, 17, 255}) {
+            for (int to : {0, 100, 255}) {
+                int expected = from + (to - from) * pos / length;
+                ASSERT_NEAR(fixed_lerp(from, to, progress), expected, 1) << from << " to " << to << " at " << pos;
+            }
+        }
+    }
+    EXPECT_EQ(fixed_lerp(255, 0, FIXED_ONE), 0);
+    EXPECT_EQ(fixed_lerp(0, 255, FIXED_ONE), 255);
+    EXPECT_EQ(fixed_lerp(255, 0, 0), 255);
+}
+
+TEST(FixedMath, GradientMatchesTheFloatVersion) {
+    const int length = 2000;
+    for (int num : {2, 7, 16}) {
+        for (int pos = 0; pos <= length; pos += 5) {
+            uint32_t t = fixed_progress(pos, length);
+            for (int i = 0; i < num; i++) {
+                // the same as compute_gradient_color() in led_keyframes.c
+                uint16_t x = t - (uint32_t)i * 0x10000 / (num - 1);
+                float expected = float_gradient_color((float)pos / length, i, num);
+                ASSERT_NEAR(fixed_cos_luma(x), expected, 1) << "led " << i << "/" << num << " at " << pos;
+            }
+        }
+    }
+    EXPECT_EQ(fixed_cos_luma(0), 255);
+    EXPECT_EQ(fixed_cos_luma(FIXED_TURN(180)), 0);
+}
+
+TEST(FixedMath, BacklightColorMatchesTheFloatVersion) {
+    for (int brightness : {0, 100, 255}) {
+        lcd_backlight_brightness(brightness);
+        for (int hue = 0; hue < 256; hue++) {
+            for (int saturation = 0; saturation < 256; saturation += 15) {
+                for (int intensity = 0; intensity < 256; intensity += 51) {
+                    uint16_t r, g, b;
+                    float_hsi_to_rgb(360.0f * hue / 255.0f, saturation / 255.0f,
+                        intensity / 255.0f * brightness / 255.0f, &r, &g, &b);
+                    lcd_backlight_color(hue, saturation, intensity);
+                    // within 0.1% of the full range
+                    ASSERT_NEAR(hal_r, r, 66) << hue << " " << saturation << " " << intensity;
+                    ASSERT_NEAR(hal_g, g, 66) << hue << " " << saturation << " " << intensity;
+                    ASSERT_NEAR(hal_b, b, 66) << hue << " " << saturation << " " << intensity;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,7 @@
+VISUALIZER_TEST_PATH := $(QUANTUM_PATH)/visualizer
+
+visualizer_fixed_math_SRC :=\
+	$(VISUALIZER_TEST_PATH)/tests/fixed_math_tests.cpp \
+	$(VISUALIZER_TEST_PATH)/fixed_math.c \
+	$(VISUALIZER_TEST_PATH)/lcd_backlight.c
+visualizer_fixed_math_INC := $(VISUALIZER_TEST_PATH)
@@ -30,6 +30,7 @@ SOFTWARE.
 
 #include "config.h"
 #include "gfx.h"
+#include "fixed_math.h"
 
 #ifdef LCD_BACKLIGHT_ENABLE
 #include "lcd_backlight.h"
@@ -125,6 +126,13 @@ typedef struct keyframe_animation_t {
 
 } keyframe_animation_t;
 
+// How far the animation is into the current frame, as a fixed_math.h fraction
+// from 0 to FIXED_ONE, this should be used instead of float by the keyframes
+static inline uint32_t keyframe_animation_progress(keyframe_animation_t* animation) {
+    int frame_length = animation->frame_lengths[animation->current_frame];
+    return fixed_progress(frame_length - animation->time_left_in_frame, frame_length);
+}
+
 extern GDisplay* LCD_DISPLAY;
 extern GDisplay* LED_DISPLAY;
 
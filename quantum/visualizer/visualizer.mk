@@ -21,7 +21,8 @@
 # SOFTWARE.
 
 SRC += $(VISUALIZER_DIR)/visualizer.c \
-	$(VISUALIZER_DIR)/visualizer_keyframes.c
+	$(VISUALIZER_DIR)/visualizer_keyframes.c \
+	$(VISUALIZER_DIR)/fixed_math.c
 EXTRAINCDIRS += $(GFXINC) $(VISUALIZER_DIR)
 GFXLIB = $(LIB_PATH)/ugfx
 VPATH += $(VISUALIZER_PATH)
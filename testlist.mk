@@ -2,6 +2,11 @@ TEST_LIST = $(notdir $(patsubst %/rules.mk,%,$(wildcard $(ROOT_DIR)/tests/*/rule
 FULL_TESTS := $(TEST_LIST)
 
 include $(ROOT_DIR)/quantum/serial_link/tests/testlist.mk
+include $(ROOT_DIR)/tmk_core/protocol/lufa/tests/testlist.mk
+include $(ROOT_DIR)/tmk_core/protocol/midi/tests/testlist.mk
+include $(ROOT_DIR)/tmk_core/common/tests/testlist.mk
+include $(ROOT_DIR)/quantum/visualizer/tests/testlist.mk
+include $(ROOT_DIR)/quantum/tests/testlist.mk
 
 define VALIDATE_TEST_LIST
     ifneq ($1,)
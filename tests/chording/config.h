@@ -0,0 +1,9 @@
+#ifndef TESTS_CHORDING_CONFIG_H_
+#define TESTS_CHORDING_CONFIG_H_
+
+#define MATRIX_ROWS 2
+#define MATRIX_COLS 2
+
+#define CHORD_COUNT 4
+
+#endif /* TESTS_CHORDING_CONFIG_H_ */
@@ -0,0 +1,2 @@
+CUSTOM_MATRIX=yes
+CHORDING_ENABLE=yes
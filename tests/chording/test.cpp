@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include <vector>
+#include <utility>
+
+extern "C" {
+#include "quantum.h"
+}
+#include "test_driver.h"
+#include "test_matrix.h"
+#include "keyboard_report_util.h"
+#include "test_fixture.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+using testing::InSequence;
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+	[0] = {
+	    {CH(0), CH(1)},
+	    {CH(2), KC_D}
+	},
+};
+
+const chord_t PROGMEM chord_dictionary[CHORD_COUNT] = {
+    CHORD(CHORD_KEY(0), "a"),
+    CHORD(CHORD_KEY(1), "B"),
+    CHORD(CHORD_KEY(0) | CHORD_KEY(1), "the"),
+    CHORD(CHORD_KEY(0) | CHORD_KEY(1) | CHORD_KEY(2), "\n"),
+};
+
+static chord_mask_t unmatched;
+
+extern "C" void chording_unmatched_user(chord_mask_t mask) {
+    unmatched = mask;
+}
+
+class Chording : public TestFixture {
+public:
+    Chording() {
+        unmatched = 0;
+    }
+
+    // presses the keys in order, then releases them in the same order
+    void chord(std::vector<std::pair<uint8_t, uint8_t>> keys) {
+        for (auto key : keys) {
+            press_key(key.first, key.second);
+            keyboard_task();
+        }
+        for (auto key : keys) {
+            release_key(key.first, key.second);
+            keyboard_task();
+        }
+    }
+};
+
+TEST_F(Chording, SingleKeyChordTypesItsOutput) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(0, 0);
+    keyboard_task();
+    release_key(0, 0);
+    keyboard_task();
+}
+
+TEST_F(Chording, OutputIsTypedOnceEveryKeyIsReleased) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(0, 0);
+    keyboard_task();
+    press_key(1, 0);
+    keyboard_task();
+    release_key(0, 0);
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_T)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_H)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_E)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(1, 0);
+    keyboard_task();
+}
+
+TEST_F(Chording, ShiftedAndControlCharactersAreTyped) {
+    TestDriver driver;
+    std::vector<report_keyboard_t> reports;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber())
+        .WillRepeatedly(Invoke([&reports](report_keyboard_t& report) {
+            reports.push_back(report);
+        }));
+    chord({{1, 0}});
+    ASSERT_EQ(reports.size(), 2);
+    EXPECT_EQ(reports[0].mods, MOD_BIT(KC_LSFT));
+    EXPECT_EQ(reports[0].keys[0], KC_B);
+    EXPECT_EQ(reports[1].mods, 0);
+    chord({{0, 0}, {1, 0}, {0, 1}});
+    ASSERT_EQ(reports.size(), 4);
+    EXPECT_EQ(reports[2].mods, 0);
+    EXPECT_EQ(reports[2].keys[0], KC_ENTER);
+}
+
+TEST_F(Chording, UnknownChordsGoToTheUser) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    chord({{0, 1}, {1, 0}});
+    EXPECT_EQ(unmatched, CHORD_KEY(1) | CHORD_KEY(2));
+}
+
+TEST_F(Chording, OtherKeysPassThrough) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(1, 1);
+    keyboard_task();
+    release_key(1, 1);
+    keyboard_task();
+}
@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include <vector>
+
+extern "C" {
+#include "quantum.h"
+#include "eeprom.h"
+}
+#include "test_driver.h"
+#include "test_matrix.h"
+#include "keyboard_report_util.h"
+#include "test_fixture.h"
+#include "test_eeprom.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+	[0] = {
+	    {KC_A, KC_B},
+	    {KC_C, MO(1)}
+	},
+	[1] = {
+	    {KC_1, KC_2},
+	    {KC_3, KC_TRNS}
+	},
+};
+
+static_assert(DYNAMIC_KEYMAP_RAM_SIZE == DYNAMIC_KEYMAP_KEY_COUNT * 2,
+    "a 2x2 keymap with 2 layers is mirrored whole, and takes no more RAM than that");
+
+static std::vector<uint8_t> make_page(uint16_t offset, std::vector<uint16_t> keycodes) {
+    std::vector<uint8_t> page = {uint8_t(offset >> 8), uint8_t(offset & 0xFF), uint8_t(keycodes.size()), 0};
+    for (uint16_t keycode : keycodes) {
+        page.push_back(keycode >> 8);
+        page.push_back(keycode & 0xFF);
+    }
+    uint8_t crc = dynamic_keymap_crc(0, page.data(), 3);
+    page[3] = dynamic_keymap_crc(crc, page.data() + DYNAMIC_KEYMAP_PAGE_HEADER, keycodes.size() * 2);
+    return page;
+}
+
+static uint16_t page_keycode(const uint8_t* page, uint8_t index) {
+    const uint8_t* data = page + DYNAMIC_KEYMAP_PAGE_HEADER + index * 2;
+    return (data[0] << 8) | data[1];
+}
+
+class DynamicKeymap : public TestFixture {
+public:
+    DynamicKeymap() {
+        eeprom_reset();
+        dynamic_keymap_init();
+        // writing the magic isn't counted
+        eeprom_reset_counts();
+    }
+
+    uint8_t write(std::vector<uint8_t> page) {
+        return dynamic_keymap_write_page(page.data(), page.size());
+    }
+
+    void tap_and_expect(uint8_t col, uint8_t row, uint8_t keycode) {
+        TestDriver driver;
+        InSequence s;
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(keycode)));
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+        press_key(col, row);
+        keyboard_task();
+        release_key(col, row);
+        keyboard_task();
+    }
+};
+
+TEST_F(DynamicKeymap, FlashKeymapIsUsedWithoutOverrides) {
+    tap_and_expect(0, 0, KC_A);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+}
+
+TEST_F(DynamicKeymap, WrittenPageChangesTheKeymap) {
+    EXPECT_EQ(write(make_page(0, {KC_X, KC_Y})), DYNAMIC_KEYMAP_OK);
+    tap_and_expect(0, 0, KC_X);
+    tap_and_expect(1, 0, KC_Y);
+    tap_and_expect(0, 1, KC_C);
+}
+
+TEST_F(DynamicKeymap, OverridesOnHigherLayers) {
+    EXPECT_EQ(write(make_page(6, {KC_Z})), DYNAMIC_KEYMAP_OK);
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    press_key(1, 1);
+    keyboard_task();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    press_key(0, 1);
+    keyboard_task();
+    release_key(0, 1);
+    release_key(1, 1);
+    keyboard_task();
+}
+
+TEST_F(DynamicKeymap, PagesAreReadFromTheKeymapInUse) {
+    write(make_page(3, {KC_ESC}));
+    uint8_t page[DYNAMIC_KEYMAP_PAGE_MAX];
+    EXPECT_EQ(dynamic_keymap_read_page(2, 10, page), DYNAMIC_KEYMAP_PAGE_HEADER + 3 * 2);
+    EXPECT_EQ(page[0], 0);
+    EXPECT_EQ(page[1], 2);
+    EXPECT_EQ(page[2], 3);
+    EXPECT_EQ(page_keycode(page, 0), KC_C);
+    EXPECT_EQ(page_keycode(page, 1), KC_ESC);
+    EXPECT_EQ(page_keycode(page, 2), KC_1);
+    EXPECT_EQ(page[3], make_page(2, {KC_C, KC_ESC, KC_1})[3]);
+}
+
+TEST_F(DynamicKeymap, ReadsStopAtTheEndOfTheKeymap) {
+    uint8_t page[DYNAMIC_KEYMAP_PAGE_MAX];
+    EXPECT_EQ(dynamic_keymap_read_page(7, 3, page), DYNAMIC_KEYMAP_PAGE_HEADER + 2);
+    EXPECT_EQ(page[2], 1);
+    EXPECT_EQ(page_keycode(page, 0), KC_TRNS);
+    EXPECT_EQ(dynamic_keymap_read_page(8, 3, page), DYNAMIC_KEYMAP_PAGE_HEADER);
+    EXPECT_EQ(page[2], 0);
+}
+
+TEST_F(DynamicKeymap, CorruptPagesAreRejected) {
+    std::vector<uint8_t> page = make_page(0, {KC_X});
+    page[5] ^= 1;
+    EXPECT_EQ(write(page), DYNAMIC_KEYMAP_BAD_CRC);
+    page = make_page(0, {KC_X});
+    page.pop_back();
+    EXPECT_EQ(write(page), DYNAMIC_KEYMAP_BAD_CRC);
+    EXPECT_EQ(write(make_page(7, {KC_X, KC_Y})), DYNAMIC_KEYMAP_BAD_RANGE);
+    EXPECT_EQ(eeprom_total_write_count(), 0);
+    tap_and_expect(0, 0, KC_A);
+}
+
+TEST_F(DynamicKeymap, UnchangedKeycodesAreNotWrittenAgain) {
+    write(make_page(0, {KC_X, KC_Y, KC_Z}));
+    uint32_t writes = eeprom_total_write_count();
+    EXPECT_GT(writes, 0);
+    write(make_page(0, {KC_X, KC_Y, KC_Z}));
+    EXPECT_EQ(eeprom_total_write_count(), writes);
+}
+
+TEST_F(DynamicKeymap, StoredKeycodesAreLoadedAtInit) {
+    write(make_page(1, {KC_X}));
+    dynamic_keymap_init();
+    tap_and_expect(1, 0, KC_X);
+}
+
+TEST_F(DynamicKeymap, HeldKeyKeepsItsKeycodeUntilReleased) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(0, 0);
+    keyboard_task();
+    EXPECT_EQ(write(make_page(0, {KC_X})), DYNAMIC_KEYMAP_OK);
+    keyboard_task();
+    release_key(0, 0);
+    keyboard_task();
+    press_key(0, 0);
+    keyboard_task();
+    release_key(0, 0);
+    keyboard_task();
+}
+
+TEST_F(DynamicKeymap, ResetRestoresTheFlashKeymap) {
+    write(make_page(0, {KC_X}));
+    dynamic_keymap_reset();
+    tap_and_expect(0, 0, KC_A);
+}
+
+TEST_F(DynamicKeymap, EepromOfOtherFirmwareIsNotUsed) {
+    eeprom_fill(0x04);
+    dynamic_keymap_init();
+    tap_and_expect(0, 0, KC_A);
+    tap_and_expect(1, 0, KC_B);
+    EXPECT_EQ(eeprom_read_word(DYNAMIC_KEYMAP_MAGIC_ADDR), DYNAMIC_KEYMAP_MAGIC_NUMBER);
+    // and it stays that way
+    dynamic_keymap_init();
+    tap_and_expect(0, 0, KC_A);
+}
+
+TEST_F(DynamicKeymap, KeymapOfAnotherSizeIsNotUsed) {
+    write(make_page(0, {KC_X}));
+    eeprom_update_word(DYNAMIC_KEYMAP_MAGIC_ADDR, DYNAMIC_KEYMAP_MAGIC_NUMBER ^ 1);
+    dynamic_keymap_init();
+    tap_and_expect(0, 0, KC_A);
+}
+
+TEST_F(DynamicKeymap, EeconfigInitResetsTheKeymap) {
+    write(make_page(0, {KC_X}));
+    eeconfig_init();
+    tap_and_expect(0, 0, KC_A);
+    dynamic_keymap_init();
+    tap_and_expect(0, 0, KC_A);
+}
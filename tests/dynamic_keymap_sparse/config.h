@@ -0,0 +1,13 @@
+#ifndef TESTS_DYNAMIC_KEYMAP_SPARSE_CONFIG_H_
+#define TESTS_DYNAMIC_KEYMAP_SPARSE_CONFIG_H_
+
+#define MATRIX_ROWS 2
+#define MATRIX_COLS 2
+
+#define DYNAMIC_KEYMAP_LAYER_COUNT 2
+#define DYNAMIC_KEYMAP_PAGE_SIZE 3
+// too small for the whole keymap, three overrides fit
+#define DYNAMIC_KEYMAP_RAM_SIZE 8
+
+
+#endif /* TESTS_DYNAMIC_KEYMAP_SPARSE_CONFIG_H_ */
@@ -0,0 +1,2 @@
+CUSTOM_MATRIX=yes
+DYNAMIC_KEYMAP_ENABLE=yes
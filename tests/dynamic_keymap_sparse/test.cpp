@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+extern "C" {
+#include "quantum.h"
+#include "eeprom.h"
+}
+#include "test_driver.h"
+#include "test_matrix.h"
+#include "keyboard_report_util.h"
+#include "test_fixture.h"
+#include "test_eeprom.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+	[0] = {
+	    {KC_A, KC_B},
+	    {KC_C, KC_D}
+	},
+	[1] = {
+	    {KC_1, KC_2},
+	    {KC_3, KC_4}
+	},
+};
+
+// DYNAMIC_KEYMAP_CAPACITY is only defined when the keymap isn't mirrored
+static_assert(DYNAMIC_KEYMAP_CAPACITY == 3, "only the keys that differ from flash are kept");
+
+class DynamicKeymapSparse : public TestFixture {
+public:
+    DynamicKeymapSparse() {
+        eeprom_reset();
+        dynamic_keymap_init();
+    }
+
+    uint16_t keycode(uint16_t index) {
+        return dynamic_keymap_get_keycode(index / 4, (index / 2) % 2, index % 2);
+    }
+};
+
+TEST_F(DynamicKeymapSparse, OverridesAreFoundInAnyOrder) {
+    EXPECT_TRUE(dynamic_keymap_set_keycode(5, KC_Y));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(1, KC_X));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(7, KC_Z));
+    const uint16_t expected[] = {KC_A, KC_X, KC_C, KC_D, KC_1, KC_Y, KC_3, KC_Z};
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(keycode(i), expected[i]) << "key " << i;
+    }
+    EXPECT_TRUE(dynamic_keymap_set_keycode(1, DYNAMIC_KEYMAP_NONE));
+    EXPECT_EQ(keycode(1), KC_B);
+    EXPECT_EQ(keycode(5), KC_Y);
+    EXPECT_EQ(keycode(7), KC_Z);
+}
+
+TEST_F(DynamicKeymapSparse, FullTableRejectsNewOverrides) {
+    EXPECT_TRUE(dynamic_keymap_set_keycode(0, KC_X));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(2, KC_X));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(4, KC_X));
+    EXPECT_FALSE(dynamic_keymap_set_keycode(6, KC_X));
+    EXPECT_EQ(keycode(6), KC_3);
+    EXPECT_EQ(eeprom_read_word(DYNAMIC_KEYMAP_EEPROM_ADDR + 6), DYNAMIC_KEYMAP_NONE);
+
+    // changing an override or setting a key to its flash keycode needs no room
+    EXPECT_TRUE(dynamic_keymap_set_keycode(0, KC_Y));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(6, KC_3));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(2, KC_C));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(6, KC_X));
+    EXPECT_EQ(keycode(0), KC_Y);
+    EXPECT_EQ(keycode(2), KC_C);
+    EXPECT_EQ(keycode(6), KC_X);
+}
+
+TEST_F(DynamicKeymapSparse, OverridesAreUsedByTheKeymap) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    dynamic_keymap_set_keycode(3, KC_X);
+    press_key(1, 1);
+    keyboard_task();
+    release_key(1, 1);
+    keyboard_task();
+}
+
+TEST_F(DynamicKeymapSparse, HeldKeysReserveTheirSlot) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    press_key(0, 0);
+    keyboard_task();
+    EXPECT_TRUE(dynamic_keymap_set_keycode(0, KC_X));
+    EXPECT_EQ(keycode(0), KC_A);
+    EXPECT_TRUE(dynamic_keymap_set_keycode(1, KC_X));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(2, KC_X));
+    EXPECT_FALSE(dynamic_keymap_set_keycode(3, KC_X));
+    release_key(0, 0);
+    keyboard_task();
+    keyboard_task();
+    EXPECT_EQ(keycode(0), KC_X);
+}
+
+TEST_F(DynamicKeymapSparse, EepromOfOtherFirmwareTakesNoSlots) {
+    eeprom_fill(0x04);
+    dynamic_keymap_init();
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(keycode(i), pgm_read_word(&keymaps[i / 4][(i / 2) % 2][i % 2])) << "key " << i;
+    }
+    EXPECT_TRUE(dynamic_keymap_set_keycode(0, KC_X));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(2, KC_X));
+    EXPECT_TRUE(dynamic_keymap_set_keycode(4, KC_X));
+}
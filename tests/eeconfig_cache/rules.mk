@@ -0,0 +1,2 @@
+CUSTOM_MATRIX=yes
+EECONFIG_CACHE_ENABLE=yes
\ No newline at end of file
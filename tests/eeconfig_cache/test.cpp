@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "quantum.h"
+#include "test_driver.h"
+#include "test_fixture.h"
+#include "test_timer.h"
+#include "test_eeprom.h"
+
+extern "C" {
+#include "eeprom.h"
+#include "suspend.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+	[0] = {
+	    {KC_A, KC_B},
+	    {KC_C, KC_D}
+	},
+};
+
+class EeconfigCache : public TestFixture {
+public:
+    EeconfigCache() {
+        // Writes the defaults, including anything left over from other tests
+        eeconfig_init();
+        eeprom_reset_counts();
+    }
+};
+
+TEST_F(EeconfigCache, UpdatesAreNotWrittenImmediately) {
+    eeconfig_update_keymap(0x12);
+    EXPECT_EQ(eeconfig_read_keymap(), 0x12);
+    EXPECT_TRUE(eeconfig_is_dirty());
+    EXPECT_EQ(eeprom_total_write_count(), 0);
+    EXPECT_EQ(eeprom_read_byte(EECONFIG_KEYMAP), 0);
+}
+
+TEST_F(EeconfigCache, UpdatesAreWrittenWhenIdle) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    uint16_t count = eeconfig_write_count((uintptr_t)EECONFIG_KEYMAP);
+    eeconfig_update_keymap(0x12);
+    advance_time(EECONFIG_CACHE_IDLE_TIMEOUT - 1);
+    keyboard_task();
+    EXPECT_EQ(eeprom_total_write_count(), 0);
+    advance_time(1);
+    keyboard_task();
+    EXPECT_FALSE(eeconfig_is_dirty());
+    EXPECT_EQ(eeprom_read_byte(EECONFIG_KEYMAP), 0x12);
+    EXPECT_EQ(eeprom_total_write_count(), 1);
+    EXPECT_EQ(eeconfig_write_count((uintptr_t)EECONFIG_KEYMAP), count + 1);
+}
+
+TEST_F(EeconfigCache, RepeatedUpdatesAreCoalesced) {
+    // Like holding down a hue increase key
+    for (uint32_t hue = 0; hue < 100; hue++) {
+        eeconfig_update_dword(EECONFIG_RGBLIGHT, 0x00FFFF01 | (hue << 8));
+        advance_time(10);
+        eeconfig_task();
+    }
+    advance_time(EECONFIG_CACHE_IDLE_TIMEOUT);
+    eeconfig_task();
+    EXPECT_EQ(eeprom_read_dword(EECONFIG_RGBLIGHT), 0x00FFFF01 | (99 << 8));
+    for (uintptr_t i = 0; i < 4; i++) {
+        EXPECT_LE(eeprom_write_count((uintptr_t)EECONFIG_RGBLIGHT + i), 1);
+    }
+}
+
+TEST_F(EeconfigCache, ContinuousUpdatesAreWrittenAfterMaxDelay) {
+    uint8_t val = 0;
+    uint32_t elapsed = 0;
+    while (eeprom_total_write_count() == 0 && elapsed <= EECONFIG_CACHE_MAX_DELAY) {
+        eeconfig_update_keymap(++val);
+        advance_time(100);
+        elapsed += 100;
+        eeconfig_task();
+    }
+    EXPECT_EQ(elapsed, EECONFIG_CACHE_MAX_DELAY);
+    EXPECT_EQ(eeprom_write_count((uintptr_t)EECONFIG_KEYMAP), 1);
+}
+
+TEST_F(EeconfigCache, RevertedUpdatesAreNotWritten) {
+    eeconfig_update_default_layer(3);
+    eeconfig_update_default_layer(0);
+    eeconfig_flush();
+    EXPECT_EQ(eeprom_total_write_count(), 0);
+    EXPECT_FALSE(eeconfig_is_dirty());
+}
+
+TEST_F(EeconfigCache, SuspendFlushesTheCache) {
+    eeconfig_update_debug(1);
+    eeconfig_update_keymap(2);
+    suspend_power_down();
+    EXPECT_EQ(eeprom_read_byte(EECONFIG_DEBUG), 1);
+    EXPECT_EQ(eeprom_read_byte(EECONFIG_KEYMAP), 2);
+    EXPECT_EQ(eeprom_total_write_count(), 2);
+}
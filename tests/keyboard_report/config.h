@@ -0,0 +1,8 @@
+#ifndef TESTS_KEYBOARD_REPORT_CONFIG_H_
+#define TESTS_KEYBOARD_REPORT_CONFIG_H_
+
+#define MATRIX_ROWS 2
+#define MATRIX_COLS 2
+
+
+#endif /* TESTS_KEYBOARD_REPORT_CONFIG_H_ */
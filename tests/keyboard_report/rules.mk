@@ -0,0 +1 @@
+CUSTOM_MATRIX=yes
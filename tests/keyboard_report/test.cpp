@@ -0,0 +1,250 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include <vector>
+
+extern "C" {
+#include "quantum.h"
+}
+#include "test_driver.h"
+#include "test_matrix.h"
+#include "keyboard_report_util.h"
+#include "test_fixture.h"
+#include "test_timer.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+using testing::Invoke;
+using testing::Return;
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+	[0] = {
+	    {KC_A, KC_B},
+	    {KC_LSFT, LSFT(KC_1)}
+	},
+};
+
+class KeyboardReportState : public TestFixture {
+public:
+    ~KeyboardReportState() {
+        TestDriver driver;
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        clear_keyboard();
+    }
+};
+
+TEST_F(KeyboardReportState, HeldKeySendsOneReport) {
+    TestDriver driver;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).Times(1);
+    for (int i = 0; i < 100; i++) {
+        keyboard_task();
+    }
+}
+
+TEST_F(KeyboardReportState, PressAndReleaseSendTwoReports) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(0, 0);
+    keyboard_task();
+    keyboard_task();
+    release_key(0, 0);
+    keyboard_task();
+    keyboard_task();
+}
+
+TEST_F(KeyboardReportState, UnchangedReportIsNotSentAgain) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(1);
+    add_key(KC_A);
+    send_keyboard_report();
+    send_keyboard_report();
+    add_key(KC_A);
+    send_keyboard_report();
+}
+
+TEST_F(KeyboardReportState, ChangeThatIsUndoneIsNotSent) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    add_key(KC_A);
+    del_key(KC_A);
+    send_keyboard_report();
+    add_mods(MOD_BIT(KC_LSFT));
+    del_mods(MOD_BIT(KC_LSFT));
+    send_keyboard_report();
+}
+
+TEST_F(KeyboardReportState, ModChangeIsSent) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(2);
+    press_key(0, 1);
+    keyboard_task();
+    keyboard_task();
+    release_key(0, 1);
+    keyboard_task();
+}
+
+TEST_F(KeyboardReportState, KeysAreCounted) {
+    add_key(KC_A);
+    add_key(KC_A);
+    add_key(KC_B);
+    EXPECT_EQ(get_key_count(), 2);
+    del_key(KC_C);
+    EXPECT_EQ(get_key_count(), 2);
+    del_key(KC_A);
+    EXPECT_EQ(get_key_count(), 1);
+    clear_keys();
+    EXPECT_EQ(get_key_count(), 0);
+    EXPECT_EQ(has_anykey(keyboard_report), 0);
+}
+
+TEST_F(KeyboardReportState, FullReportKeepsItsCount) {
+    for (uint8_t key = KC_A; key < KC_A + KEYBOARD_REPORT_KEYS + 2; key++) {
+        add_key(key);
+    }
+    EXPECT_EQ(get_key_count(), KEYBOARD_REPORT_KEYS);
+    EXPECT_EQ(get_key_count(), has_anykey(keyboard_report));
+}
+
+TEST_F(KeyboardReportState, FirstKeyFollowsReleases) {
+    EXPECT_EQ(get_first_key_pressed(), 0);
+    add_key(KC_A);
+    add_key(KC_B);
+    EXPECT_EQ(get_first_key_pressed(), KC_A);
+    del_key(KC_A);
+    EXPECT_EQ(get_first_key_pressed(), KC_B);
+    del_key(KC_B);
+    EXPECT_EQ(get_first_key_pressed(), 0);
+}
+
+TEST_F(KeyboardReportState, HostDropsIdenticalReports) {
+    TestDriver driver;
+    report_keyboard_t report = {};
+    report.keys[0] = KC_A;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).Times(1);
+    host_keyboard_send(&report);
+    host_keyboard_send(&report);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    report.keys[0] = 0;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(1);
+    host_keyboard_send(&report);
+}
+
+TEST_F(KeyboardReportState, LostReportIsSentAgain) {
+    TestDriver driver;
+    InSequence s;
+    // the first release doesn't reach the host
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()))
+        .WillOnce(Invoke([](report_keyboard_t&) { host_keyboard_forget(); }));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(1);
+    press_key(0, 0);
+    keyboard_task();
+    release_key(0, 0);
+    keyboard_task();
+    advance_time(HOST_KEYBOARD_RETRY_INTERVAL);
+    keyboard_task();
+    keyboard_task();
+}
+
+TEST_F(KeyboardReportState, FailedRetriesWaitForTheRetryInterval) {
+    TestDriver driver;
+    report_keyboard_t report = {};
+    report.keys[0] = KC_A;
+    // the host gets the report on the third attempt
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).Times(3)
+        .WillOnce(Invoke([](report_keyboard_t&) { host_keyboard_forget(); }))
+        .WillOnce(Invoke([](report_keyboard_t&) { host_keyboard_forget(); }))
+        .WillOnce(Return());
+    host_keyboard_send(&report);
+    advance_time(HOST_KEYBOARD_RETRY_INTERVAL);
+    host_keyboard_task();
+    host_keyboard_task();
+    advance_time(HOST_KEYBOARD_RETRY_INTERVAL - 1);
+    host_keyboard_task();
+    advance_time(1);
+    host_keyboard_task();
+    host_keyboard_task();
+}
+
+TEST_F(KeyboardReportState, HostResetResendsTheSameReport) {
+    TestDriver driver;
+    report_keyboard_t report = {};
+    report.keys[0] = KC_A;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).Times(2);
+    host_keyboard_send(&report);
+    host_keyboard_forget();
+    host_keyboard_send(&report);
+    host_keyboard_task();
+}
+
+class ReportTransaction : public KeyboardReportState {
+public:
+    ReportTransaction() {
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber())
+            .WillRepeatedly(Invoke([this](report_keyboard_t& report) {
+                reports.push_back(report);
+            }));
+    }
+
+    TestDriver driver;
+    std::vector<report_keyboard_t> reports;
+};
+
+TEST_F(ReportTransaction, ShiftedKeySendsOneReportPerEdge) {
+    press_key(1, 1);
+    keyboard_task();
+    ASSERT_EQ(reports.size(), 1);
+    EXPECT_EQ(reports[0].mods, MOD_BIT(KC_LSFT));
+    EXPECT_EQ(reports[0].keys[0], KC_1);
+    release_key(1, 1);
+    keyboard_task();
+    ASSERT_EQ(reports.size(), 2);
+    EXPECT_EQ(reports[1].mods, 0);
+    EXPECT_EQ(has_anykey(&reports[1]), 0);
+}
+
+TEST_F(ReportTransaction, NestedTransactionsSendOnce) {
+    begin_keyboard_report();
+    register_code16(LCTL(KC_A));
+    begin_keyboard_report();
+    register_code(KC_B);
+    commit_keyboard_report();
+    EXPECT_EQ(reports.size(), 0);
+    commit_keyboard_report();
+    ASSERT_EQ(reports.size(), 1);
+    EXPECT_EQ(reports[0].mods, MOD_BIT(KC_LCTL));
+    EXPECT_EQ(has_anykey(&reports[0]), 2);
+}
+
+TEST_F(ReportTransaction, FlushSendsInsideATransaction) {
+    begin_keyboard_report();
+    register_code(KC_A);
+    flush_keyboard_report();
+    EXPECT_EQ(reports.size(), 1);
+    unregister_code(KC_A);
+    EXPECT_EQ(reports.size(), 1);
+    commit_keyboard_report();
+    ASSERT_EQ(reports.size(), 2);
+    EXPECT_EQ(has_anykey(&reports[1]), 0);
+}
+
+TEST_F(ReportTransaction, UnbalancedCommitIsIgnored) {
+    commit_keyboard_report();
+    register_code(KC_A);
+    EXPECT_EQ(reports.size(), 1);
+}
+
+TEST_F(ReportTransaction, SendStringSendsTwoReportsPerCharacter) {
+    send_string("a!");
+    ASSERT_EQ(reports.size(), 4);
+    EXPECT_EQ(reports[0].mods, 0);
+    EXPECT_EQ(reports[0].keys[0], KC_A);
+    EXPECT_EQ(has_anykey(&reports[1]), 0);
+    EXPECT_EQ(reports[2].mods, MOD_BIT(KC_LSFT));
+    EXPECT_EQ(reports[2].keys[0], KC_1);
+    EXPECT_EQ(reports[3].mods, 0);
+    EXPECT_EQ(has_anykey(&reports[3]), 0);
+}
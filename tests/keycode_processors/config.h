@@ -0,0 +1,8 @@
+#ifndef TESTS_KEYCODE_PROCESSORS_CONFIG_H_
+#define TESTS_KEYCODE_PROCESSORS_CONFIG_H_
+
+#define MATRIX_ROWS 2
+#define MATRIX_COLS 2
+
+
+#endif /* TESTS_KEYCODE_PROCESSORS_CONFIG_H_ */
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+extern "C" {
+#include "quantum.h"
+}
+#include "test_driver.h"
+#include "test_matrix.h"
+#include "keyboard_report_util.h"
+#include "test_fixture.h"
+#include "test_timer.h"
+
+extern "C" {
+LEADER_EXTERNS();
+}
+
+using testing::_;
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+	[0] = {
+	    {KC_LEAD, KC_A},
+	    {KC_C, KC_D}
+	},
+};
+
+class KeycodeProcessors : public TestFixture {
+public:
+    ~KeycodeProcessors() {
+        leading = false;
+    }
+
+    void tap(uint8_t col, uint8_t row) {
+        press_key(col, row);
+        keyboard_task();
+        release_key(col, row);
+        keyboard_task();
+    }
+};
+
+TEST_F(KeycodeProcessors, KeysOutsideTheRangesPassThrough) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    tap(1, 0);
+    EXPECT_FALSE(is_leader_on());
+}
+
+TEST_F(KeycodeProcessors, LeaderSeesEveryKeyWhileOn) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    tap(0, 0);
+    EXPECT_TRUE(is_leader_on());
+    tap(1, 0);
+    tap(0, 1);
+}
+
+TEST_F(KeycodeProcessors, KeysPassThroughAfterTheLeaderTimesOut) {
+    TestDriver driver;
+    tap(0, 0);
+    advance_time(LEADER_TIMEOUT + 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    tap(1, 0);
+}
@@ -0,0 +1,2 @@
+CUSTOM_MATRIX=yes
+MOUSEKEY_ENABLE=yes
\ No newline at end of file
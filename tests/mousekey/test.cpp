@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include <vector>
+
+#include "quantum.h"
+#include "test_driver.h"
+#include "test_fixture.h"
+#include "test_timer.h"
+
+extern "C" {
+#include "mousekey.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+	[0] = {
+	    {KC_A, KC_B},
+	    {KC_C, KC_D}
+	},
+};
+
+// With the default settings the cursor starts at 5 units per 50ms interval
+// and reaches 50 units per interval, 1 unit per ms, after 20 intervals
+static const uint32_t delay_ms = MOUSEKEY_DELAY;
+static const uint32_t ramp_ms = MOUSEKEY_TIME_TO_MAX * MOUSEKEY_INTERVAL;
+
+class Mousekey : public TestFixture {
+public:
+    Mousekey() {
+        mousekey_clear();
+        mk_delay = MOUSEKEY_DELAY / 10;
+        mk_interval = MOUSEKEY_INTERVAL;
+        mk_max_speed = MOUSEKEY_MAX_SPEED;
+        mk_time_to_max = MOUSEKEY_TIME_TO_MAX;
+        mk_wheel_max_speed = MOUSEKEY_WHEEL_MAX_SPEED;
+        mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
+        mk_curve = MK_CURVE_LINEAR;
+        EXPECT_CALL(driver, send_mouse_mock(_)).Times(AnyNumber())
+            .WillRepeatedly(Invoke([this](report_mouse_t& report) {
+                reports.push_back(report);
+                x += report.x;
+                y += report.y;
+                v += report.v;
+            }));
+    }
+
+    ~Mousekey() {
+        mousekey_clear();
+    }
+
+    void press(uint8_t code) {
+        mousekey_on(code);
+        mousekey_send();
+    }
+
+    void release(uint8_t code) {
+        mousekey_off(code);
+        mousekey_send();
+    }
+
+    void run(uint32_t ms) {
+        for (uint32_t i = 0; i < ms; i++) {
+            advance_time(1);
+            mousekey_task();
+        }
+    }
+
+    // The distance moved while holding a key for ms, after the delay
+    int32_t distance(uint8_t code, uint32_t ms) {
+        press(code);
+        run(delay_ms);
+        int32_t start = x;
+        run(ms);
+        release(code);
+        return x - start;
+    }
+
+    TestDriver driver;
+    std::vector<report_mouse_t> reports;
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t v = 0;
+};
+
+TEST_F(Mousekey, TapMovesOneStep) {
+    press(KC_MS_RIGHT);
+    run(100);
+    release(KC_MS_RIGHT);
+    run(1000);
+    EXPECT_EQ(x, MOUSEKEY_MOVE_DELTA);
+    EXPECT_EQ(y, 0);
+}
+
+TEST_F(Mousekey, HoldingWaitsForTheDelay) {
+    press(KC_MS_LEFT);
+    run(delay_ms - 1);
+    EXPECT_EQ(x, -MOUSEKEY_MOVE_DELTA);
+    run(MOUSEKEY_TICK + 1);
+    EXPECT_LT(x, -MOUSEKEY_MOVE_DELTA);
+}
+
+TEST_F(Mousekey, TrajectoryFollowsTheLinearRamp) {
+    // Starting at 0.1 units/ms and reaching 1 unit/ms over the ramp, the
+    // area under the curve is 550 units
+    int32_t moved = distance(KC_MS_RIGHT, ramp_ms);
+    EXPECT_NEAR(moved, 550, 10);
+}
+
+TEST_F(Mousekey, MaxSpeedIsSteady) {
+    press(KC_MS_DOWN);
+    run(delay_ms + ramp_ms);
+    size_t first = reports.size();
+    run(1000);
+    // One report per tick, each moving exactly 1 unit/ms
+    EXPECT_EQ(reports.size() - first, 1000 / MOUSEKEY_TICK);
+    for (size_t i = first; i < reports.size(); i++) {
+        EXPECT_EQ(reports[i].y, MOUSEKEY_TICK);
+    }
+}
+
+TEST_F(Mousekey, ReportsAreSentAtMostEveryTick) {
+    press(KC_MS_RIGHT);
+    run(delay_ms + ramp_ms + 500);
+    // Apart from the first step
+    EXPECT_LE(reports.size(), 1 + (ramp_ms + 500) / MOUSEKEY_TICK + 1);
+}
+
+TEST_F(Mousekey, SubUnitSpeedsAreNotLost) {
+    // 5 units per 250ms is a fraction of a unit per tick
+    mk_interval = 250;
+    mk_max_speed = 1;
+    int32_t moved = distance(KC_MS_RIGHT, 2500);
+    EXPECT_NEAR(moved, 50, 1);
+    // Only the ticks where a whole unit builds up send a report
+    EXPECT_LE(reports.size(), 2 + 51);
+}
+
+TEST_F(Mousekey, DiagonalIsScaled) {
+    press(KC_MS_RIGHT);
+    press(KC_MS_UP);
+    run(delay_ms + ramp_ms);
+    int32_t start_x = x;
+    int32_t start_y = y;
+    run(1000);
+    EXPECT_EQ(x - start_x, -(y - start_y));
+    // 1000 units straight, 1000 / sqrt(2) diagonally
+    EXPECT_NEAR(x - start_x, 707, 4);
+}
+
+TEST_F(Mousekey, CurvesStartSlower) {
+    int32_t linear = distance(KC_MS_RIGHT, ramp_ms / 2);
+    run(1000);
+    mk_curve = MK_CURVE_QUADRATIC;
+    int32_t quadratic = distance(KC_MS_RIGHT, ramp_ms / 2);
+    run(1000);
+    mk_curve = MK_CURVE_CUBIC;
+    int32_t cubic = distance(KC_MS_RIGHT, ramp_ms / 2);
+    run(1000);
+    mk_curve = MK_CURVE_CONSTANT;
+    int32_t constant = distance(KC_MS_RIGHT, ramp_ms / 2);
+    EXPECT_LT(quadratic, linear);
+    EXPECT_LT(cubic, quadratic);
+    EXPECT_GT(constant, linear);
+    // 0.1 + 0.9 * (t / ramp)^2 integrated over the first half of the ramp
+    EXPECT_NEAR(quadratic, 50 + 37.5, 5);
+    EXPECT_NEAR(constant, ramp_ms / 2, 1);
+}
+
+TEST_F(Mousekey, AccelKeysSetAConstantSpeed) {
+    press(KC_MS_ACCEL1);
+    int32_t moved = distance(KC_MS_RIGHT, 100);
+    EXPECT_EQ(moved, 50);
+}
+
+TEST_F(Mousekey, WheelAccumulatesToWholeNotches) {
+    press(KC_MS_WH_UP);
+    run(delay_ms + MOUSEKEY_WHEEL_TIME_TO_MAX * MOUSEKEY_INTERVAL);
+    int32_t start = v;
+    run(1000);
+    // 8 notches per 50ms interval
+    EXPECT_EQ(v - start, 160);
+    for (auto& report : reports) {
+        EXPECT_LE(report.v, 2);
+    }
+}
+
+TEST_F(Mousekey, ButtonsDoNotRepeatTheMotion) {
+    press(KC_MS_RIGHT);
+    press(KC_MS_BTN1);
+    release(KC_MS_BTN1);
+    EXPECT_EQ(x, MOUSEKEY_MOVE_DELTA);
+    ASSERT_EQ(reports.size(), 3);
+    EXPECT_EQ(reports[1].buttons, MOUSE_BTN1);
+}
@@ -0,0 +1,24 @@
+#ifndef TESTS_TEST_COMMON_TEST_EEPROM_H_
+#define TESTS_TEST_COMMON_TEST_EEPROM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Erase the emulated EEPROM and clear the write counters
+void eeprom_reset(void);
+// Fill the emulated EEPROM, like other firmware left it, and clear the write counters
+void eeprom_fill(uint8_t value);
+// Clear the write counters, but keep the contents
+void eeprom_reset_counts(void);
+// Number of physical writes to a byte since the last reset
+uint32_t eeprom_write_count(uintptr_t offset);
+uint32_t eeprom_total_write_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TESTS_TEST_COMMON_TEST_EEPROM_H_ */
@@ -11,7 +11,10 @@ using testing::Between;
 
 void TestFixture::SetUpTestCase() {
     TestDriver driver;
-    EXPECT_CALL(driver, send_keyboard_mock(_));
+    // The report is still empty, which the host already knows about
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    // with mouse keys the mouse report is cleared too
+    EXPECT_CALL(driver, send_mouse_mock(_)).Times(AnyNumber());
     keyboard_init();
 }
 
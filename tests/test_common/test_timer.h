@@ -0,0 +1,17 @@
+#ifndef TESTS_TEST_COMMON_TEST_TIMER_H_
+#define TESTS_TEST_COMMON_TEST_TIMER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TESTS_TEST_COMMON_TEST_TIMER_H_ */
@@ -0,0 +1,10 @@
+#ifndef TESTS_TIMEOUTS_CONFIG_H_
+#define TESTS_TIMEOUTS_CONFIG_H_
+
+#define MATRIX_ROWS 2
+#define MATRIX_COLS 3
+
+#define COMBO_COUNT 1
+#define ONESHOT_TIMEOUT 500
+
+#endif /* TESTS_TIMEOUTS_CONFIG_H_ */
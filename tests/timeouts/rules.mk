@@ -0,0 +1,3 @@
+CUSTOM_MATRIX=yes
+COMBO_ENABLE=yes
+TAP_DANCE_ENABLE=yes
@@ -0,0 +1,195 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include <vector>
+
+extern "C" {
+#include "quantum.h"
+}
+#include "test_driver.h"
+#include "test_matrix.h"
+#include "keyboard_report_util.h"
+#include "test_fixture.h"
+#include "test_timer.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+using testing::Invoke;
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+	[0] = {
+	    {KC_A, KC_B, KC_LEAD},
+	    {TD(0), OSM(MOD_LSFT), KC_C}
+	},
+};
+
+static const uint16_t PROGMEM ab_combo[] = {KC_A, KC_B, COMBO_END};
+combo_t key_combos[COMBO_COUNT] = {
+    {ab_combo, KC_ESC},
+};
+
+static void tap_dance_finished(qk_tap_dance_state_t *state, void *user_data) {
+    register_code(state->count == 1 ? KC_X : KC_Y);
+}
+
+static void tap_dance_reset(qk_tap_dance_state_t *state, void *user_data) {
+    unregister_code(state->count == 1 ? KC_X : KC_Y);
+}
+
+qk_tap_dance_action_t tap_dance_actions[] = {
+    {{NULL, tap_dance_finished, tap_dance_reset}},
+};
+
+extern "C" {
+extern bool leading;
+extern uint16_t leader_sequence[5];
+}
+
+class Timeouts : public TestFixture {
+public:
+    // runs a scan every millisecond, the timeouts are only seen by the scans
+    void run(uint32_t ms) {
+        for (uint32_t i = 0; i < ms; i++) {
+            advance_time(1);
+            keyboard_task();
+        }
+    }
+};
+
+TEST_F(Timeouts, ComboFiresWithinTheTerm) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ESC)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(0, 0);
+    run(1);
+    press_key(1, 0);
+    run(COMBO_TERM - 2);
+    release_key(0, 0);
+    release_key(1, 0);
+    run(2);
+}
+
+TEST_F(Timeouts, ComboKeyHeldPastTheTermIsPressed) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    run(COMBO_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A))).Times(AnyNumber());
+    run(1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(0, 0);
+    run(1);
+}
+
+TEST_F(Timeouts, TapDanceFinishesAfterTheTerm) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 1);
+    run(1);
+    release_key(0, 1);
+    run(TAPPING_TERM - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run(1);
+}
+
+TEST_F(Timeouts, EveryTapRestartsTheTapDanceTerm) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 1);
+    run(1);
+    release_key(0, 1);
+    run(TAPPING_TERM - 10);
+    press_key(0, 1);
+    run(1);
+    release_key(0, 1);
+    run(TAPPING_TERM - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run(1);
+}
+
+TEST_F(Timeouts, TapDanceHeldPastTheTermResetsOnRelease) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 1);
+    run(TAPPING_TERM - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    run(100);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(0, 1);
+    run(1);
+}
+
+TEST_F(Timeouts, OneshotModAppliesBeforeTheTimeout) {
+    TestDriver driver;
+    std::vector<report_keyboard_t> reports;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber())
+        .WillRepeatedly(Invoke([&reports](report_keyboard_t& report) {
+            reports.push_back(report);
+        }));
+    press_key(1, 1);
+    run(1);
+    release_key(1, 1);
+    run(ONESHOT_TIMEOUT - 1);
+    EXPECT_FALSE(has_oneshot_mods_timed_out());
+    reports.clear();
+    press_key(2, 1);
+    run(1);
+    ASSERT_EQ(reports.size(), 1);
+    EXPECT_EQ(reports[0].mods, MOD_BIT(KC_LSFT));
+    EXPECT_EQ(reports[0].keys[0], KC_C);
+    release_key(2, 1);
+    run(1);
+}
+
+TEST_F(Timeouts, OneshotModTimesOut) {
+    TestDriver driver;
+    std::vector<report_keyboard_t> reports;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber())
+        .WillRepeatedly(Invoke([&reports](report_keyboard_t& report) {
+            reports.push_back(report);
+        }));
+    press_key(1, 1);
+    run(1);
+    release_key(1, 1);
+    run(ONESHOT_TIMEOUT);
+    EXPECT_FALSE(has_oneshot_mods_timed_out());
+    run(1);
+    EXPECT_TRUE(has_oneshot_mods_timed_out());
+    EXPECT_EQ(get_oneshot_mods(), 0);
+    reports.clear();
+    press_key(2, 1);
+    run(1);
+    ASSERT_EQ(reports.size(), 1);
+    EXPECT_EQ(reports[0].mods, 0);
+    EXPECT_EQ(reports[0].keys[0], KC_C);
+    release_key(2, 1);
+    run(1);
+}
+
+TEST_F(Timeouts, LeaderSequenceEndsAtTheTimeout) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(2, 0);
+    run(1);
+    release_key(2, 0);
+    run(1);
+    press_key(2, 1);
+    run(1);
+    release_key(2, 1);
+    run(LEADER_TIMEOUT - 3);
+    EXPECT_TRUE(leading);
+    EXPECT_FALSE(has_leader_timed_out());
+    EXPECT_EQ(leader_sequence[0], KC_C);
+    run(1);
+    EXPECT_TRUE(has_leader_timed_out());
+    leading = false;
+}
@@ -19,6 +19,7 @@ TMK_COMMON_SRC +=	$(COMMON_DIR)/host.c \
 	$(COMMON_DIR)/util.c \
 	$(COMMON_DIR)/eeconfig.c \
 	$(COMMON_DIR)/report.c \
+	$(COMMON_DIR)/timer_wheel.c \
 	$(PLATFORM_COMMON_DIR)/suspend.c \
 	$(PLATFORM_COMMON_DIR)/timer.c \
 	$(PLATFORM_COMMON_DIR)/bootloader.c \
@@ -58,6 +59,7 @@ ifeq ($(strip $(EXTRAKEY_ENABLE)), yes)
 endif
 
 ifeq ($(strip $(RAW_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/raw_hid_channel.c
     TMK_COMMON_DEFS += -DRAW_ENABLE
 endif
 
@@ -131,6 +133,20 @@ ifeq ($(strip $(NO_USB_STARTUP_CHECK)), yes)
     TMK_COMMON_DEFS += -DNO_USB_STARTUP_CHECK
 endif
 
+ifeq ($(strip $(EECONFIG_CACHE_ENABLE)), yes)
+    TMK_COMMON_DEFS += -DEECONFIG_CACHE_ENABLE
+endif
+
+ifeq ($(strip $(TELEMETRY_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/telemetry.c
+    TMK_COMMON_DEFS += -DTELEMETRY_ENABLE
+endif
+
+ifeq ($(strip $(BINLOG_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/binlog.c
+    TMK_COMMON_DEFS += -DBINLOG_ENABLE
+endif
+
 ifeq ($(strip $(KEYMAP_SECTION_ENABLE)), yes)
     TMK_COMMON_DEFS += -DKEYMAP_SECTION_ENABLE
 
@@ -65,15 +65,6 @@ void action_exec(keyevent_t event)
 
     keyrecord_t record = { .event = event };
 
-#if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    if (has_oneshot_layer_timed_out()) {
-        clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
-    }
-    if (has_oneshot_mods_timed_out()) {
-        clear_oneshot_mods();
-    }
-#endif
-
 #ifndef NO_ACTION_TAPPING
     action_tapping_process(record);
 #else
@@ -171,6 +162,8 @@ void process_action(keyrecord_t *record, action_t action)
             {
                 uint8_t mods = (action.kind.id == ACT_LMODS) ?  action.key.mods :
                                                                 action.key.mods<<4;
+                // the mods and the key go in the same report
+                begin_keyboard_report();
                 if (event.pressed) {
                     if (mods) {
                         if (IS_MOD(action.key.code) || action.key.code == KC_NO) {
@@ -195,6 +188,7 @@ void process_action(keyrecord_t *record, action_t action)
                         send_keyboard_report();
                     }
                 }
+                commit_keyboard_report();
             }
             break;
 #ifndef NO_ACTION_TAPPING
@@ -618,7 +612,7 @@ void register_code(uint8_t code)
         if (host_keyboard_leds() & (1<<USB_LED_CAPS_LOCK)) return;
 #endif
         add_key(KC_CAPSLOCK);
-        send_keyboard_report();
+        flush_keyboard_report();
         del_key(KC_CAPSLOCK);
         send_keyboard_report();
     }
@@ -628,7 +622,7 @@ void register_code(uint8_t code)
         if (host_keyboard_leds() & (1<<USB_LED_NUM_LOCK)) return;
 #endif
         add_key(KC_NUMLOCK);
-        send_keyboard_report();
+        flush_keyboard_report();
         del_key(KC_NUMLOCK);
         send_keyboard_report();
     }
@@ -638,7 +632,7 @@ void register_code(uint8_t code)
         if (host_keyboard_leds() & (1<<USB_LED_SCROLL_LOCK)) return;
 #endif
         add_key(KC_SCROLLLOCK);
-        send_keyboard_report();
+        flush_keyboard_report();
         del_key(KC_SCROLLLOCK);
         send_keyboard_report();
     }
@@ -693,7 +687,7 @@ void unregister_code(uint8_t code)
         if (!(host_keyboard_leds() & (1<<USB_LED_CAPS_LOCK))) return;
 #endif
         add_key(KC_CAPSLOCK);
-        send_keyboard_report();
+        flush_keyboard_report();
         del_key(KC_CAPSLOCK);
         send_keyboard_report();
     }
@@ -703,7 +697,7 @@ void unregister_code(uint8_t code)
         if (!(host_keyboard_leds() & (1<<USB_LED_NUM_LOCK))) return;
 #endif
         add_key(KC_NUMLOCK);
-        send_keyboard_report();
+        flush_keyboard_report();
         del_key(KC_NUMLOCK);
         send_keyboard_report();
     }
@@ -713,7 +707,7 @@ void unregister_code(uint8_t code)
         if (!(host_keyboard_leds() & (1<<USB_LED_SCROLL_LOCK))) return;
 #endif
         add_key(KC_SCROLLLOCK);
-        send_keyboard_report();
+        flush_keyboard_report();
         del_key(KC_SCROLLLOCK);
         send_keyboard_report();
     }
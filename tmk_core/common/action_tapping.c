@@ -5,6 +5,7 @@
 #include "action_tapping.h"
 #include "keycode.h"
 #include "timer.h"
+#include "telemetry.h"
 
 #ifdef DEBUG_ACTION
 #include "debug.h"
@@ -19,6 +20,8 @@
 #define IS_TAPPING_RELEASED()   (IS_TAPPING() && !tapping_key.event.pressed)
 #define IS_TAPPING_KEY(k)       (IS_TAPPING() && KEYEQ(tapping_key.event.key, (k)))
 #define WITHIN_TAPPING_TERM(e)  (TIMER_DIFF_16(e.time, tapping_key.event.time) < TAPPING_TERM)
+#define telemetry_tapping(type, arg) \
+    telemetry_record((type), (arg), tapping_key.event.key.row << 8 | tapping_key.event.key.col)
 
 
 static keyrecord_t tapping_key = {};
@@ -88,6 +91,7 @@ bool process_tapping(keyrecord_t *keyp)
                     // first tap!
                     debug("Tapping: First tap(0->1).\n");
                     tapping_key.tap.count = 1;
+                    telemetry_tapping(TELEMETRY_TAP, 1);
                     debug_tapping_key();
                     process_record(&tapping_key);
 
@@ -103,6 +107,7 @@ bool process_tapping(keyrecord_t *keyp)
                  */
                 else if (IS_RELEASED(event) && waiting_buffer_typed(event)) {
                     debug("Tapping: End. No tap. Interfered by typing key\n");
+                    telemetry_tapping(TELEMETRY_HOLD, TELEMETRY_HOLD_INTERRUPTED);
                     process_record(&tapping_key);
                     tapping_key = (keyrecord_t){};
                     debug_tapping_key();
@@ -184,6 +189,7 @@ bool process_tapping(keyrecord_t *keyp)
         else {
             if (tapping_key.tap.count == 0) {
                 debug("Tapping: End. Timeout. Not tap(0): ");
+                telemetry_tapping(TELEMETRY_HOLD, TELEMETRY_HOLD_TIMEOUT);
                 debug_event(event); debug("\n");
                 process_record(&tapping_key);
                 tapping_key = (keyrecord_t){};
@@ -234,6 +240,7 @@ bool process_tapping(keyrecord_t *keyp)
                         keyp->tap = tapping_key.tap;
                         if (keyp->tap.count < 15) keyp->tap.count += 1;
                         debug("Tapping: Tap press("); debug_dec(keyp->tap.count); debug(")\n");
+                        telemetry_tapping(TELEMETRY_TAP, keyp->tap.count);
                         process_record(keyp);
                         tapping_key = *keyp;
                         debug_tapping_key();
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action_util.h"
 #include "action_layer.h"
 #include "timer.h"
+#include "timer_wheel.h"
 #include "keycode_config.h"
 
 extern keymap_config_t keymap_config;
@@ -39,13 +40,16 @@ static int8_t cb_tail = 0;
 static int8_t cb_count = 0;
 #endif
 
+static report_keyboard_state_t keyboard_state = {};
 // TODO: pointer variable is not needed
-//report_keyboard_t keyboard_report = {};
-report_keyboard_t *keyboard_report = &(report_keyboard_t){};
+report_keyboard_t *keyboard_report = &keyboard_state.report;
 
-extern inline void add_key(uint8_t key);
-extern inline void del_key(uint8_t key);
-extern inline void clear_keys(void);
+/* key */
+void add_key(uint8_t key) { report_state_add_key(&keyboard_state, key); }
+void del_key(uint8_t key) { report_state_del_key(&keyboard_state, key); }
+void clear_keys(void) { report_state_clear_keys(&keyboard_state); }
+uint8_t get_key_count(void) { return keyboard_state.key_count; }
+uint8_t get_first_key_pressed(void) { return report_state_first_key(&keyboard_state); }
 
 #ifndef NO_ACTION_ONESHOT
 static int8_t oneshot_mods = 0;
@@ -54,9 +58,13 @@ int8_t get_oneshot_locked_mods(void) { return oneshot_locked_mods; }
 void set_oneshot_locked_mods(int8_t mods) { oneshot_locked_mods = mods; }
 void clear_oneshot_locked_mods(void) { oneshot_locked_mods = 0; }
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-static int16_t oneshot_time = 0;
+static timer_wheel_entry_t oneshot_timer;
+static void oneshot_mods_timeout(timer_wheel_entry_t *entry) {
+  dprintf("Oneshot: timeout\n");
+  clear_oneshot_mods();
+}
 bool has_oneshot_mods_timed_out(void) {
-  return TIMER_DIFF_16(timer_read(), oneshot_time) >= ONESHOT_TIMEOUT;
+  return !timer_wheel_scheduled(&oneshot_timer);
 }
 #else
 bool has_oneshot_mods_timed_out(void) {
@@ -79,9 +87,14 @@ inline uint8_t get_oneshot_layer(void) { return oneshot_layer_data >> 3; }
 inline uint8_t get_oneshot_layer_state(void) { return oneshot_layer_data & 0b111; }
 
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-static int16_t oneshot_layer_time = 0;
+static timer_wheel_entry_t oneshot_layer_timer;
+static void oneshot_layer_timeout(timer_wheel_entry_t *entry) {
+    if (!(get_oneshot_layer_state() & ONESHOT_TOGGLED)) {
+        clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
+    }
+}
 inline bool has_oneshot_layer_timed_out() {
-    return TIMER_DIFF_16(timer_read(), oneshot_layer_time) >= ONESHOT_TIMEOUT &&
+    return !timer_wheel_scheduled(&oneshot_layer_timer) &&
         !(get_oneshot_layer_state() & ONESHOT_TOGGLED);
 }
 #endif
@@ -92,13 +105,13 @@ void set_oneshot_layer(uint8_t layer, uint8_t state)
     oneshot_layer_data = layer << 3 | state;
     layer_on(layer);
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_layer_time = timer_read();
+    timer_wheel_schedule(&oneshot_layer_timer, ONESHOT_TIMEOUT, oneshot_layer_timeout);
 #endif
 }
 void reset_oneshot_layer(void) {
     oneshot_layer_data = 0;
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_layer_time = 0;
+    timer_wheel_cancel(&oneshot_layer_timer);
 #endif
 }
 void clear_oneshot_layer_state(oneshot_fullfillment_t state)
@@ -108,7 +121,7 @@ void clear_oneshot_layer_state(oneshot_fullfillment_t state)
     if (!get_oneshot_layer_state() && start_state != oneshot_layer_data) {
         layer_off(get_oneshot_layer());
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_layer_time = 0;
+    timer_wheel_cancel(&oneshot_layer_timer);
 #endif
     }
 }
@@ -118,28 +131,41 @@ bool is_oneshot_layer_active(void)
 }
 #endif
 
-void send_keyboard_report(void) {
-    keyboard_report->mods  = real_mods;
-    keyboard_report->mods |= weak_mods;
-    keyboard_report->mods |= macro_mods;
+static uint8_t report_transaction_depth = 0;
+
+void flush_keyboard_report(void) {
+    uint8_t mods = real_mods | weak_mods | macro_mods;
 #ifndef NO_ACTION_ONESHOT
     if (oneshot_mods) {
-#if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-        if (has_oneshot_mods_timed_out()) {
-            dprintf("Oneshot: timeout\n");
-            clear_oneshot_mods();
-        }
-#endif
-        keyboard_report->mods |= oneshot_mods;
-        if (has_anykey(keyboard_report)) {
+        mods |= oneshot_mods;
+        if (keyboard_state.key_count) {
             clear_oneshot_mods();
         }
     }
 
 #endif
+    report_state_set_mods(&keyboard_state, mods);
+    // Nothing changed since the last report
+    if (!keyboard_state.dirty) return;
+    keyboard_state.dirty = false;
     host_keyboard_send(keyboard_report);
 }
 
+void send_keyboard_report(void) {
+    if (report_transaction_depth) return;
+    flush_keyboard_report();
+}
+
+void begin_keyboard_report(void) {
+    report_transaction_depth++;
+}
+
+void commit_keyboard_report(void) {
+    if (report_transaction_depth && --report_transaction_depth == 0) {
+        flush_keyboard_report();
+    }
+}
+
 /* modifier */
 uint8_t get_mods(void) { return real_mods; }
 void add_mods(uint8_t mods) { real_mods |= mods; }
@@ -167,14 +193,14 @@ void set_oneshot_mods(uint8_t mods)
 {
     oneshot_mods = mods;
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_time = timer_read();
+    timer_wheel_schedule(&oneshot_timer, ONESHOT_TIMEOUT, oneshot_mods_timeout);
 #endif
 }
 void clear_oneshot_mods(void)
 {
     oneshot_mods = 0;
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    oneshot_time = 0;
+    timer_wheel_cancel(&oneshot_timer);
 #endif
 }
 uint8_t get_oneshot_mods(void)
@@ -28,18 +28,24 @@ extern report_keyboard_t *keyboard_report;
 
 void send_keyboard_report(void);
 
-/* key */
-inline void add_key(uint8_t key) {
-  add_key_to_report(keyboard_report, key);
-}
-
-inline void del_key(uint8_t key) {
-  del_key_from_report(keyboard_report, key);
-}
+/* report transaction
+ *
+ * Between begin_keyboard_report() and the matching commit_keyboard_report(),
+ * send_keyboard_report() only takes note of the changes, and the outermost
+ * commit sends them all in one report. Transactions can be nested.
+ * flush_keyboard_report() sends the changes right away, for when the host has
+ * to see an intermediate state, like the press of a key that is tapped.
+ */
+void begin_keyboard_report(void);
+void commit_keyboard_report(void);
+void flush_keyboard_report(void);
 
-inline void clear_keys(void) {
-  clear_keys_from_report(keyboard_report);
-}
+/* key */
+void add_key(uint8_t key);
+void del_key(uint8_t key);
+void clear_keys(void);
+uint8_t get_key_count(void);
+uint8_t get_first_key_pressed(void);
 
 /* modifier */
 uint8_t get_mods(void);
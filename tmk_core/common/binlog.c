@@ -0,0 +1,201 @@
+#include <stdarg.h>
+#include <string.h>
+#include "binlog.h"
+#include "spsc_ring.h"
+
+#ifdef __AVR__
+#define format_byte(p) pgm_read_byte(p)
+#else
+#define format_byte(p) (*(p))
+#endif
+
+SPSC_RING_DEFINE(binlog_ring, BINLOG_BUFFER_SIZE);
+static uint8_t dropped = 0;
+
+/* Anything can log, the main loop, other ChibiOS threads and interrupts, so
+ * the producer side of the ring is only touched with the lock held. The
+ * consumer is always binlog_task() in the main loop.
+ */
+#if defined(PROTOCOL_CHIBIOS)
+#include "ch.h"
+static syssts_t lock_status;
+
+static inline void lock(void)
+{
+    // works from threads and interrupts alike
+    syssts_t status = chSysGetStatusAndLockX();
+    lock_status = status;
+}
+
+static inline void unlock(void)
+{
+    chSysRestoreStatusX(lock_status);
+}
+#elif defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+static uint8_t lock_sreg;
+
+static inline void lock(void)
+{
+    uint8_t sreg = SREG;
+    cli();
+    lock_sreg = sreg;
+}
+
+static inline void unlock(void)
+{
+    SREG = lock_sreg;
+}
+#else
+// natively the unit tests log from several threads
+static bool lock_flag = false;
+
+static inline void lock(void)
+{
+    while (__atomic_test_and_set(&lock_flag, __ATOMIC_ACQUIRE));
+}
+
+static inline void unlock(void)
+{
+    __atomic_clear(&lock_flag, __ATOMIC_RELEASE);
+}
+#endif
+
+static void put_record(const uint8_t *record, uint8_t length)
+{
+    lock();
+    if (spsc_ring_space(&binlog_ring) < length) {
+        if (dropped < 0xFF) dropped++;
+    } else {
+        spsc_ring_write(&binlog_ring, record, length);
+    }
+    unlock();
+}
+
+void binlog_print(const char *string)
+{
+    uint8_t record[1 + sizeof(string)];
+    record[0] = BINLOG_TEXT | 1;
+    memcpy(record + 1, &string, sizeof(string));
+    put_record(record, sizeof(record));
+}
+
+/* Takes the arguments the same way as xprintf, but only copies them. When the
+ * record is full the rest are left out, and the decoder shows them as missing.
+ */
+void binlog_printf(const char *format, ...)
+{
+    uint8_t record[BINLOG_RECORD_MAX];
+    uint8_t length = 1 + sizeof(format);
+    memcpy(record + 1, &format, sizeof(format));
+
+    va_list ap;
+    va_start(ap, format);
+    const char *p = format;
+    char c;
+    while ((c = format_byte(p++))) {
+        if (c != '%') {
+            continue;
+        }
+        c = format_byte(p++);
+        // flags and width don't change the argument
+        while (c == '-' || (c >= '0' && c <= '9')) {
+            c = format_byte(p++);
+        }
+        bool is_long = false;
+        if (c == 'l' || c == 'L') {
+            is_long = true;
+            c = format_byte(p++);
+        }
+
+        union {
+            int i;
+            long l;
+            const char *s;
+        } value;
+        uint8_t size;
+        switch (c) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'b': case 'o': case 'c':
+            if (is_long) {
+                value.l = va_arg(ap, long);
+                size = sizeof(long);
+            } else {
+                value.i = va_arg(ap, int);
+                size = sizeof(int);
+            }
+            break;
+        case 'S':
+            // a string in flash, which the decoder can find in the ELF
+            value.s = va_arg(ap, const char *);
+            size = sizeof(const char *);
+            break;
+        case 's': {
+            const char *s = va_arg(ap, const char *);
+            uint8_t n = strnlen(s, BINLOG_STRING_MAX);
+            if (length + n + 1 > sizeof(record)) {
+                goto full;
+            }
+            memcpy(record + length, s, n);
+            length += n;
+            record[length++] = 0;
+            continue;
+        }
+        case '%':
+            continue;
+        default:
+            // the arguments after one we don't know can't be found
+            goto full;
+        }
+        if (length + size > sizeof(record)) {
+            goto full;
+        }
+        memcpy(record + length, &value, size);
+        length += size;
+    }
+full:
+    va_end(ap);
+    record[0] = length - sizeof(format);
+    put_record(record, length);
+}
+
+/* Moves as many whole records as fit into packet, and returns how many that
+ * was. Nothing is written when there are no records.
+ */
+uint8_t binlog_fill_packet(uint8_t *packet, uint8_t size)
+{
+    uint8_t count = 0;
+    uint8_t used = 1;
+    while (!spsc_ring_empty(&binlog_ring)) {
+        uint8_t length = (spsc_ring_peek(&binlog_ring, 0) & ~BINLOG_TEXT) + sizeof(const char *);
+        if (used + length > size) {
+            break;
+        }
+        spsc_ring_read(&binlog_ring, packet + used, length);
+        used += length;
+        count++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    lock();
+    packet[0] = dropped;
+    dropped = 0;
+    unlock();
+    memset(packet + used, 0, size - used);
+    return count;
+}
+
+void binlog_task(void)
+{
+    static uint8_t packet[BINLOG_PACKET_SIZE];
+    static bool pending = false;
+
+    // a packet the host wasn't ready for is sent again
+    if (!pending) {
+        pending = binlog_fill_packet(packet, sizeof(packet));
+    }
+    if (pending && binlog_send(packet, sizeof(packet))) {
+        pending = false;
+    }
+}
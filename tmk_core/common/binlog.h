@@ -0,0 +1,56 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Binary logging
+ *
+ * With BINLOG_ENABLE, print(), xprintf() and the dprintf() family don't
+ * format anything on the keyboard. A call only copies the address of its
+ * string and the raw bytes of its arguments into a ring, which
+ * binlog_task() sends to the console endpoint a packet at a time.
+ * util/binlog_decode.py finds the strings in the firmware ELF and rebuilds
+ * the text. See docs/binlog.md for the packet format.
+ */
+
+#ifndef BINLOG_BUFFER_SIZE
+#define BINLOG_BUFFER_SIZE 256
+#endif
+
+/* Records never span packets, and a packet is one console report with a
+ * byte of header, so this is the console endpoint size less one.
+ */
+#ifndef BINLOG_RECORD_MAX
+#  ifdef PROTOCOL_CHIBIOS
+#    define BINLOG_RECORD_MAX 15
+#  else
+#    define BINLOG_RECORD_MAX 31
+#  endif
+#endif
+#define BINLOG_PACKET_SIZE (BINLOG_RECORD_MAX + 1)
+
+/* %s strings are copied, as they may be gone by the time they are sent */
+#ifndef BINLOG_STRING_MAX
+#define BINLOG_STRING_MAX 12
+#endif
+
+/* record header: the number of argument bytes + 1, so that 0 is padding */
+#define BINLOG_TEXT 0x80    // print() string, not a format
+
+#ifdef __AVR__
+#  include <avr/pgmspace.h>
+#  define BINLOG_STRING(s) PSTR(s)
+#else
+#  define BINLOG_STRING(s) (s)
+#endif
+
+void binlog_print(const char *string);
+void binlog_printf(const char *format, ...);
+uint8_t binlog_fill_packet(uint8_t *packet, uint8_t size);
+void binlog_task(void);
+
+/* Implemented by the protocol, returns false if the host wasn't ready */
+bool binlog_send(uint8_t *packet, uint8_t length);
+
+#endif
@@ -10,6 +10,7 @@
 #include "host.h"
 #include "backlight.h"
 #include "suspend.h"
+#include "eeconfig.h"
 
 void suspend_idle(uint8_t time) {
 	// TODO: this is not used anywhere - what units is 'time' in?
@@ -24,6 +25,9 @@ void suspend_power_down(void) {
 	// on AVR, this enables the watchdog for 15ms (max), and goes to
 	// SLEEP_MODE_PWR_DOWN
 
+#ifdef EECONFIG_CACHE_ENABLE
+	eeconfig_flush();
+#endif
 	chThdSleepMilliseconds(17);
 }
 
@@ -583,6 +583,7 @@ static void mousekey_param_print(void)
     print("4: time_to_max: "); pdec(mk_time_to_max); print("\n");
     print("5: wheel_max_speed: "); pdec(mk_wheel_max_speed); print("\n");
     print("6: wheel_time_to_max: "); pdec(mk_wheel_time_to_max); print("\n");
+    print("7: curve: "); pdec(mk_curve); print("\n");
 #endif /* !NO_PRINT */
 
 }
@@ -634,6 +635,13 @@ static void mousekey_param_inc(uint8_t param, uint8_t inc)
                 mk_wheel_time_to_max = UINT8_MAX;
             PRINT_SET_VAL(mk_wheel_time_to_max);
             break;
+        case 7:
+            if (mk_curve + inc < MK_CURVE_COUNT)
+                mk_curve += inc;
+            else
+                mk_curve = MK_CURVE_COUNT - 1;
+            PRINT_SET_VAL(mk_curve);
+            break;
     }
 }
 
@@ -682,6 +690,13 @@ static void mousekey_param_dec(uint8_t param, uint8_t dec)
                 mk_wheel_time_to_max = 0;
             PRINT_SET_VAL(mk_wheel_time_to_max);
             break;
+        case 7:
+            if (mk_curve > dec)
+                mk_curve -= dec;
+            else
+                mk_curve = 0;
+            PRINT_SET_VAL(mk_curve);
+            break;
     }
 }
 
@@ -695,6 +710,7 @@ static void mousekey_console_help(void)
           "4:	time_to_max\n"
           "5:	wheel_max_speed\n"
           "6:	wheel_time_to_max\n"
+          "7:	curve(0:linear 1:quadratic 2:cubic 3:constant)\n"
           "\n"
           "p:	print values\n"
           "d:	set defaults\n"
@@ -703,7 +719,7 @@ static void mousekey_console_help(void)
           "pgup:	+10\n"
           "pgdown:	-10\n"
           "\n"
-          "speed = delta * max_speed * (repeat / time_to_max)\n");
+          "speed = delta * max_speed * curve(time / (time_to_max * interval))\n");
     xprintf("where delta: cursor=%d, wheel=%d\n"
             "See http://en.wikipedia.org/wiki/Mouse_keys\n", MOUSEKEY_MOVE_DELTA,  MOUSEKEY_WHEEL_DELTA);
 }
@@ -734,6 +750,7 @@ static bool mousekey_console(uint8_t code)
         case KC_4:
         case KC_5:
         case KC_6:
+        case KC_7:
             mousekey_param = numkey2num(code);
             break;
         case KC_UP:
@@ -755,6 +772,7 @@ static bool mousekey_console(uint8_t code)
             mk_time_to_max = MOUSEKEY_TIME_TO_MAX;
             mk_wheel_max_speed = MOUSEKEY_WHEEL_MAX_SPEED;
             mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
+            mk_curve = MOUSEKEY_CURVE;
             print("set default\n");
             break;
         default:
@@ -2,55 +2,197 @@
 #include <stdbool.h>
 #include "eeprom.h"
 #include "eeconfig.h"
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#include "dynamic_keymap.h"
+#endif
+#ifdef EECONFIG_CACHE_ENABLE
+#include "timer.h"
+#endif
+
+#ifdef EECONFIG_CACHE_ENABLE
+/* RAM shadow of the eeconfig region
+ *
+ * Settings that change on every keypress (rgblight hue, backlight level, ...)
+ * only update the shadow and mark the bytes dirty. The dirty bytes are written
+ * in one go when the settings have been left alone for a while, when the
+ * keyboard suspends, or at the latest after EECONFIG_CACHE_MAX_DELAY.
+ */
+static uint8_t eeconfig_cache[EECONFIG_SIZE];
+static uint8_t eeconfig_dirty[(EECONFIG_SIZE + 7) / 8];
+static uint16_t eeconfig_write_counts[EECONFIG_SIZE];
+static bool eeconfig_cache_loaded = false;
+static bool eeconfig_cache_dirty = false;
+static uint16_t eeconfig_first_change;
+static uint16_t eeconfig_last_change;
+
+static void eeconfig_cache_load(void)
+{
+    eeprom_read_block(eeconfig_cache, (const void *)0, EECONFIG_SIZE);
+    eeconfig_cache_loaded = true;
+}
+
+static inline bool eeconfig_in_cache(uintptr_t offset)
+{
+    return offset < EECONFIG_SIZE;
+}
+
+uint8_t eeconfig_read_byte(const uint8_t *addr)
+{
+    uintptr_t offset = (uintptr_t)addr;
+    if (!eeconfig_in_cache(offset)) return eeprom_read_byte(addr);
+    if (!eeconfig_cache_loaded) eeconfig_cache_load();
+    return eeconfig_cache[offset];
+}
+
+void eeconfig_update_byte(uint8_t *addr, uint8_t val)
+{
+    uintptr_t offset = (uintptr_t)addr;
+    if (!eeconfig_in_cache(offset)) {
+        eeprom_update_byte(addr, val);
+        return;
+    }
+    if (!eeconfig_cache_loaded) eeconfig_cache_load();
+    if (eeconfig_cache[offset] == val) return;
+
+    eeconfig_cache[offset] = val;
+    eeconfig_dirty[offset / 8] |= 1 << (offset % 8);
+    eeconfig_last_change = timer_read();
+    if (!eeconfig_cache_dirty) {
+        eeconfig_first_change = eeconfig_last_change;
+        eeconfig_cache_dirty = true;
+    }
+}
+
+void eeconfig_flush(void)
+{
+    if (!eeconfig_cache_dirty) return;
+    for (uint8_t i = 0; i < EECONFIG_SIZE; i++) {
+        if (!(eeconfig_dirty[i / 8] & (1 << (i % 8)))) continue;
+        /* A byte changed back to its stored value costs nothing */
+        if (eeprom_read_byte((const uint8_t *)(uintptr_t)i) != eeconfig_cache[i]) {
+            eeprom_write_byte((uint8_t *)(uintptr_t)i, eeconfig_cache[i]);
+            eeconfig_write_counts[i]++;
+        }
+    }
+    for (uint8_t i = 0; i < sizeof(eeconfig_dirty); i++) {
+        eeconfig_dirty[i] = 0;
+    }
+    eeconfig_cache_dirty = false;
+}
+
+void eeconfig_task(void)
+{
+    if (!eeconfig_cache_dirty) return;
+    if (timer_elapsed(eeconfig_last_change) >= EECONFIG_CACHE_IDLE_TIMEOUT ||
+        timer_elapsed(eeconfig_first_change) >= EECONFIG_CACHE_MAX_DELAY) {
+        eeconfig_flush();
+    }
+}
+
+bool eeconfig_is_dirty(void)
+{
+    return eeconfig_cache_dirty;
+}
+
+uint16_t eeconfig_write_count(uint8_t offset)
+{
+    return eeconfig_in_cache(offset) ? eeconfig_write_counts[offset] : 0;
+}
+#else
+uint8_t eeconfig_read_byte(const uint8_t *addr) { return eeprom_read_byte(addr); }
+void eeconfig_update_byte(uint8_t *addr, uint8_t val) { eeprom_update_byte(addr, val); }
+#endif
+
+uint16_t eeconfig_read_word(const uint16_t *addr)
+{
+    const uint8_t *p = (const uint8_t *)addr;
+    return eeconfig_read_byte(p) | (eeconfig_read_byte(p+1) << 8);
+}
+
+uint32_t eeconfig_read_dword(const uint32_t *addr)
+{
+    const uint8_t *p = (const uint8_t *)addr;
+    return eeconfig_read_byte(p) | (eeconfig_read_byte(p+1) << 8)
+        | ((uint32_t)eeconfig_read_byte(p+2) << 16) | ((uint32_t)eeconfig_read_byte(p+3) << 24);
+}
+
+void eeconfig_update_word(uint16_t *addr, uint16_t val)
+{
+    uint8_t *p = (uint8_t *)addr;
+    eeconfig_update_byte(p++, val);
+    eeconfig_update_byte(p, val >> 8);
+}
+
+void eeconfig_update_dword(uint32_t *addr, uint32_t val)
+{
+    uint8_t *p = (uint8_t *)addr;
+    eeconfig_update_byte(p++, val);
+    eeconfig_update_byte(p++, val >> 8);
+    eeconfig_update_byte(p++, val >> 16);
+    eeconfig_update_byte(p, val >> 24);
+}
 
 void eeconfig_init(void)
 {
-    eeprom_update_word(EECONFIG_MAGIC,          EECONFIG_MAGIC_NUMBER);
-    eeprom_update_byte(EECONFIG_DEBUG,          0);
-    eeprom_update_byte(EECONFIG_DEFAULT_LAYER,  0);
-    eeprom_update_byte(EECONFIG_KEYMAP,         0);
-    eeprom_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
+    eeconfig_update_word(EECONFIG_MAGIC,          EECONFIG_MAGIC_NUMBER);
+    eeconfig_update_byte(EECONFIG_DEBUG,          0);
+    eeconfig_update_byte(EECONFIG_DEFAULT_LAYER,  0);
+    eeconfig_update_byte(EECONFIG_KEYMAP,         0);
+    eeconfig_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
 #ifdef BACKLIGHT_ENABLE
-    eeprom_update_byte(EECONFIG_BACKLIGHT,      0);
+    eeconfig_update_byte(EECONFIG_BACKLIGHT,      0);
 #endif
 #ifdef AUDIO_ENABLE
-    eeprom_update_byte(EECONFIG_AUDIO,             0xFF); // On by default
+    eeconfig_update_byte(EECONFIG_AUDIO,             0xFF); // On by default
 #endif
 #ifdef RGBLIGHT_ENABLE
-    eeprom_update_dword(EECONFIG_RGBLIGHT,      0);
+    eeconfig_update_dword(EECONFIG_RGBLIGHT,      0);
+#endif
+#ifdef EECONFIG_CACHE_ENABLE
+    eeconfig_flush();
+#endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    // the keymap stored after eeconfig is reset with it
+    dynamic_keymap_reset();
 #endif
 }
 
 void eeconfig_enable(void)
 {
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+#ifdef EECONFIG_CACHE_ENABLE
+    eeconfig_flush();
+#endif
 }
 
 void eeconfig_disable(void)
 {
-    eeprom_update_word(EECONFIG_MAGIC, 0xFFFF);
+    eeconfig_update_word(EECONFIG_MAGIC, 0xFFFF);
+#ifdef EECONFIG_CACHE_ENABLE
+    eeconfig_flush();
+#endif
 }
 
 bool eeconfig_is_enabled(void)
 {
-    return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER);
+    return (eeconfig_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER);
 }
 
-uint8_t eeconfig_read_debug(void)      { return eeprom_read_byte(EECONFIG_DEBUG); }
-void eeconfig_update_debug(uint8_t val) { eeprom_update_byte(EECONFIG_DEBUG, val); }
+uint8_t eeconfig_read_debug(void)      { return eeconfig_read_byte(EECONFIG_DEBUG); }
+void eeconfig_update_debug(uint8_t val) { eeconfig_update_byte(EECONFIG_DEBUG, val); }
 
-uint8_t eeconfig_read_default_layer(void)      { return eeprom_read_byte(EECONFIG_DEFAULT_LAYER); }
-void eeconfig_update_default_layer(uint8_t val) { eeprom_update_byte(EECONFIG_DEFAULT_LAYER, val); }
+uint8_t eeconfig_read_default_layer(void)      { return eeconfig_read_byte(EECONFIG_DEFAULT_LAYER); }
+void eeconfig_update_default_layer(uint8_t val) { eeconfig_update_byte(EECONFIG_DEFAULT_LAYER, val); }
 
-uint8_t eeconfig_read_keymap(void)      { return eeprom_read_byte(EECONFIG_KEYMAP); }
-void eeconfig_update_keymap(uint8_t val) { eeprom_update_byte(EECONFIG_KEYMAP, val); }
+uint8_t eeconfig_read_keymap(void)      { return eeconfig_read_byte(EECONFIG_KEYMAP); }
+void eeconfig_update_keymap(uint8_t val) { eeconfig_update_byte(EECONFIG_KEYMAP, val); }
 
 #ifdef BACKLIGHT_ENABLE
-uint8_t eeconfig_read_backlight(void)      { return eeprom_read_byte(EECONFIG_BACKLIGHT); }
-void eeconfig_update_backlight(uint8_t val) { eeprom_update_byte(EECONFIG_BACKLIGHT, val); }
+uint8_t eeconfig_read_backlight(void)      { return eeconfig_read_byte(EECONFIG_BACKLIGHT); }
+void eeconfig_update_backlight(uint8_t val) { eeconfig_update_byte(EECONFIG_BACKLIGHT, val); }
 #endif
 
 #ifdef AUDIO_ENABLE
-uint8_t eeconfig_read_audio(void)      { return eeprom_read_byte(EECONFIG_AUDIO); }
-void eeconfig_update_audio(uint8_t val) { eeprom_update_byte(EECONFIG_AUDIO, val); }
+uint8_t eeconfig_read_audio(void)      { return eeconfig_read_byte(EECONFIG_AUDIO); }
+void eeconfig_update_audio(uint8_t val) { eeconfig_update_byte(EECONFIG_AUDIO, val); }
 #endif
@@ -35,6 +35,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EECONFIG_RGBLIGHT                           (uint32_t *)8
 #define EECONFIG_UNICODEMODE                        (uint8_t *)12
 
+/* size of the eeconfig region, in bytes */
+#define EECONFIG_SIZE                               13
+
 
 /* debug bit */
 #define EECONFIG_DEBUG_ENABLE                       (1<<0)
@@ -52,6 +55,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EECONFIG_KEYMAP_SWAP_BACKSLASH_BACKSPACE    (1<<6)
 #define EECONFIG_KEYMAP_NKRO                        (1<<7)
 
+#ifdef EECONFIG_CACHE_ENABLE
+/* flush the cache when nothing has changed for this many milliseconds */
+#ifndef EECONFIG_CACHE_IDLE_TIMEOUT
+#define EECONFIG_CACHE_IDLE_TIMEOUT                 1000
+#endif
+/* but never keep a change unwritten for longer than this */
+#ifndef EECONFIG_CACHE_MAX_DELAY
+#define EECONFIG_CACHE_MAX_DELAY                    10000
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 bool eeconfig_is_enabled(void);
 
@@ -80,4 +97,28 @@ uint8_t eeconfig_read_audio(void);
 void eeconfig_update_audio(uint8_t val);
 #endif
 
+/* Generic access to the eeconfig region. With EECONFIG_CACHE_ENABLE these go
+ * through the RAM shadow, otherwise straight to the EEPROM. */
+uint8_t eeconfig_read_byte(const uint8_t *addr);
+uint16_t eeconfig_read_word(const uint16_t *addr);
+uint32_t eeconfig_read_dword(const uint32_t *addr);
+void eeconfig_update_byte(uint8_t *addr, uint8_t val);
+void eeconfig_update_word(uint16_t *addr, uint16_t val);
+void eeconfig_update_dword(uint32_t *addr, uint32_t val);
+
+#ifdef EECONFIG_CACHE_ENABLE
+/* Writes the dirty bytes to the EEPROM once the settings have been idle,
+ * call it regularly from the main loop */
+void eeconfig_task(void);
+/* Writes all dirty bytes immediately */
+void eeconfig_flush(void);
+bool eeconfig_is_dirty(void);
+/* Number of physical EEPROM writes of a byte in the eeconfig region since boot */
+uint16_t eeconfig_write_count(uint8_t offset);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
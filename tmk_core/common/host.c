@@ -16,13 +16,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdint.h>
+#include <string.h>
 //#include <avr/interrupt.h>
 #include "keycode.h"
 #include "host.h"
 #include "util.h"
+#include "timer.h"
 #include "debug.h"
+#include "telemetry.h"
 
 static host_driver_t *driver;
+static report_keyboard_t last_keyboard_report = {};
+/* the host doesn't have last_keyboard_report */
+static bool keyboard_unsent = false;
+static uint16_t keyboard_retry_time = 0;
 static uint16_t last_system_report = 0;
 static uint16_t last_consumer_report = 0;
 
@@ -30,6 +37,9 @@ static uint16_t last_consumer_report = 0;
 void host_set_driver(host_driver_t *d)
 {
     driver = d;
+    // A new host starts with no keys pressed
+    memset(&last_keyboard_report, 0, sizeof(last_keyboard_report));
+    keyboard_unsent = false;
 }
 
 host_driver_t *host_get_driver(void)
@@ -42,11 +52,12 @@ uint8_t host_keyboard_leds(void)
     if (!driver) return 0;
     return (*driver->keyboard_leds)();
 }
-/* send report */
-void host_keyboard_send(report_keyboard_t *report)
+static void send_keyboard(report_keyboard_t *report)
 {
-    if (!driver) return;
+    keyboard_unsent = false;
+    // the driver calls host_keyboard_forget() if this doesn't get through
     (*driver->send_keyboard)(report);
+    telemetry_record(TELEMETRY_REPORT, TELEMETRY_REPORT_KEYBOARD, 0);
 
     if (debug_keyboard) {
         dprint("keyboard_report: ");
@@ -57,10 +68,34 @@ void host_keyboard_send(report_keyboard_t *report)
     }
 }
 
+/* send report */
+void host_keyboard_send(report_keyboard_t *report)
+{
+    if (!driver) return;
+    if (!keyboard_unsent && !memcmp(report, &last_keyboard_report, sizeof(last_keyboard_report))) return;
+    last_keyboard_report = *report;
+    send_keyboard(&last_keyboard_report);
+}
+
+void host_keyboard_forget(void)
+{
+    keyboard_unsent = true;
+}
+
+void host_keyboard_task(void)
+{
+    if (!driver || !keyboard_unsent) return;
+    // a driver may wait for the endpoint before it gives up, don't do that on every scan
+    if (timer_elapsed(keyboard_retry_time) < HOST_KEYBOARD_RETRY_INTERVAL) return;
+    keyboard_retry_time = timer_read();
+    send_keyboard(&last_keyboard_report);
+}
+
 void host_mouse_send(report_mouse_t *report)
 {
     if (!driver) return;
     (*driver->send_mouse)(report);
+    telemetry_record(TELEMETRY_REPORT, TELEMETRY_REPORT_MOUSE, 0);
 }
 
 void host_system_send(uint16_t report)
@@ -70,6 +105,7 @@ void host_system_send(uint16_t report)
 
     if (!driver) return;
     (*driver->send_system)(report);
+    telemetry_record(TELEMETRY_REPORT, TELEMETRY_REPORT_SYSTEM, report);
 }
 
 void host_consumer_send(uint16_t report)
@@ -79,6 +115,7 @@ void host_consumer_send(uint16_t report)
 
     if (!driver) return;
     (*driver->send_consumer)(report);
+    telemetry_record(TELEMETRY_REPORT, TELEMETRY_REPORT_CONSUMER, report);
 }
 
 uint16_t host_last_system_report(void)
@@ -23,6 +23,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "report.h"
 #include "host_driver.h"
 
+/* milliseconds between attempts to send a report the host didn't get */
+#ifndef HOST_KEYBOARD_RETRY_INTERVAL
+#define HOST_KEYBOARD_RETRY_INTERVAL 50
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,6 +46,12 @@ void host_keyboard_send(report_keyboard_t *report);
 void host_mouse_send(report_mouse_t *report);
 void host_system_send(uint16_t data);
 void host_consumer_send(uint16_t data);
+/* The driver calls this when a keyboard report didn't reach the host, or the
+ * host may have lost it, host_keyboard_task() then sends the last report again,
+ * at most every HOST_KEYBOARD_RETRY_INTERVAL.
+ */
+void host_keyboard_forget(void);
+void host_keyboard_task(void);
 
 uint16_t host_last_system_report(void);
 uint16_t host_last_consumer_report(void);
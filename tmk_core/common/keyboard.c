@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "led.h"
 #include "keycode.h"
 #include "timer.h"
+#include "timer_wheel.h"
 #include "print.h"
 #include "debug.h"
 #include "command.h"
@@ -31,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "eeconfig.h"
 #include "backlight.h"
 #include "action_layer.h"
+#include "telemetry.h"
 #ifdef BOOTMAGIC_ENABLE
 #   include "bootmagic.h"
 #else
@@ -118,6 +120,7 @@ void keyboard_setup(void) {
 
 void keyboard_init(void) {
     timer_init();
+    timer_wheel_init();
     matrix_init();
 #ifdef PS2_MOUSE_ENABLE
     ps2_mouse_init();
@@ -147,6 +150,14 @@ void keyboard_init(void) {
 #endif
 }
 
+/* a key was down or changed in the last keyboard_task() */
+static bool matrix_active = false;
+
+bool keyboard_matrix_active(void)
+{
+    return matrix_active;
+}
+
 /*
  * Do keyboard routine jobs: scan mantrix, light LEDs, ...
  * This is repeatedly called as fast as possible.
@@ -162,9 +173,13 @@ void keyboard_task(void)
     matrix_row_t matrix_change = 0;
 
     matrix_scan();
+    telemetry_scan();
+    timer_wheel_task();
+    matrix_active = false;
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
         matrix_row = matrix_get_row(r);
         matrix_change = matrix_row ^ matrix_prev[r];
+        matrix_active |= matrix_row || matrix_change;
         if (matrix_change) {
 #ifdef MATRIX_HAS_GHOST
             if (has_ghost_in_row(r, matrix_row)) {
@@ -183,6 +198,7 @@ void keyboard_task(void)
             if (debug_matrix) matrix_print();
             for (uint8_t c = 0; c < MATRIX_COLS; c++) {
                 if (matrix_change & ((matrix_row_t)1<<c)) {
+                    telemetry_record((matrix_row & ((matrix_row_t)1<<c)) ? TELEMETRY_KEY_DOWN : TELEMETRY_KEY_UP, r, c);
                     action_exec((keyevent_t){
                         .key = (keypos_t){ .row = r, .col = c },
                         .pressed = (matrix_row & ((matrix_row_t)1<<c)),
@@ -201,11 +217,6 @@ void keyboard_task(void)
 
 MATRIX_LOOP_END:
 
-#ifdef MOUSEKEY_ENABLE
-    // mousekey repeat & acceleration
-    mousekey_task();
-#endif
-
 #ifdef PS2_MOUSE_ENABLE
     ps2_mouse_task();
 #endif
@@ -226,6 +237,13 @@ MATRIX_LOOP_END:
     visualizer_update(default_layer_state, layer_state, visualizer_get_mods(), host_keyboard_leds());
 #endif
 
+#ifdef EECONFIG_CACHE_ENABLE
+    eeconfig_task();
+#endif
+
+    // a report that didn't get through
+    host_keyboard_task();
+
     // update LED
     if (led_status != host_keyboard_leds()) {
         led_status = host_keyboard_leds();
@@ -63,6 +63,8 @@ void keyboard_setup(void);
 void keyboard_init(void);
 /* it runs repeatedly in main loop */
 void keyboard_task(void);
+/* true when a key was down or changed in the last keyboard_task() */
+bool keyboard_matrix_active(void);
 /* it runs when host LED status is updated */
 void keyboard_set_leds(uint8_t leds);
 
@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "keycode.h"
 #include "host.h"
 #include "timer.h"
+#include "timer_wheel.h"
 #include "print.h"
 #include "debug.h"
 #include "mousekey.h"
@@ -26,9 +27,27 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 static report_mouse_t mouse_report = {};
-static uint8_t mousekey_repeat =  0;
 static uint8_t mousekey_accel = 0;
 
+/* held direction keys */
+#define MK_UP       (1<<0)
+#define MK_DOWN     (1<<1)
+#define MK_LEFT     (1<<2)
+#define MK_RIGHT    (1<<3)
+#define MK_WH_UP    (1<<4)
+#define MK_WH_DOWN  (1<<5)
+#define MK_WH_LEFT  (1<<6)
+#define MK_WH_RIGHT (1<<7)
+#define MK_MOVE     (MK_UP | MK_DOWN | MK_LEFT | MK_RIGHT)
+static uint8_t mousekey_dirs = 0;
+
+/* past the initial delay and moving */
+static bool mousekey_moving = false;
+/* milliseconds since the motion started, saturating */
+static uint16_t mousekey_time = 0;
+/* motion not reported yet, in 1/256 units */
+static int16_t rem_x, rem_y, rem_v, rem_h;
+
 static void mousekey_debug(void);
 
 
@@ -36,105 +55,182 @@ static void mousekey_debug(void);
  * Mouse keys  acceleration algorithm
  *  http://en.wikipedia.org/wiki/Mouse_keys
  *
- *  speed = delta * max_speed * (repeat / time_to_max)**((1000+curve)/1000)
+ *  speed = delta + (delta * max_speed - delta) * curve(time / (time_to_max * interval))
+ *
+ * The speed is in units per interval, and the motion is worked out in fixed
+ * point every MOUSEKEY_TICK milliseconds. The fractions of a unit that can't
+ * be reported yet are carried over to the next report, so slow speeds and
+ * short ticks don't lose or round off any motion.
  */
 /* milliseconds between the initial key press and first repeated motion event (0-2550) */
 uint8_t mk_delay = MOUSEKEY_DELAY/10;
-/* milliseconds between repeated motion events (0-255) */
+/* milliseconds the speed is given for (0-255) */
 uint8_t mk_interval = MOUSEKEY_INTERVAL;
-/* steady speed (in action_delta units) applied each event (0-255) */
+/* steady speed (in action_delta units) per interval (0-255) */
 uint8_t mk_max_speed = MOUSEKEY_MAX_SPEED;
-/* number of events (count) accelerating to steady speed (0-255) */
+/* number of intervals accelerating to steady speed (0-255) */
 uint8_t mk_time_to_max = MOUSEKEY_TIME_TO_MAX;
-/* ramp used to reach maximum pointer speed (NOT SUPPORTED) */
-//int8_t mk_curve = 0;
+/* ramp used to reach maximum pointer speed, one of MK_CURVE_* */
+uint8_t mk_curve = MOUSEKEY_CURVE;
 /* wheel params */
 uint8_t mk_wheel_max_speed = MOUSEKEY_WHEEL_MAX_SPEED;
 uint8_t mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
 
 
 static uint16_t last_timer = 0;
+/* runs mousekey_task while a direction is held */
+static timer_wheel_entry_t mousekey_timer;
 
 
-static uint8_t move_unit(void)
+/* speed in 1/256 units per interval after moving for time milliseconds */
+static uint32_t speed(uint8_t delta, uint8_t max_speed, uint8_t time_to_max, uint16_t time)
 {
-    uint16_t unit;
+    uint32_t start = (uint32_t)delta << 8;
+    uint32_t max = start * max_speed;
     if (mousekey_accel & (1<<0)) {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed)/4;
+        max /= 4;
     } else if (mousekey_accel & (1<<1)) {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed)/2;
-    } else if (mousekey_accel & (1<<2)) {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed);
-    } else if (mousekey_repeat == 0) {
-        unit = MOUSEKEY_MOVE_DELTA;
-    } else if (mousekey_repeat >= mk_time_to_max) {
-        unit = MOUSEKEY_MOVE_DELTA * mk_max_speed;
-    } else {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed * mousekey_repeat) / mk_time_to_max;
+        max /= 2;
+    } else if (!(mousekey_accel & (1<<2)) && mk_curve != MK_CURVE_CONSTANT) {
+        uint32_t ramp = (uint32_t)time_to_max * mk_interval;
+        if (time < ramp && max > start) {
+            uint32_t r = ((uint32_t)time << 8) / ramp;
+            if (mk_curve == MK_CURVE_QUADRATIC) {
+                r = (r * r) >> 8;
+            } else if (mk_curve == MK_CURVE_CUBIC) {
+                r = (r * r * r) >> 16;
+            }
+            max = start + (((max - start) * r) >> 8);
+        }
     }
-    return (unit > MOUSEKEY_MOVE_MAX ? MOUSEKEY_MOVE_MAX : (unit == 0 ? 1 : unit));
+    return (max < 256 ? 256 : max);
 }
 
-static uint8_t wheel_unit(void)
+static uint32_t move_speed(void)
 {
-    uint16_t unit;
-    if (mousekey_accel & (1<<0)) {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed)/4;
-    } else if (mousekey_accel & (1<<1)) {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed)/2;
-    } else if (mousekey_accel & (1<<2)) {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed);
-    } else if (mousekey_repeat == 0) {
-        unit = MOUSEKEY_WHEEL_DELTA;
-    } else if (mousekey_repeat >= mk_wheel_time_to_max) {
-        unit = MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed;
-    } else {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed * mousekey_repeat) / mk_wheel_time_to_max;
+    return speed(MOUSEKEY_MOVE_DELTA, mk_max_speed, mk_time_to_max, mousekey_time);
+}
+
+static uint32_t wheel_speed(void)
+{
+    return speed(MOUSEKEY_WHEEL_DELTA, mk_wheel_max_speed, mk_wheel_time_to_max, mousekey_time);
+}
+
+/* whole units of a speed, for a single step */
+static int8_t unit(uint32_t speed, int8_t max)
+{
+    speed >>= 8;
+    return (speed > (uint8_t)max ? max : (int8_t)speed);
+}
+
+/* add motion to the remainder and take out the whole units */
+static int8_t step(int16_t *rem, int8_t dir, uint32_t distance, int8_t max)
+{
+    if (!dir) {
+        *rem = 0;
+        return 0;
     }
-    return (unit > MOUSEKEY_WHEEL_MAX ? MOUSEKEY_WHEEL_MAX : (unit == 0 ? 1 : unit));
+    int32_t acc = *rem + (dir > 0 ? (int32_t)distance : -(int32_t)distance);
+    int32_t whole = acc / 256;
+    if (whole > max) {
+        whole = max;
+        acc = whole * 256;
+    } else if (whole < -max) {
+        whole = -max;
+        acc = whole * 256;
+    }
+    *rem = acc - whole * 256;
+    return whole;
+}
+
+static inline int8_t axis(uint8_t positive, uint8_t negative)
+{
+    return (mousekey_dirs & positive ? 1 : 0) - (mousekey_dirs & negative ? 1 : 0);
 }
 
 void mousekey_task(void)
 {
-    if (timer_elapsed(last_timer) < (mousekey_repeat ? mk_interval : mk_delay*10))
+    if (!mousekey_dirs)
         return;
 
-    if (mouse_report.x == 0 && mouse_report.y == 0 && mouse_report.v == 0 && mouse_report.h == 0)
+    uint16_t elapsed = timer_elapsed(last_timer);
+    if (!mousekey_moving) {
+        if (elapsed < mk_delay*10)
+            return;
+        /* the motion starts when the delay runs out */
+        elapsed -= mk_delay*10;
+        mousekey_moving = true;
+    } else if (elapsed < MOUSEKEY_TICK) {
         return;
+    }
+    last_timer = timer_read();
+    if (elapsed > UINT8_MAX)
+        elapsed = UINT8_MAX;
+    mousekey_time = (mousekey_time > UINT16_MAX - elapsed ? UINT16_MAX : mousekey_time + elapsed);
 
-    if (mousekey_repeat != UINT8_MAX)
-        mousekey_repeat++;
-
+    uint8_t interval = (mk_interval ? mk_interval : 1);
+    int8_t dx = axis(MK_RIGHT, MK_LEFT);
+    int8_t dy = axis(MK_DOWN, MK_UP);
+    uint32_t move = move_speed() * elapsed / interval;
+    /* diagonal move [1/sqrt(2) = 181/256] */
+    if (dx && dy)
+        move = (move * 181) >> 8;
+    uint32_t wheel = wheel_speed() * elapsed / interval;
 
-    if (mouse_report.x > 0) mouse_report.x = move_unit();
-    if (mouse_report.x < 0) mouse_report.x = move_unit() * -1;
-    if (mouse_report.y > 0) mouse_report.y = move_unit();
-    if (mouse_report.y < 0) mouse_report.y = move_unit() * -1;
+    mouse_report.x = step(&rem_x, dx, move, MOUSEKEY_MOVE_MAX);
+    mouse_report.y = step(&rem_y, dy, move, MOUSEKEY_MOVE_MAX);
+    mouse_report.v = step(&rem_v, axis(MK_WH_UP, MK_WH_DOWN), wheel, MOUSEKEY_WHEEL_MAX);
+    mouse_report.h = step(&rem_h, axis(MK_WH_RIGHT, MK_WH_LEFT), wheel, MOUSEKEY_WHEEL_MAX);
 
-    /* diagonal move [1/sqrt(2) = 0.7] */
-    if (mouse_report.x && mouse_report.y) {
-        mouse_report.x *= 0.7;
-        mouse_report.y *= 0.7;
-    }
+    /* nothing to report until a whole unit has built up */
+    if (mouse_report.x || mouse_report.y || mouse_report.v || mouse_report.h)
+        mousekey_send();
+}
 
-    if (mouse_report.v > 0) mouse_report.v = wheel_unit();
-    if (mouse_report.v < 0) mouse_report.v = wheel_unit() * -1;
-    if (mouse_report.h > 0) mouse_report.h = wheel_unit();
-    if (mouse_report.h < 0) mouse_report.h = wheel_unit() * -1;
+static void mousekey_tick(timer_wheel_entry_t *entry)
+{
+    mousekey_task();
+    if (mousekey_dirs)
+        timer_wheel_schedule(entry, MOUSEKEY_TICK, mousekey_tick);
+}
 
-    mousekey_send();
+static uint8_t dir_bit(uint8_t code)
+{
+    switch (code) {
+        case KC_MS_UP:       return MK_UP;
+        case KC_MS_DOWN:     return MK_DOWN;
+        case KC_MS_LEFT:     return MK_LEFT;
+        case KC_MS_RIGHT:    return MK_RIGHT;
+        case KC_MS_WH_UP:    return MK_WH_UP;
+        case KC_MS_WH_DOWN:  return MK_WH_DOWN;
+        case KC_MS_WH_LEFT:  return MK_WH_LEFT;
+        case KC_MS_WH_RIGHT: return MK_WH_RIGHT;
+    }
+    return 0;
 }
 
 void mousekey_on(uint8_t code)
 {
-    if      (code == KC_MS_UP)       mouse_report.y = move_unit() * -1;
-    else if (code == KC_MS_DOWN)     mouse_report.y = move_unit();
-    else if (code == KC_MS_LEFT)     mouse_report.x = move_unit() * -1;
-    else if (code == KC_MS_RIGHT)    mouse_report.x = move_unit();
-    else if (code == KC_MS_WH_UP)    mouse_report.v = wheel_unit();
-    else if (code == KC_MS_WH_DOWN)  mouse_report.v = wheel_unit() * -1;
-    else if (code == KC_MS_WH_LEFT)  mouse_report.h = wheel_unit() * -1;
-    else if (code == KC_MS_WH_RIGHT) mouse_report.h = wheel_unit();
+    uint8_t bit = dir_bit(code);
+    if (bit) {
+        if (!mousekey_dirs) {
+            /* a tap moves one step, holding the key starts the motion after the delay */
+            mousekey_moving = false;
+            mousekey_time = 0;
+            rem_x = rem_y = rem_v = rem_h = 0;
+            last_timer = timer_read();
+            if      (bit == MK_UP)       mouse_report.y = -unit(move_speed(), MOUSEKEY_MOVE_MAX);
+            else if (bit == MK_DOWN)     mouse_report.y = unit(move_speed(), MOUSEKEY_MOVE_MAX);
+            else if (bit == MK_LEFT)     mouse_report.x = -unit(move_speed(), MOUSEKEY_MOVE_MAX);
+            else if (bit == MK_RIGHT)    mouse_report.x = unit(move_speed(), MOUSEKEY_MOVE_MAX);
+            else if (bit == MK_WH_UP)    mouse_report.v = unit(wheel_speed(), MOUSEKEY_WHEEL_MAX);
+            else if (bit == MK_WH_DOWN)  mouse_report.v = -unit(wheel_speed(), MOUSEKEY_WHEEL_MAX);
+            else if (bit == MK_WH_LEFT)  mouse_report.h = -unit(wheel_speed(), MOUSEKEY_WHEEL_MAX);
+            else if (bit == MK_WH_RIGHT) mouse_report.h = unit(wheel_speed(), MOUSEKEY_WHEEL_MAX);
+            timer_wheel_schedule(&mousekey_timer, mk_delay*10, mousekey_tick);
+        }
+        mousekey_dirs |= bit;
+    }
     else if (code == KC_MS_BTN1)     mouse_report.buttons |= MOUSE_BTN1;
     else if (code == KC_MS_BTN2)     mouse_report.buttons |= MOUSE_BTN2;
     else if (code == KC_MS_BTN3)     mouse_report.buttons |= MOUSE_BTN3;
@@ -147,14 +243,15 @@ void mousekey_on(uint8_t code)
 
 void mousekey_off(uint8_t code)
 {
-    if      (code == KC_MS_UP       && mouse_report.y < 0) mouse_report.y = 0;
-    else if (code == KC_MS_DOWN     && mouse_report.y > 0) mouse_report.y = 0;
-    else if (code == KC_MS_LEFT     && mouse_report.x < 0) mouse_report.x = 0;
-    else if (code == KC_MS_RIGHT    && mouse_report.x > 0) mouse_report.x = 0;
-    else if (code == KC_MS_WH_UP    && mouse_report.v > 0) mouse_report.v = 0;
-    else if (code == KC_MS_WH_DOWN  && mouse_report.v < 0) mouse_report.v = 0;
-    else if (code == KC_MS_WH_LEFT  && mouse_report.h < 0) mouse_report.h = 0;
-    else if (code == KC_MS_WH_RIGHT && mouse_report.h > 0) mouse_report.h = 0;
+    uint8_t bit = dir_bit(code);
+    if (bit) {
+        mousekey_dirs &= ~bit;
+        if (!mousekey_dirs) {
+            mousekey_moving = false;
+            mousekey_time = 0;
+            timer_wheel_cancel(&mousekey_timer);
+        }
+    }
     else if (code == KC_MS_BTN1) mouse_report.buttons &= ~MOUSE_BTN1;
     else if (code == KC_MS_BTN2) mouse_report.buttons &= ~MOUSE_BTN2;
     else if (code == KC_MS_BTN3) mouse_report.buttons &= ~MOUSE_BTN3;
@@ -163,34 +260,35 @@ void mousekey_off(uint8_t code)
     else if (code == KC_MS_ACCEL0) mousekey_accel &= ~(1<<0);
     else if (code == KC_MS_ACCEL1) mousekey_accel &= ~(1<<1);
     else if (code == KC_MS_ACCEL2) mousekey_accel &= ~(1<<2);
-
-    if (mouse_report.x == 0 && mouse_report.y == 0 && mouse_report.v == 0 && mouse_report.h == 0)
-        mousekey_repeat = 0;
 }
 
 void mousekey_send(void)
 {
     mousekey_debug();
     host_mouse_send(&mouse_report);
-    last_timer = timer_read();
+    /* the motion is relative, it must only be sent once */
+    mouse_report.x = mouse_report.y = mouse_report.v = mouse_report.h = 0;
 }
 
 void mousekey_clear(void)
 {
     mouse_report = (report_mouse_t){};
-    mousekey_repeat = 0;
+    mousekey_dirs = 0;
+    mousekey_moving = false;
+    mousekey_time = 0;
     mousekey_accel = 0;
+    timer_wheel_cancel(&mousekey_timer);
 }
 
 static void mousekey_debug(void)
 {
     if (!debug_mouse) return;
-    print("mousekey [btn|x y v h](rep/acl): [");
+    print("mousekey [btn|x y v h](ms/acl): [");
     phex(mouse_report.buttons); print("|");
     print_decs(mouse_report.x); print(" ");
     print_decs(mouse_report.y); print(" ");
     print_decs(mouse_report.v); print(" ");
     print_decs(mouse_report.h); print("](");
-    print_dec(mousekey_repeat); print("/");
+    print_dec(mousekey_time); print("/");
     print_dec(mousekey_accel); print(")\n");
 }
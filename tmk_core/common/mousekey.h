@@ -59,6 +59,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MOUSEKEY_WHEEL_TIME_TO_MAX
 #define MOUSEKEY_WHEEL_TIME_TO_MAX 40
 #endif
+/* milliseconds between reports while moving, the USB mouse endpoint poll rate */
+#ifndef MOUSEKEY_TICK
+#define MOUSEKEY_TICK 10
+#endif
+
+/* acceleration curves */
+#define MK_CURVE_LINEAR     0
+#define MK_CURVE_QUADRATIC  1
+#define MK_CURVE_CUBIC      2
+#define MK_CURVE_CONSTANT   3   /* max speed right after the delay */
+#define MK_CURVE_COUNT      4
+#ifndef MOUSEKEY_CURVE
+#define MOUSEKEY_CURVE MK_CURVE_LINEAR
+#endif
 
 
 #ifdef __cplusplus
@@ -71,6 +85,7 @@ extern uint8_t mk_max_speed;
 extern uint8_t mk_time_to_max;
 extern uint8_t mk_wheel_max_speed;
 extern uint8_t mk_wheel_time_to_max;
+extern uint8_t mk_curve;
 
 
 void mousekey_task(void);
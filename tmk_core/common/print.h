@@ -132,6 +132,20 @@ void print_set_sendchar(int8_t (*print_sendchar_func)(uint8_t));
 
 #endif /* __AVR__ / PROTOCOL_CHIBIOS / __arm__ */
 
+#if defined(BINLOG_ENABLE) && !defined(USER_PRINT)
+
+// Only the string addresses and raw arguments are logged, the text is
+// rebuilt on the host, see binlog.h
+#  include "binlog.h"
+#  undef print
+#  undef println
+#  undef xprintf
+#  define print(s)           binlog_print(BINLOG_STRING(s))
+#  define println(s)         binlog_print(BINLOG_STRING(s "\r\n"))
+#  define xprintf(fmt, ...)  binlog_printf(BINLOG_STRING(fmt), ##__VA_ARGS__)
+
+#endif /* BINLOG_ENABLE */
+
 // User print disables the normal print messages in the body of QMK/TMK code and
 // is meant as a lightweight alternative to NOPRINT. Use it when you only want to do
 // a spot of debugging but lack flash resources for allowing all of the codebase to
@@ -0,0 +1,170 @@
+#include <string.h>
+#include "raw_hid_channel.h"
+#include "raw_hid.h"
+#ifdef TELEMETRY_ENABLE
+#include "telemetry.h"
+#endif
+
+typedef struct {
+    uint8_t command;
+    raw_hid_handler_t handler;
+} channel_t;
+
+static channel_t channels[RAW_HID_CHANNEL_HANDLERS];
+static uint8_t channel_count = 0;
+
+/* the message being received */
+static bool receiving = false;
+static raw_hid_chunk_t chunk;
+static uint8_t next_sequence;
+
+/* head and tail run freely, only the slot index is masked */
+static uint8_t queue[RAW_HID_CHANNEL_QUEUE][RAW_EPSIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_tail = 0;
+
+static raw_hid_channel_stats_t stats;
+
+static channel_t *find_channel(uint8_t command)
+{
+    for (uint8_t i = 0; i < channel_count; i++) {
+        if (channels[i].command == command) {
+            return &channels[i];
+        }
+    }
+    return NULL;
+}
+
+bool raw_hid_channel_register(uint8_t command, raw_hid_handler_t handler)
+{
+#ifdef TELEMETRY_ENABLE
+    // the host couldn't tell the replies from telemetry packets
+    if (command == TELEMETRY_PACKET_MARKER) {
+        return false;
+    }
+#endif
+    channel_t *channel = find_channel(command);
+    if (!handler) {
+        if (channel) {
+            *channel = channels[--channel_count];
+        }
+        if (receiving && chunk.command == command) {
+            receiving = false;
+        }
+        return true;
+    }
+    if (!channel) {
+        if (channel_count == RAW_HID_CHANNEL_HANDLERS) {
+            return false;
+        }
+        channel = &channels[channel_count++];
+        channel->command = command;
+    }
+    channel->handler = handler;
+    return true;
+}
+
+static void drop(void)
+{
+    if (stats.errors < 0xFF) stats.errors++;
+    receiving = false;
+}
+
+void raw_hid_channel_receive(uint8_t *data, uint8_t length)
+{
+    channel_t *channel = length >= RAW_HID_CHANNEL_HEADER ? find_channel(data[0]) : NULL;
+    if (!channel) {
+        raw_hid_receive(data, length);
+        return;
+    }
+    uint8_t sequence = data[1];
+    uint16_t total = data[2] | (uint16_t)data[3] << 8;
+    if (sequence & RAW_HID_CHANNEL_START) {
+        if (receiving) {
+            // the rest of the previous message never came
+            drop();
+        }
+        receiving = true;
+        chunk.command = data[0];
+        chunk.length = total;
+        chunk.offset = 0;
+        next_sequence = 0;
+    } else if (!receiving || data[0] != chunk.command || total != chunk.length) {
+        drop();
+        return;
+    }
+    if ((sequence & ~RAW_HID_CHANNEL_START) != next_sequence) {
+        drop();
+        return;
+    }
+
+    uint16_t left = chunk.length - chunk.offset;
+    uint8_t size = length - RAW_HID_CHANNEL_HEADER;
+    if (size > left) {
+        size = left;
+    }
+    stats.received++;
+    channel->handler(&chunk, data + RAW_HID_CHANNEL_HEADER, size);
+    chunk.offset += size;
+    next_sequence = (next_sequence + 1) & ~RAW_HID_CHANNEL_START;
+    if (chunk.offset == chunk.length) {
+        receiving = false;
+    }
+}
+
+uint8_t raw_hid_channel_queue_space(void)
+{
+    return RAW_HID_CHANNEL_QUEUE - (uint8_t)(queue_head - queue_tail);
+}
+
+bool raw_hid_channel_send(uint8_t command, const uint8_t *data, uint16_t length)
+{
+    // an empty message still takes a packet
+    uint16_t packets = length ? (length + RAW_HID_CHANNEL_PAYLOAD - 1) / RAW_HID_CHANNEL_PAYLOAD : 1;
+    if (packets > raw_hid_channel_queue_space()) {
+        return false;
+    }
+    for (uint8_t sequence = 0; sequence < packets; sequence++) {
+        uint8_t *packet = queue[queue_head & (RAW_HID_CHANNEL_QUEUE - 1)];
+        uint16_t offset = sequence * RAW_HID_CHANNEL_PAYLOAD;
+        uint16_t size = length - offset;
+        if (size > RAW_HID_CHANNEL_PAYLOAD) {
+            size = RAW_HID_CHANNEL_PAYLOAD;
+        }
+        packet[0] = command;
+        packet[1] = sequence ? sequence & ~RAW_HID_CHANNEL_START : RAW_HID_CHANNEL_START;
+        packet[2] = length & 0xFF;
+        packet[3] = length >> 8;
+        if (size) {
+            memcpy(packet + RAW_HID_CHANNEL_HEADER, data + offset, size);
+        }
+        memset(packet + RAW_HID_CHANNEL_HEADER + size, 0, RAW_HID_CHANNEL_PAYLOAD - size);
+        queue_head++;
+    }
+    return true;
+}
+
+void raw_hid_channel_task(void)
+{
+    while (queue_tail != queue_head) {
+        if (!raw_hid_send(queue[queue_tail & (RAW_HID_CHANNEL_QUEUE - 1)], RAW_EPSIZE)) {
+            // the host isn't ready, try again on the next loop
+            return;
+        }
+        queue_tail++;
+        stats.sent++;
+    }
+}
+
+const raw_hid_channel_stats_t *raw_hid_channel_stats(void)
+{
+    return &stats;
+}
+
+void raw_hid_channel_reset(void)
+{
+    channel_count = 0;
+    receiving = false;
+    queue_head = queue_tail = 0;
+    memset(&stats, 0, sizeof(stats));
+}
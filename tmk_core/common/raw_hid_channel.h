@@ -0,0 +1,82 @@
+#ifndef RAW_HID_CHANNEL_H
+#define RAW_HID_CHANNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Raw HID channels
+ *
+ * Lets several features share the raw HID endpoint. Every packet starts with
+ * a command ID, and messages longer than one packet are split over several
+ * packets with a sequence number, see docs/raw_hid.md for the format.
+ *
+ * Features register a handler for their command. The handler is called for
+ * each packet straight from the buffer the endpoint was read into, with the
+ * offset of the chunk in the message, so nothing is copied or reassembled.
+ * Packets for commands without a handler still go to raw_hid_receive().
+ *
+ * Replies are queued and sent by raw_hid_channel_task() whenever the host is
+ * ready, so neither side waits for the other.
+ */
+
+#ifndef RAW_EPSIZE
+#define RAW_EPSIZE 32
+#endif
+
+/* command, sequence, message length */
+#define RAW_HID_CHANNEL_HEADER 4
+#define RAW_HID_CHANNEL_PAYLOAD (RAW_EPSIZE - RAW_HID_CHANNEL_HEADER)
+/* set in the sequence byte of the first packet of a message */
+#define RAW_HID_CHANNEL_START 0x80
+
+/* commands that can have a handler at the same time */
+#ifndef RAW_HID_CHANNEL_HANDLERS
+#define RAW_HID_CHANNEL_HANDLERS 8
+#endif
+
+/* packets waiting for the host, a power of two */
+#ifndef RAW_HID_CHANNEL_QUEUE
+#define RAW_HID_CHANNEL_QUEUE 4
+#endif
+
+#if RAW_HID_CHANNEL_QUEUE & (RAW_HID_CHANNEL_QUEUE - 1)
+#error "RAW_HID_CHANNEL_QUEUE must be a power of two"
+#endif
+
+/* where a chunk belongs, the message is complete when
+ * offset + the chunk length reaches length
+ */
+typedef struct {
+    uint8_t command;
+    uint16_t length;
+    uint16_t offset;
+} raw_hid_chunk_t;
+
+typedef void (*raw_hid_handler_t)(const raw_hid_chunk_t *chunk, uint8_t *data, uint8_t length);
+
+typedef struct {
+    uint16_t received;      // packets given to a handler
+    uint16_t sent;          // packets the host has taken
+    uint8_t errors;         // packets out of sequence, their message is dropped
+} raw_hid_channel_stats_t;
+
+/* Replaces the handler of the command, NULL removes it. Returns false when
+ * all RAW_HID_CHANNEL_HANDLERS are in use, or for the command of telemetry
+ * packets when TELEMETRY_ENABLE is set.
+ */
+bool raw_hid_channel_register(uint8_t command, raw_hid_handler_t handler);
+/* Called with every packet read from the OUT endpoint */
+void raw_hid_channel_receive(uint8_t *data, uint8_t length);
+/* Queues a whole message, or nothing and returns false when the queue
+ * doesn't have room for all of its packets.
+ */
+bool raw_hid_channel_send(uint8_t command, const uint8_t *data, uint16_t length);
+/* Sends the queued packets that the host is ready for */
+void raw_hid_channel_task(void);
+
+uint8_t raw_hid_channel_queue_space(void);
+const raw_hid_channel_stats_t *raw_hid_channel_stats(void);
+/* Forgets the handlers, the queue and the message being received */
+void raw_hid_channel_reset(void);
+
+#endif
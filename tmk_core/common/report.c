@@ -50,11 +50,17 @@ uint8_t get_first_key(report_keyboard_t* keyboard_report)
     } while (i != cb_tail);
     return keyboard_report->keys[i];
 #else
-    return keyboard_report->keys[0];
+    // keys[0] is empty when the key in it was released before the others
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (keyboard_report->keys[i]) {
+            return keyboard_report->keys[i];
+        }
+    }
+    return 0;
 #endif
 }
 
-void add_key_byte(report_keyboard_t* keyboard_report, uint8_t code)
+bool add_key_byte(report_keyboard_t* keyboard_report, uint8_t code)
 {
 #ifdef USB_6KRO_ENABLE
     int8_t i = cb_head;
@@ -62,7 +68,7 @@ void add_key_byte(report_keyboard_t* keyboard_report, uint8_t code)
     if (cb_count) {
         do {
             if (keyboard_report->keys[i] == code) {
-                return;
+                return false;
             }
             if (empty == -1 && keyboard_report->keys[i] == 0) {
                 empty = i;
@@ -101,6 +107,7 @@ void add_key_byte(report_keyboard_t* keyboard_report, uint8_t code)
     keyboard_report->keys[cb_tail] = code;
     cb_tail = RO_INC(cb_tail);
     cb_count++;
+    return true;
 #else
     int8_t i = 0;
     int8_t empty = -1;
@@ -115,12 +122,14 @@ void add_key_byte(report_keyboard_t* keyboard_report, uint8_t code)
     if (i == KEYBOARD_REPORT_KEYS) {
         if (empty != -1) {
             keyboard_report->keys[empty] = code;
+            return true;
         }
     }
+    return false;
 #endif
 }
 
-void del_key_byte(report_keyboard_t* keyboard_report, uint8_t code)
+bool del_key_byte(report_keyboard_t* keyboard_report, uint8_t code)
 {
 #ifdef USB_6KRO_ENABLE
     uint8_t i = cb_head;
@@ -142,60 +151,68 @@ void del_key_byte(report_keyboard_t* keyboard_report, uint8_t code)
                         }
                     } while (cb_tail != cb_head);
                 }
-                break;
+                return true;
             }
             i = RO_INC(i);
         } while (i != cb_tail);
     }
+    return false;
 #else
+    bool found = false;
     for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
         if (keyboard_report->keys[i] == code) {
             keyboard_report->keys[i] = 0;
+            found = true;
         }
     }
+    return found;
 #endif
 }
 
 #ifdef NKRO_ENABLE
-void add_key_bit(report_keyboard_t* keyboard_report, uint8_t code)
+bool add_key_bit(report_keyboard_t* keyboard_report, uint8_t code)
 {
     if ((code>>3) < KEYBOARD_REPORT_BITS) {
+        uint8_t bits = keyboard_report->nkro.bits[code>>3];
         keyboard_report->nkro.bits[code>>3] |= 1<<(code&7);
+        return bits != keyboard_report->nkro.bits[code>>3];
     } else {
         dprintf("add_key_bit: can't add: %02X\n", code);
+        return false;
     }
 }
 
-void del_key_bit(report_keyboard_t* keyboard_report, uint8_t code)
+bool del_key_bit(report_keyboard_t* keyboard_report, uint8_t code)
 {
     if ((code>>3) < KEYBOARD_REPORT_BITS) {
+        uint8_t bits = keyboard_report->nkro.bits[code>>3];
         keyboard_report->nkro.bits[code>>3] &= ~(1<<(code&7));
+        return bits != keyboard_report->nkro.bits[code>>3];
     } else {
         dprintf("del_key_bit: can't del: %02X\n", code);
+        return false;
     }
 }
 #endif
 
-void add_key_to_report(report_keyboard_t* keyboard_report, int8_t key)
+bool add_key_to_report(report_keyboard_t* keyboard_report, int8_t key)
 {
 #ifdef NKRO_ENABLE
     if (keyboard_protocol && keymap_config.nkro) {
-        add_key_bit(keyboard_report, key);
-        return;
+        return add_key_bit(keyboard_report, key);
     }
 #endif
-    add_key_byte(keyboard_report, key);
+    return add_key_byte(keyboard_report, key);
 }
 
-void del_key_from_report(report_keyboard_t* keyboard_report, uint8_t key)
+bool del_key_from_report(report_keyboard_t* keyboard_report, uint8_t key)
 {
 #ifdef NKRO_ENABLE
     if (keyboard_protocol && keymap_config.nkro) {
-        del_key_bit(keyboard_report, key);
-        return;
+        return del_key_bit(keyboard_report, key);
     }
 #endif
-    del_key_byte(keyboard_report, key);
+    return del_key_byte(keyboard_report, key);
 }
 
 void clear_keys_from_report(report_keyboard_t* keyboard_report)
@@ -204,4 +221,68 @@ void clear_keys_from_report(report_keyboard_t* keyboard_report)
     for (int8_t i = 1; i < KEYBOARD_REPORT_SIZE; i++) {
         keyboard_report->raw[i] = 0;
     }
-}
\ No newline at end of file
+}
+void report_state_add_key(report_keyboard_state_t* state, uint8_t key)
+{
+    if (!add_key_to_report(&state->report, key)) {
+        return;
+    }
+    state->dirty = true;
+    if (state->key_count == 0) {
+        state->first_key = key;
+    }
+#ifdef NKRO_ENABLE
+    if (keyboard_protocol && keymap_config.nkro) {
+        state->key_count++;
+        return;
+    }
+#endif
+    // A full 6KRO report drops the oldest key to make room
+    if (state->key_count < KEYBOARD_REPORT_KEYS) {
+        state->key_count++;
+    } else {
+        state->first_key = 0;
+    }
+}
+
+void report_state_del_key(report_keyboard_state_t* state, uint8_t key)
+{
+    if (!del_key_from_report(&state->report, key)) {
+        return;
+    }
+    state->dirty = true;
+    state->key_count--;
+    if (state->first_key == key) {
+        state->first_key = 0;
+    }
+}
+
+void report_state_clear_keys(report_keyboard_state_t* state)
+{
+    if (state->key_count) {
+        clear_keys_from_report(&state->report);
+        state->key_count = 0;
+        state->first_key = 0;
+        state->dirty = true;
+    }
+}
+
+void report_state_set_mods(report_keyboard_state_t* state, uint8_t mods)
+{
+    if (state->report.mods != mods) {
+        state->report.mods = mods;
+        state->dirty = true;
+    }
+}
+
+uint8_t report_state_first_key(report_keyboard_state_t* state)
+{
+    if (state->key_count == 0) {
+        return 0;
+    }
+    // Only scan the report when the key the hint pointed to was released
+    if (state->first_key == 0) {
+        state->first_key = get_first_key(&state->report);
+    }
+    return state->first_key;
+}
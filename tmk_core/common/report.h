@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define REPORT_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "keycode.h"
 
 
@@ -135,6 +136,16 @@ typedef union {
 #endif
 } __attribute__ ((packed)) report_keyboard_t;
 
+/* Keyboard report along with state that is kept up to date as keys are
+ * added and deleted, so that it doesn't have to be worked out by scanning
+ * the whole report */
+typedef struct {
+    report_keyboard_t report;
+    uint8_t key_count;      /* number of keys in the report */
+    uint8_t first_key;      /* hint for report_state_first_key, 0 if unknown */
+    bool dirty;             /* changed since it was last sent */
+} report_keyboard_state_t;
+
 typedef struct {
     uint8_t buttons;
     int8_t x;
@@ -177,17 +188,24 @@ typedef struct {
 uint8_t has_anykey(report_keyboard_t* keyboard_report);
 uint8_t get_first_key(report_keyboard_t* keyboard_report);
 
-void add_key_byte(report_keyboard_t* keyboard_report, uint8_t code);
-void del_key_byte(report_keyboard_t* keyboard_report, uint8_t code);
+/* these return true if the report was changed */
+bool add_key_byte(report_keyboard_t* keyboard_report, uint8_t code);
+bool del_key_byte(report_keyboard_t* keyboard_report, uint8_t code);
 #ifdef NKRO_ENABLE
-void add_key_bit(report_keyboard_t* keyboard_report, uint8_t code);
-void del_key_bit(report_keyboard_t* keyboard_report, uint8_t code);
+bool add_key_bit(report_keyboard_t* keyboard_report, uint8_t code);
+bool del_key_bit(report_keyboard_t* keyboard_report, uint8_t code);
 #endif
 
-void add_key_to_report(report_keyboard_t* keyboard_report, int8_t key);
-void del_key_from_report(report_keyboard_t* keyboard_report, uint8_t key);
+bool add_key_to_report(report_keyboard_t* keyboard_report, int8_t key);
+bool del_key_from_report(report_keyboard_t* keyboard_report, uint8_t key);
 void clear_keys_from_report(report_keyboard_t* keyboard_report);
 
+void report_state_add_key(report_keyboard_state_t* state, uint8_t key);
+void report_state_del_key(report_keyboard_state_t* state, uint8_t key);
+void report_state_clear_keys(report_keyboard_state_t* state);
+void report_state_set_mods(report_keyboard_state_t* state, uint8_t mods);
+uint8_t report_state_first_key(report_keyboard_state_t* state);
+
 #ifdef __cplusplus
 }
 #endif
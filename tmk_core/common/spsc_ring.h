@@ -0,0 +1,259 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+/*--------------------------------------------------------------------
+ * Lock-free single producer / single consumer ring buffer
+ *
+ * One side (typically an ISR or a thread) only puts data in, and the other
+ * side (typically the main loop) only takes data out. The producer owns the
+ * head index and the consumer owns the tail index, so no interrupts need to be
+ * disabled and no locks are taken.
+ *
+ * - The size must be a power of two, at most 256, and the ring holds size - 1
+ *   elements. Indexes are single bytes, so they are read and written
+ *   atomically even on the AVR.
+ * - The element data is written before the head is published (release), and
+ *   the consumer reads the head before the data (acquire), and the other way
+ *   around for the tail. On the AVR and single core Cortex-M this only stops
+ *   the compiler from reordering, on the host it also orders the CPUs.
+ *
+ * The C interface handles bytes, the C++ template below handles any
+ * trivially copyable type with the same index logic.
+ *------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define SPSC_RING_LOAD_ACQUIRE(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SPSC_RING_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+typedef struct {
+    uint8_t *data;
+    uint8_t mask;           /* size - 1 */
+    uint8_t head;           /* next slot to write, only written by the producer */
+    uint8_t tail;           /* next slot to read, only written by the consumer */
+} spsc_ring_t;
+
+/* Define a statically allocated byte ring; size must be a power of two */
+#define SPSC_RING_DEFINE(name, size) \
+    typedef char name##_size_must_be_a_power_of_two[((size) & ((size) - 1)) == 0 && (size) <= 256 ? 1 : -1]; \
+    static uint8_t name##_data[size]; \
+    static spsc_ring_t name = { name##_data, (uint8_t)((size) - 1), 0, 0 }
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline void spsc_ring_init(spsc_ring_t *ring, uint8_t *data, uint16_t size)
+{
+    ring->data = data;
+    ring->mask = size - 1;
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+/* Number of elements that can be read; safe to call from both sides */
+static inline uint8_t spsc_ring_count(const spsc_ring_t *ring)
+{
+    uint8_t head = SPSC_RING_LOAD_ACQUIRE(&ring->head);
+    uint8_t tail = SPSC_RING_LOAD_ACQUIRE(&ring->tail);
+    return (head - tail) & ring->mask;
+}
+
+/* Number of elements that can be written; safe to call from both sides */
+static inline uint8_t spsc_ring_space(const spsc_ring_t *ring)
+{
+    return ring->mask - spsc_ring_count(ring);
+}
+
+static inline bool spsc_ring_empty(const spsc_ring_t *ring)
+{
+    return SPSC_RING_LOAD_ACQUIRE(&ring->head) == SPSC_RING_LOAD_ACQUIRE(&ring->tail);
+}
+
+/* Producer: add one byte, returns false if the ring is full */
+static inline bool spsc_ring_put(spsc_ring_t *ring, uint8_t data)
+{
+    uint8_t head = ring->head;
+    uint8_t next = (head + 1) & ring->mask;
+    if (next == SPSC_RING_LOAD_ACQUIRE(&ring->tail)) {
+        return false;
+    }
+    ring->data[head] = data;
+    SPSC_RING_STORE_RELEASE(&ring->head, next);
+    return true;
+}
+
+/* Producer: add up to len bytes, returns the number of bytes added */
+static inline uint8_t spsc_ring_write(spsc_ring_t *ring, const uint8_t *src, uint8_t len)
+{
+    uint8_t head = ring->head;
+    uint8_t tail = SPSC_RING_LOAD_ACQUIRE(&ring->tail);
+    uint8_t space = (tail - head - 1) & ring->mask;
+    if (len > space) {
+        len = space;
+    }
+    /* Copy in at most two runs, up to the end of the buffer and from the start */
+    uint16_t first = (uint16_t)ring->mask + 1 - head;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&ring->data[head], src, first);
+    memcpy(ring->data, src + first, len - first);
+    SPSC_RING_STORE_RELEASE(&ring->head, (head + len) & ring->mask);
+    return len;
+}
+
+/* Consumer: take one byte, returns false if the ring is empty */
+static inline bool spsc_ring_get(spsc_ring_t *ring, uint8_t *data)
+{
+    uint8_t tail = ring->tail;
+    if (tail == SPSC_RING_LOAD_ACQUIRE(&ring->head)) {
+        return false;
+    }
+    *data = ring->data[tail];
+    SPSC_RING_STORE_RELEASE(&ring->tail, (tail + 1) & ring->mask);
+    return true;
+}
+
+/* Consumer: take up to len bytes, returns the number of bytes taken */
+static inline uint8_t spsc_ring_read(spsc_ring_t *ring, uint8_t *dst, uint8_t len)
+{
+    uint8_t tail = ring->tail;
+    uint8_t count = (SPSC_RING_LOAD_ACQUIRE(&ring->head) - tail) & ring->mask;
+    if (len > count) {
+        len = count;
+    }
+    uint16_t first = (uint16_t)ring->mask + 1 - tail;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(dst, &ring->data[tail], first);
+    memcpy(dst + first, ring->data, len - first);
+    SPSC_RING_STORE_RELEASE(&ring->tail, (tail + len) & ring->mask);
+    return len;
+}
+
+/* Consumer: look at the byte index positions from the oldest one without
+ * taking it; index must be less than spsc_ring_count */
+static inline uint8_t spsc_ring_peek(const spsc_ring_t *ring, uint8_t index)
+{
+    return ring->data[(ring->tail + index) & ring->mask];
+}
+
+/* Consumer: get the longest run of readable bytes that is contiguous in
+ * memory, so that it can be processed in place. Returns its length, which is
+ * 0 when the ring is empty. Follow with spsc_ring_skip. */
+static inline uint8_t spsc_ring_peek_run(const spsc_ring_t *ring, const uint8_t **run)
+{
+    uint8_t tail = ring->tail;
+    uint8_t count = (SPSC_RING_LOAD_ACQUIRE(&ring->head) - tail) & ring->mask;
+    uint16_t to_end = (uint16_t)ring->mask + 1 - tail;
+    *run = &ring->data[tail];
+    return count < to_end ? count : to_end;
+}
+
+/* Consumer: drop len bytes, which must not be more than spsc_ring_count */
+static inline void spsc_ring_skip(spsc_ring_t *ring, uint8_t len)
+{
+    SPSC_RING_STORE_RELEASE(&ring->tail, (ring->tail + len) & ring->mask);
+}
+
+/* Consumer: drop everything that has been written so far */
+static inline void spsc_ring_clear(spsc_ring_t *ring)
+{
+    SPSC_RING_STORE_RELEASE(&ring->tail, SPSC_RING_LOAD_ACQUIRE(&ring->head));
+}
+
+#ifdef __cplusplus
+}
+
+// A ring holding Size - 1 elements of type T, Size being a power of two
+template <typename T, uint16_t Size>
+class SpscRing {
+  static_assert(Size > 1 && Size <= 256 && (Size & (Size - 1)) == 0,
+                "SpscRing size must be a power of two, at most 256");
+  static const uint8_t Mask = Size - 1;
+
+ protected:
+  T buf_[Size];
+  uint8_t head_{0}, tail_{0};
+
+ public:
+  // Producer
+  inline bool enqueue(const T &item) {
+    uint8_t head = head_;
+    uint8_t next = (head + 1) & Mask;
+    if (next == SPSC_RING_LOAD_ACQUIRE(&tail_)) {
+      // Full
+      return false;
+    }
+    buf_[head] = item;
+    SPSC_RING_STORE_RELEASE(&head_, next);
+    return true;
+  }
+
+  // Consumer; when commit is false the item is only peeked at
+  inline bool get(T &dest, bool commit = true) {
+    uint8_t tail = tail_;
+    if (tail == SPSC_RING_LOAD_ACQUIRE(&head_)) {
+      // No more data
+      return false;
+    }
+    dest = buf_[tail];
+    if (commit) {
+      SPSC_RING_STORE_RELEASE(&tail_, (tail + 1) & Mask);
+    }
+    return true;
+  }
+
+  // Consumer: take up to len items, returns the number taken
+  inline uint8_t get(T *dest, uint8_t len) {
+    uint8_t tail = tail_;
+    uint8_t count = (SPSC_RING_LOAD_ACQUIRE(&head_) - tail) & Mask;
+    if (len > count) {
+      len = count;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+      dest[i] = buf_[(tail + i) & Mask];
+    }
+    SPSC_RING_STORE_RELEASE(&tail_, (tail + len) & Mask);
+    return len;
+  }
+
+  // Producer: add up to len items, returns the number added
+  inline uint8_t enqueue(const T *src, uint8_t len) {
+    uint8_t head = head_;
+    uint8_t space = (SPSC_RING_LOAD_ACQUIRE(&tail_) - head - 1) & Mask;
+    if (len > space) {
+      len = space;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+      buf_[(head + i) & Mask] = src[i];
+    }
+    SPSC_RING_STORE_RELEASE(&head_, (head + len) & Mask);
+    return len;
+  }
+
+  inline bool peek(T &item) { return get(item, false); }
+
+  inline bool empty() const {
+    return SPSC_RING_LOAD_ACQUIRE(&head_) == SPSC_RING_LOAD_ACQUIRE(&tail_);
+  }
+
+  inline uint8_t size() const {
+    return (SPSC_RING_LOAD_ACQUIRE(&head_) - SPSC_RING_LOAD_ACQUIRE(&tail_)) & Mask;
+  }
+
+  // Consumer: the oldest item; only valid when not empty
+  inline T &front() { return buf_[tail_]; }
+
+ protected:
+  inline uint8_t prevPosition(uint8_t position) const {
+    return (position - 1) & Mask;
+  }
+};
+#endif
+
+#endif /* SPSC_RING_H */
@@ -0,0 +1,82 @@
+#include <string.h>
+#include "telemetry.h"
+#include "spsc_ring.h"
+#include "timer.h"
+#ifdef RAW_ENABLE
+#include "raw_hid.h"
+#endif
+
+#ifndef RAW_EPSIZE
+#define RAW_EPSIZE 32
+#endif
+
+SPSC_RING_DEFINE(telemetry_ring, TELEMETRY_BUFFER_SIZE);
+static uint8_t sequence = 0;
+static uint8_t dropped = 0;
+
+static uint32_t scan_timer = 0;
+static uint16_t scan_count = 0;
+
+void telemetry_record(uint8_t type, uint8_t arg, uint16_t value)
+{
+    telemetry_record_t record = {
+        .type = type,
+        .arg = arg,
+        .value = value,
+        .time = timer_read32(),
+    };
+    if (spsc_ring_space(&telemetry_ring) < sizeof(record)) {
+        if (dropped < 0xFF) dropped++;
+        return;
+    }
+    spsc_ring_write(&telemetry_ring, (const uint8_t *)&record, sizeof(record));
+}
+
+void telemetry_scan(void)
+{
+    if (scan_count < 0xFFFF) scan_count++;
+    if (TIMER_DIFF_32(timer_read32(), scan_timer) >= 1000) {
+        telemetry_record(TELEMETRY_SCAN_RATE, 0, scan_count);
+        scan_timer = timer_read32();
+        scan_count = 0;
+    }
+}
+
+/* Moves as many records as fit into packet, and returns how many that was.
+ * Nothing is written when there are no records.
+ */
+uint8_t telemetry_fill_packet(uint8_t *packet, uint8_t size)
+{
+    uint8_t count = spsc_ring_count(&telemetry_ring) / sizeof(telemetry_record_t);
+    uint8_t room = (size - TELEMETRY_PACKET_HEADER) / sizeof(telemetry_record_t);
+    if (count == 0) {
+        return 0;
+    }
+    if (count > room) {
+        count = room;
+    }
+    memset(packet, 0, size);
+    packet[0] = TELEMETRY_PACKET_MARKER;
+    packet[1] = sequence++;
+    packet[2] = count;
+    packet[3] = dropped;
+    dropped = 0;
+    spsc_ring_read(&telemetry_ring, packet + TELEMETRY_PACKET_HEADER, count * sizeof(telemetry_record_t));
+    return count;
+}
+
+void telemetry_task(void)
+{
+#ifdef RAW_ENABLE
+    static uint8_t packet[RAW_EPSIZE];
+    static bool pending = false;
+
+    // a packet the host wasn't ready for is sent again
+    if (!pending) {
+        pending = telemetry_fill_packet(packet, sizeof(packet));
+    }
+    if (pending && raw_hid_send(packet, sizeof(packet))) {
+        pending = false;
+    }
+#endif
+}
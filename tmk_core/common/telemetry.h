@@ -0,0 +1,74 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Telemetry
+ *
+ * Timestamped events are collected in a ring and streamed to the host over
+ * the raw HID endpoint, so that latency can be measured on a production
+ * board without the console. See docs/telemetry.md for the packet format.
+ */
+
+/* event types */
+enum telemetry_event {
+    TELEMETRY_SCAN_RATE = 1,    // value: matrix scans in the last second
+    TELEMETRY_KEY_DOWN,         // arg: row, value: col
+    TELEMETRY_KEY_UP,           // arg: row, value: col
+    TELEMETRY_REPORT,           // arg: TELEMETRY_REPORT_*
+    TELEMETRY_STALL,            // arg: endpoint, report not sent in time
+    TELEMETRY_TAP,              // arg: tap count, value: row << 8 | col
+    TELEMETRY_HOLD,             // arg: TELEMETRY_HOLD_*, value: row << 8 | col
+    TELEMETRY_COMBO,            // arg: combo index, value: TELEMETRY_COMBO_*
+    TELEMETRY_TRACE_VALUE,      // arg: traced variable << 4 | byte offset, value: two bytes of it
+    TELEMETRY_TRACE_LINE,       // arg: traced variable | TELEMETRY_TRACE_LINE_AFTER, value: line
+};
+
+enum telemetry_report {
+    TELEMETRY_REPORT_KEYBOARD,
+    TELEMETRY_REPORT_MOUSE,
+    TELEMETRY_REPORT_SYSTEM,
+    TELEMETRY_REPORT_CONSUMER,
+};
+
+enum telemetry_hold {
+    TELEMETRY_HOLD_TIMEOUT,
+    TELEMETRY_HOLD_INTERRUPTED,
+};
+
+enum telemetry_combo {
+    TELEMETRY_COMBO_TIMEOUT,
+    TELEMETRY_COMBO_FIRED,
+};
+
+/* the line of the check that saw the change, without it the one before */
+#define TELEMETRY_TRACE_LINE_AFTER 0x80
+
+typedef struct {
+    uint8_t type;
+    uint8_t arg;
+    uint16_t value;
+    uint32_t time;
+} __attribute__ ((packed)) telemetry_record_t;
+
+/* packet: marker, sequence number, record count, dropped records, records */
+#define TELEMETRY_PACKET_MARKER 0x54
+#define TELEMETRY_PACKET_HEADER 4
+
+#ifndef TELEMETRY_BUFFER_SIZE
+#define TELEMETRY_BUFFER_SIZE 256
+#endif
+
+#ifdef TELEMETRY_ENABLE
+void telemetry_record(uint8_t type, uint8_t arg, uint16_t value);
+void telemetry_scan(void);
+uint8_t telemetry_fill_packet(uint8_t *packet, uint8_t size);
+void telemetry_task(void);
+#else
+#define telemetry_record(type, arg, value)
+#define telemetry_scan()
+#define telemetry_task()
+#endif
+
+#endif
@@ -15,19 +15,68 @@
  */
 
 #include "eeprom.h"
+#include <stdbool.h>
+#include <string.h>
 
-#define EEPROM_SIZE 32
+// Emulate the full 1KB EEPROM of the ATmega32U4
+#define EEPROM_SIZE 1024
 
 static uint8_t buffer[EEPROM_SIZE];
+static uint32_t write_counts[EEPROM_SIZE];
+static bool initialized = false;
+
+// The cells of an erased EEPROM read back as 0xFF
+void eeprom_reset(void) {
+	memset(buffer, 0xFF, sizeof(buffer));
+	memset(write_counts, 0, sizeof(write_counts));
+	initialized = true;
+}
+
+void eeprom_fill(uint8_t value) {
+	memset(buffer, value, sizeof(buffer));
+	memset(write_counts, 0, sizeof(write_counts));
+	initialized = true;
+}
+
+void eeprom_reset_counts(void) {
+	memset(write_counts, 0, sizeof(write_counts));
+}
+
+static void eeprom_check_init(void) {
+	if (!initialized) {
+		eeprom_reset();
+	}
+}
+
+uint32_t eeprom_write_count(uintptr_t offset) {
+	return offset < EEPROM_SIZE ? write_counts[offset] : 0;
+}
+
+uint32_t eeprom_total_write_count(void) {
+	uint32_t total = 0;
+	for (int i = 0; i < EEPROM_SIZE; i++) {
+		total += write_counts[i];
+	}
+	return total;
+}
 
 uint8_t eeprom_read_byte(const uint8_t *addr) {
 	uintptr_t offset = (uintptr_t)addr;
+	eeprom_check_init();
+	if (offset >= EEPROM_SIZE) {
+		return 0xFF;
+	}
 	return buffer[offset];
 }
 
 void eeprom_write_byte(uint8_t *addr, uint8_t value) {
 	uintptr_t offset = (uintptr_t)addr;
+	eeprom_check_init();
+	if (offset >= EEPROM_SIZE) {
+		return;
+	}
 	buffer[offset] = value;
+	write_counts[offset]++;
 }
 
 uint16_t eeprom_read_word(const uint16_t *addr) {
@@ -71,28 +120,32 @@ void eeprom_write_block(const void *buf, void *addr, uint32_t len) {
 	}
 }
 
+// Like the avr-libc versions, the update functions only write the bytes that
+// differ from the stored value
 void eeprom_update_byte(uint8_t *addr, uint8_t value) {
-	eeprom_write_byte(addr, value);
+	if (eeprom_read_byte(addr) != value) {
+		eeprom_write_byte(addr, value);
+	}
 }
 
 void eeprom_update_word(uint16_t *addr, uint16_t value) {
 	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p, value >> 8);
+	eeprom_update_byte(p++, value);
+	eeprom_update_byte(p, value >> 8);
 }
 
 void eeprom_update_dword(uint32_t *addr, uint32_t value) {
 	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p++, value >> 8);
-	eeprom_write_byte(p++, value >> 16);
-	eeprom_write_byte(p, value >> 24);
+	eeprom_update_byte(p++, value);
+	eeprom_update_byte(p++, value >> 8);
+	eeprom_update_byte(p++, value >> 16);
+	eeprom_update_byte(p, value >> 24);
 }
 
 void eeprom_update_block(const void *buf, void *addr, uint32_t len) {
 	uint8_t *p = (uint8_t *)addr;
 	const uint8_t *src = (const uint8_t *)buf;
 	while (len--) {
-		eeprom_write_byte(p++, *src++);
+		eeprom_update_byte(p++, *src++);
 	}
 }
@@ -15,3 +15,12 @@
  */
 
 
+
+#include "suspend.h"
+#include "eeconfig.h"
+
+void suspend_power_down(void) {
+#ifdef EECONFIG_CACHE_ENABLE
+    eeconfig_flush();
+#endif
+}
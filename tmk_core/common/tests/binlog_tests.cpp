@@ -0,0 +1,215 @@
+#include "gtest/gtest.h"
+#include <string.h>
+#include <thread>
+#include <atomic>
+
+extern "C" {
+#include "binlog.h"
+
+static bool host_ready = true;
+static unsigned packets_sent = 0;
+
+bool binlog_send(uint8_t *packet, uint8_t length) {
+    if (host_ready) {
+        packets_sent++;
+    }
+    return host_ready;
+}
+}
+
+static const uint8_t ptr_size = sizeof(const char*);
+
+class Binlog : public testing::Test {
+public:
+    Binlog() {
+        // drain whatever the previous test left behind
+        while (binlog_fill_packet(packet, sizeof(packet)));
+        host_ready = true;
+        packets_sent = 0;
+        position = 1;
+    }
+
+    // the next record of the packet
+    uint8_t header() {
+        return packet[position];
+    }
+
+    const char* string() {
+        const char* result;
+        memcpy(&result, packet + position + 1, ptr_size);
+        return result;
+    }
+
+    const uint8_t* args() {
+        return packet + position + 1 + ptr_size;
+    }
+
+    void next() {
+        position += (header() & ~BINLOG_TEXT) + ptr_size;
+    }
+
+    uint8_t packet[BINLOG_PACKET_SIZE];
+    uint8_t position;
+};
+
+TEST_F(Binlog, NothingToSendWithoutRecords) {
+    EXPECT_EQ(binlog_fill_packet(packet, sizeof(packet)), 0);
+    binlog_task();
+    EXPECT_EQ(packets_sent, 0);
+}
+
+TEST_F(Binlog, PrintOnlyLogsTheString) {
+    const char* text = "Keyboard start.\n";
+    binlog_print(text);
+    ASSERT_EQ(binlog_fill_packet(packet, sizeof(packet)), 1);
+    EXPECT_EQ(packet[0], 0);
+    EXPECT_EQ(header(), BINLOG_TEXT | 1);
+    EXPECT_EQ(string(), text);
+    next();
+    EXPECT_EQ(header(), 0);
+}
+
+TEST_F(Binlog, ArgumentsAreCopiedRaw) {
+    const char* format = "%02X %d %lu%%";
+    binlog_printf(format, 0xAB, -2, 100000ul);
+    ASSERT_EQ(binlog_fill_packet(packet, sizeof(packet)), 1);
+    EXPECT_EQ(header(), 1 + 2 * sizeof(int) + sizeof(long));
+    EXPECT_EQ(string(), format);
+    int i;
+    long l;
+    memcpy(&i, args(), sizeof(i));
+    EXPECT_EQ(i, 0xAB);
+    memcpy(&i, args() + sizeof(int), sizeof(i));
+    EXPECT_EQ(i, -2);
+    memcpy(&l, args() + 2 * sizeof(int), sizeof(l));
+    EXPECT_EQ(l, 100000);
+}
+
+TEST_F(Binlog, StringsInRamAreCopied) {
+    char name[] = "a very long layer name";
+    const char* flash = "flash";
+    binlog_printf("%s %S", name, flash);
+    name[0] = 'b';
+    ASSERT_EQ(binlog_fill_packet(packet, sizeof(packet)), 1);
+    EXPECT_EQ(header(), 1 + BINLOG_STRING_MAX + 1 + ptr_size);
+    EXPECT_EQ(memcmp(args(), "a very long ", BINLOG_STRING_MAX), 0);
+    EXPECT_EQ(args()[BINLOG_STRING_MAX], 0);
+    const char* copied;
+    memcpy(&copied, args() + BINLOG_STRING_MAX + 1, ptr_size);
+    EXPECT_EQ(copied, flash);
+}
+
+TEST_F(Binlog, ArgumentsThatDontFitAreLeftOut) {
+    binlog_printf("%ld %ld %ld %ld %ld %ld %ld %ld", 1l, 2l, 3l, 4l, 5l, 6l, 7l, 8l);
+    ASSERT_EQ(binlog_fill_packet(packet, sizeof(packet)), 1);
+    uint8_t fit = (BINLOG_RECORD_MAX - 1 - ptr_size) / sizeof(long);
+    EXPECT_EQ(header(), 1 + fit * sizeof(long));
+    long l;
+    memcpy(&l, args() + (fit - 1) * sizeof(long), sizeof(l));
+    EXPECT_EQ(l, fit);
+}
+
+TEST_F(Binlog, PacketsOnlyHoldWholeRecords) {
+    const uint8_t record_size = 1 + ptr_size + sizeof(int);
+    const uint8_t per_packet = (BINLOG_PACKET_SIZE - 1) / record_size;
+    for (int i = 0; i < per_packet + 1; i++) {
+        binlog_printf("%d", i);
+    }
+    ASSERT_EQ(binlog_fill_packet(packet, sizeof(packet)), per_packet);
+    for (int i = 0; i < per_packet; i++) {
+        int value;
+        memcpy(&value, args(), sizeof(value));
+        EXPECT_EQ(value, i);
+        next();
+    }
+    for (; position < sizeof(packet); position++) {
+        EXPECT_EQ(packet[position], 0);
+    }
+    position = 1;
+    ASSERT_EQ(binlog_fill_packet(packet, sizeof(packet)), 1);
+    int value;
+    memcpy(&value, args(), sizeof(value));
+    EXPECT_EQ(value, per_packet);
+}
+
+TEST_F(Binlog, DroppedRecordsAreCounted) {
+    const uint8_t record_size = 1 + ptr_size;
+    const uint8_t capacity = (BINLOG_BUFFER_SIZE - 1) / record_size;
+    for (int i = 0; i < capacity + 4; i++) {
+        binlog_print("x");
+    }
+    ASSERT_GT(binlog_fill_packet(packet, sizeof(packet)), 0);
+    EXPECT_EQ(packet[0], 4);
+    ASSERT_GT(binlog_fill_packet(packet, sizeof(packet)), 0);
+    EXPECT_EQ(packet[0], 0);
+}
+
+TEST_F(Binlog, PacketIsKeptUntilTheHostIsReady) {
+    binlog_print("x");
+    host_ready = false;
+    binlog_task();
+    binlog_task();
+    EXPECT_EQ(packets_sent, 0);
+    host_ready = true;
+    binlog_task();
+    EXPECT_EQ(packets_sent, 1);
+    binlog_task();
+    EXPECT_EQ(packets_sent, 1);
+}
+
+// Like the main loop and a ChibiOS thread both logging while binlog_task()
+// sends the records
+TEST_F(Binlog, SeveralThreadsCanLogAtOnce) {
+    const int per_thread = 5000;
+    const char* format = "%d";
+    std::atomic<int> running(2);
+    auto producer = [&](int tag) {
+        for (int i = 0; i < per_thread; i++) {
+            binlog_printf(format, tag << 24 | i);
+            // let the other thread in between records on a single core too
+            std::this_thread::yield();
+        }
+        running--;
+    };
+    std::thread first(producer, 1);
+    std::thread second(producer, 2);
+
+    int received[3] = {0, 0, 0};
+    int expected[3] = {0, 0, 0};
+    int dropped = 0;
+    bool saturated = false;
+    for (;;) {
+        // read before draining, so that nothing is logged after the last look
+        bool done = running == 0;
+        uint8_t count = binlog_fill_packet(packet, sizeof(packet));
+        if (count == 0) {
+            if (done) {
+                break;
+            }
+            continue;
+        }
+        dropped += packet[0];
+        saturated |= packet[0] == 0xFF;
+        position = 1;
+        for (uint8_t i = 0; i < count; i++, next()) {
+            ASSERT_EQ(header(), sizeof(int) + 1);
+            ASSERT_EQ(string(), format);
+            int value;
+            memcpy(&value, args(), sizeof(value));
+            int tag = value >> 24;
+            ASSERT_TRUE(tag == 1 || tag == 2) << value;
+            // records of one thread stay in order, dropped ones leave gaps
+            ASSERT_GE(value & 0xFFFFFF, expected[tag]);
+            expected[tag] = (value & 0xFFFFFF) + 1;
+            received[tag]++;
+        }
+    }
+    first.join();
+    second.join();
+
+    EXPECT_GT(received[1], 0);
+    EXPECT_GT(received[2], 0);
+    if (!saturated) {
+        EXPECT_EQ(received[1] + received[2] + dropped, 2 * per_thread);
+    }
+}
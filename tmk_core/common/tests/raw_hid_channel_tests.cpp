@@ -0,0 +1,251 @@
+#include "gtest/gtest.h"
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+extern "C" {
+#include "raw_hid.h"
+#include "raw_hid_channel.h"
+#include "telemetry.h"
+}
+
+typedef std::vector<uint8_t> Packet;
+
+static std::vector<Packet> legacy;
+static std::vector<Packet> in_reports;
+static bool host_ready = true;
+
+extern "C" {
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    legacy.push_back(Packet(data, data + length));
+}
+
+bool raw_hid_send(uint8_t *data, uint8_t length) {
+    if (!host_ready) {
+        return false;
+    }
+    in_reports.push_back(Packet(data, data + length));
+    return true;
+}
+}
+
+struct Chunk {
+    uint8_t command;
+    uint16_t length;
+    uint16_t offset;
+    const uint8_t *data;
+    Packet bytes;
+};
+
+static std::vector<Chunk> chunks;
+
+static void record(const raw_hid_chunk_t *chunk, uint8_t *data, uint8_t length) {
+    chunks.push_back(Chunk{chunk->command, chunk->length, chunk->offset, data, Packet(data, data + length)});
+}
+
+static void echo(const raw_hid_chunk_t *chunk, uint8_t *data, uint8_t length) {
+    // single packet messages only, replied to from the endpoint buffer
+    raw_hid_channel_send(chunk->command, data, length);
+}
+
+// splits a message the way a host tool does
+static std::vector<Packet> frame(uint8_t command, const Packet& message) {
+    std::vector<Packet> packets;
+    uint16_t offset = 0;
+    uint8_t sequence = 0;
+    do {
+        Packet packet(RAW_EPSIZE, 0);
+        packet[0] = command;
+        packet[1] = sequence ? sequence & 0x7F : RAW_HID_CHANNEL_START;
+        packet[2] = message.size() & 0xFF;
+        packet[3] = message.size() >> 8;
+        size_t size = std::min<size_t>(message.size() - offset, RAW_HID_CHANNEL_PAYLOAD);
+        std::copy(message.begin() + offset, message.begin() + offset + size, packet.begin() + RAW_HID_CHANNEL_HEADER);
+        packets.push_back(packet);
+        offset += size;
+        sequence++;
+    } while (offset < message.size());
+    return packets;
+}
+
+static Packet make_message(size_t size, uint8_t seed) {
+    Packet message;
+    for (size_t i = 0; i < size; i++) {
+        message.push_back(seed + i * 3);
+    }
+    return message;
+}
+
+class RawHidChannel : public testing::Test {
+public:
+    RawHidChannel() {
+        raw_hid_channel_reset();
+        legacy.clear();
+        in_reports.clear();
+        chunks.clear();
+        host_ready = true;
+    }
+
+    void receive(Packet packet) {
+        raw_hid_channel_receive(packet.data(), packet.size());
+    }
+
+    void receive(const std::vector<Packet>& packets) {
+        for (Packet packet : packets) {
+            receive(packet);
+        }
+    }
+
+    Packet reassemble() {
+        Packet message;
+        for (const Chunk& chunk : chunks) {
+            EXPECT_EQ(chunk.offset, message.size());
+            message.insert(message.end(), chunk.bytes.begin(), chunk.bytes.end());
+        }
+        return message;
+    }
+};
+
+TEST_F(RawHidChannel, PacketsWithoutAHandlerGoToRawHidReceive) {
+    raw_hid_channel_register(0x10, record);
+    Packet packet(RAW_EPSIZE, 0x22);
+    receive(packet);
+    ASSERT_EQ(legacy.size(), 1);
+    EXPECT_EQ(legacy[0], packet);
+    EXPECT_TRUE(chunks.empty());
+}
+
+TEST_F(RawHidChannel, HandlerGetsTheEndpointBuffer) {
+    raw_hid_channel_register(0x10, record);
+    Packet packet = frame(0x10, {1, 2, 3})[0];
+    raw_hid_channel_receive(packet.data(), packet.size());
+    ASSERT_EQ(chunks.size(), 1);
+    EXPECT_EQ(chunks[0].data, packet.data() + RAW_HID_CHANNEL_HEADER);
+    EXPECT_EQ(chunks[0].bytes, Packet({1, 2, 3}));
+    EXPECT_EQ(chunks[0].length, 3);
+    EXPECT_EQ(chunks[0].offset, 0);
+    EXPECT_TRUE(legacy.empty());
+}
+
+TEST_F(RawHidChannel, LongMessagesArriveInChunks) {
+    raw_hid_channel_register(0x10, record);
+    Packet message = make_message(200 * RAW_HID_CHANNEL_PAYLOAD + 5, 7);
+    receive(frame(0x10, message));
+    EXPECT_EQ(chunks.size(), 201);
+    EXPECT_EQ(chunks.back().length, message.size());
+    EXPECT_EQ(reassemble(), message);
+    EXPECT_EQ(raw_hid_channel_stats()->errors, 0);
+}
+
+TEST_F(RawHidChannel, EmptyMessageCallsTheHandlerOnce) {
+    raw_hid_channel_register(0x10, record);
+    receive(frame(0x10, {}));
+    ASSERT_EQ(chunks.size(), 1);
+    EXPECT_EQ(chunks[0].length, 0);
+    EXPECT_TRUE(chunks[0].bytes.empty());
+}
+
+TEST_F(RawHidChannel, LostPacketDropsTheMessage) {
+    raw_hid_channel_register(0x10, record);
+    std::vector<Packet> packets = frame(0x10, make_message(100, 1));
+    packets.erase(packets.begin() + 1);
+    receive(packets);
+    EXPECT_EQ(chunks.size(), 1);
+    // both packets after the gap are dropped
+    EXPECT_EQ(raw_hid_channel_stats()->errors, 2);
+
+    // the next message starts over
+    chunks.clear();
+    Packet message = make_message(60, 9);
+    receive(frame(0x10, message));
+    EXPECT_EQ(reassemble(), message);
+}
+
+TEST_F(RawHidChannel, NewMessageAbandonsAnUnfinishedOne) {
+    raw_hid_channel_register(0x10, record);
+    raw_hid_channel_register(0x11, record);
+    std::vector<Packet> first = frame(0x10, make_message(100, 1));
+    receive(first[0]);
+    chunks.clear();
+    Packet message = make_message(40, 5);
+    receive(frame(0x11, message));
+    EXPECT_EQ(reassemble(), message);
+    EXPECT_EQ(raw_hid_channel_stats()->errors, 1);
+    receive(first[1]);
+    EXPECT_EQ(chunks.size(), 2);
+    EXPECT_EQ(raw_hid_channel_stats()->errors, 2);
+}
+
+TEST_F(RawHidChannel, HandlersCanBeReplacedAndRemoved) {
+    for (uint8_t i = 0; i < RAW_HID_CHANNEL_HANDLERS; i++) {
+        EXPECT_TRUE(raw_hid_channel_register(i, echo));
+    }
+    EXPECT_FALSE(raw_hid_channel_register(0x40, record));
+    EXPECT_TRUE(raw_hid_channel_register(2, record));
+    EXPECT_TRUE(raw_hid_channel_register(3, NULL));
+    EXPECT_TRUE(raw_hid_channel_register(0x40, record));
+    receive(frame(2, {1}));
+    receive(frame(0x40, {2}));
+    EXPECT_EQ(chunks.size(), 2);
+    receive(frame(3, {3}));
+    EXPECT_EQ(legacy.size(), 1);
+}
+
+TEST_F(RawHidChannel, TelemetryCommandCantBeRegistered) {
+    EXPECT_FALSE(raw_hid_channel_register(TELEMETRY_PACKET_MARKER, record));
+    receive(frame(TELEMETRY_PACKET_MARKER, {1}));
+    EXPECT_EQ(chunks.size(), 0);
+    EXPECT_EQ(legacy.size(), 1);
+}
+
+TEST_F(RawHidChannel, MessagesAreQueuedWhole) {
+    EXPECT_EQ(raw_hid_channel_queue_space(), RAW_HID_CHANNEL_QUEUE);
+    Packet message = make_message(RAW_HID_CHANNEL_PAYLOAD + 1, 3);
+    host_ready = false;
+    EXPECT_TRUE(raw_hid_channel_send(0x20, message.data(), message.size()));
+    EXPECT_EQ(raw_hid_channel_queue_space(), RAW_HID_CHANNEL_QUEUE - 2);
+    Packet large = make_message(RAW_HID_CHANNEL_QUEUE * RAW_HID_CHANNEL_PAYLOAD, 0);
+    EXPECT_FALSE(raw_hid_channel_send(0x21, large.data(), large.size()));
+    EXPECT_EQ(raw_hid_channel_queue_space(), RAW_HID_CHANNEL_QUEUE - 2);
+
+    raw_hid_channel_task();
+    EXPECT_TRUE(in_reports.empty());
+    host_ready = true;
+    raw_hid_channel_task();
+    EXPECT_EQ(in_reports, frame(0x20, message));
+    EXPECT_EQ(raw_hid_channel_stats()->sent, 2);
+    EXPECT_TRUE(raw_hid_channel_send(0x21, large.data(), large.size()));
+}
+
+TEST_F(RawHidChannel, QueueWrapsAround) {
+    for (int i = 0; i < 300; i++) {
+        Packet message = make_message(i % (2 * RAW_HID_CHANNEL_PAYLOAD), i);
+        ASSERT_TRUE(raw_hid_channel_send(i, message.data(), message.size()));
+        in_reports.clear();
+        raw_hid_channel_task();
+        ASSERT_EQ(in_reports, frame(i, message)) << "message " << i;
+    }
+}
+
+// Echoes single packet messages through the receive path, the handler, the
+// queue and the IN endpoint, as the loopback of a host tool would. Only
+// reports the number, the timing on a shared machine is too noisy to assert on.
+TEST_F(RawHidChannel, DISABLED_LoopbackThroughput) {
+    const uint32_t count = 1000000;
+    raw_hid_channel_register(0x30, echo);
+    Packet packet = frame(0x30, make_message(RAW_HID_CHANNEL_PAYLOAD, 1))[0];
+    uint32_t echoed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+        packet[RAW_HID_CHANNEL_HEADER] = i;
+        raw_hid_channel_receive(packet.data(), packet.size());
+        raw_hid_channel_task();
+        if (in_reports.back()[RAW_HID_CHANNEL_HEADER] == (uint8_t)i) {
+            echoed++;
+        }
+        in_reports.pop_back();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(echoed, count);
+    std::cout << "loopback: " << count / elapsed.count() / 1e6 << " million messages per second" << std::endl;
+}
@@ -0,0 +1,28 @@
+COMMON_TEST_PATH := $(TMK_PATH)/common/tests
+
+common_binlog_DEFS := -DBINLOG_ENABLE
+common_binlog_SRC :=\
+	$(COMMON_TEST_PATH)/binlog_tests.cpp \
+	$(TMK_PATH)/common/binlog.c
+common_binlog_INC := $(TMK_PATH)/common
+
+common_raw_hid_channel_DEFS := -DRAW_ENABLE -DTELEMETRY_ENABLE
+common_raw_hid_channel_SRC :=\
+	$(COMMON_TEST_PATH)/raw_hid_channel_tests.cpp \
+	$(TMK_PATH)/common/raw_hid_channel.c
+common_raw_hid_channel_INC := $(TMK_PATH)/common
+
+common_spsc_ring_SRC :=\
+	$(COMMON_TEST_PATH)/spsc_ring_tests.cpp
+common_spsc_ring_INC := $(TMK_PATH)/common
+
+common_telemetry_DEFS := -DTELEMETRY_ENABLE
+common_telemetry_SRC :=\
+	$(COMMON_TEST_PATH)/telemetry_tests.cpp \
+	$(TMK_PATH)/common/telemetry.c
+common_telemetry_INC := $(TMK_PATH)/common
+
+common_timer_wheel_SRC :=\
+	$(COMMON_TEST_PATH)/timer_wheel_tests.cpp \
+	$(TMK_PATH)/common/timer_wheel.c
+common_timer_wheel_INC := $(TMK_PATH)/common
@@ -0,0 +1,328 @@
+#include "gtest/gtest.h"
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+#include "spsc_ring.h"
+
+class SpscRingTest : public testing::Test {
+public:
+    SpscRingTest() {
+        spsc_ring_init(&ring, data, sizeof(data));
+    }
+    uint8_t data[16];
+    spsc_ring_t ring;
+};
+
+TEST_F(SpscRingTest, StartsEmpty) {
+    uint8_t val;
+    EXPECT_TRUE(spsc_ring_empty(&ring));
+    EXPECT_EQ(spsc_ring_count(&ring), 0);
+    EXPECT_EQ(spsc_ring_space(&ring), 15);
+    EXPECT_FALSE(spsc_ring_get(&ring, &val));
+}
+
+TEST_F(SpscRingTest, BytesComeOutInOrder) {
+    EXPECT_TRUE(spsc_ring_put(&ring, 1));
+    EXPECT_TRUE(spsc_ring_put(&ring, 2));
+    EXPECT_EQ(spsc_ring_count(&ring), 2);
+    uint8_t val;
+    EXPECT_TRUE(spsc_ring_get(&ring, &val));
+    EXPECT_EQ(val, 1);
+    EXPECT_TRUE(spsc_ring_get(&ring, &val));
+    EXPECT_EQ(val, 2);
+    EXPECT_TRUE(spsc_ring_empty(&ring));
+}
+
+TEST_F(SpscRingTest, HoldsSizeMinusOneBytes) {
+    for (uint8_t i = 0; i < 15; i++) {
+        EXPECT_TRUE(spsc_ring_put(&ring, i));
+    }
+    EXPECT_FALSE(spsc_ring_put(&ring, 15));
+    EXPECT_EQ(spsc_ring_space(&ring), 0);
+    uint8_t val;
+    for (uint8_t i = 0; i < 15; i++) {
+        EXPECT_TRUE(spsc_ring_get(&ring, &val));
+        EXPECT_EQ(val, i);
+    }
+}
+
+TEST_F(SpscRingTest, WrapsAround) {
+    uint8_t val;
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(spsc_ring_put(&ring, i));
+        EXPECT_TRUE(spsc_ring_put(&ring, i + 1));
+        EXPECT_TRUE(spsc_ring_get(&ring, &val));
+        EXPECT_EQ(val, i);
+        EXPECT_TRUE(spsc_ring_get(&ring, &val));
+        EXPECT_EQ(val, i + 1);
+    }
+    EXPECT_TRUE(spsc_ring_empty(&ring));
+}
+
+TEST_F(SpscRingTest, BatchWriteAndReadWrapAround) {
+    uint8_t in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint8_t out[10];
+    EXPECT_EQ(spsc_ring_write(&ring, in, 10), 10);
+    EXPECT_EQ(spsc_ring_read(&ring, out, 10), 10);
+    // This one is split across the end of the buffer
+    EXPECT_EQ(spsc_ring_write(&ring, in, 10), 10);
+    EXPECT_EQ(spsc_ring_count(&ring), 10);
+    memset(out, 0, sizeof(out));
+    EXPECT_EQ(spsc_ring_read(&ring, out, 10), 10);
+    EXPECT_EQ(memcmp(in, out, 10), 0);
+}
+
+TEST_F(SpscRingTest, BatchWriteStopsWhenFull) {
+    uint8_t in[20] = {0};
+    EXPECT_EQ(spsc_ring_write(&ring, in, 20), 15);
+    EXPECT_EQ(spsc_ring_write(&ring, in, 1), 0);
+}
+
+TEST_F(SpscRingTest, BatchReadStopsWhenEmpty) {
+    uint8_t in[3] = {7, 8, 9};
+    uint8_t out[10];
+    spsc_ring_write(&ring, in, 3);
+    EXPECT_EQ(spsc_ring_read(&ring, out, 10), 3);
+    EXPECT_EQ(out[2], 9);
+    EXPECT_EQ(spsc_ring_read(&ring, out, 10), 0);
+}
+
+TEST_F(SpscRingTest, PeekDoesNotConsume) {
+    spsc_ring_put(&ring, 5);
+    spsc_ring_put(&ring, 6);
+    EXPECT_EQ(spsc_ring_peek(&ring, 0), 5);
+    EXPECT_EQ(spsc_ring_peek(&ring, 1), 6);
+    EXPECT_EQ(spsc_ring_count(&ring), 2);
+    spsc_ring_skip(&ring, 1);
+    EXPECT_EQ(spsc_ring_peek(&ring, 0), 6);
+}
+
+TEST_F(SpscRingTest, PeekRunStopsAtTheEndOfTheBuffer) {
+    uint8_t in[14] = {0};
+    const uint8_t* run;
+    spsc_ring_write(&ring, in, 12);
+    spsc_ring_skip(&ring, 12);
+    spsc_ring_write(&ring, in, 14);
+    EXPECT_EQ(spsc_ring_peek_run(&ring, &run), 4);
+    EXPECT_EQ(run, &data[12]);
+    spsc_ring_skip(&ring, 4);
+    EXPECT_EQ(spsc_ring_peek_run(&ring, &run), 10);
+    EXPECT_EQ(run, &data[0]);
+}
+
+TEST_F(SpscRingTest, ClearEmptiesTheRing) {
+    spsc_ring_put(&ring, 1);
+    spsc_ring_put(&ring, 2);
+    spsc_ring_clear(&ring);
+    EXPECT_TRUE(spsc_ring_empty(&ring));
+    EXPECT_EQ(spsc_ring_space(&ring), 15);
+}
+
+SPSC_RING_DEFINE(full_size_ring, 256);
+
+TEST(SpscRing, FullSizeRingUsesAllIndexes) {
+    for (int i = 0; i < 255; i++) {
+        EXPECT_TRUE(spsc_ring_put(&full_size_ring, i));
+    }
+    EXPECT_FALSE(spsc_ring_put(&full_size_ring, 0));
+    EXPECT_EQ(spsc_ring_count(&full_size_ring), 255);
+    uint8_t val;
+    for (int i = 0; i < 255; i++) {
+        EXPECT_TRUE(spsc_ring_get(&full_size_ring, &val));
+        EXPECT_EQ(val, i);
+    }
+    EXPECT_TRUE(spsc_ring_empty(&full_size_ring));
+}
+
+struct Item {
+    uint32_t seq;
+    uint16_t a;
+    uint8_t b;
+};
+
+TEST(SpscRingTemplate, ItemsComeOutInOrder) {
+    SpscRing<Item, 4> ring;
+    EXPECT_TRUE(ring.empty());
+    EXPECT_TRUE(ring.enqueue(Item{1, 2, 3}));
+    EXPECT_TRUE(ring.enqueue(Item{4, 5, 6}));
+    EXPECT_TRUE(ring.enqueue(Item{7, 8, 9}));
+    EXPECT_FALSE(ring.enqueue(Item{0, 0, 0}));
+    EXPECT_EQ(ring.size(), 3);
+    Item item;
+    EXPECT_TRUE(ring.peek(item));
+    EXPECT_EQ(item.seq, 1);
+    EXPECT_EQ(ring.front().seq, 1);
+    EXPECT_TRUE(ring.get(item));
+    EXPECT_EQ(item.seq, 1);
+    EXPECT_TRUE(ring.get(item));
+    EXPECT_EQ(item.seq, 4);
+    EXPECT_TRUE(ring.get(item));
+    EXPECT_EQ(item.seq, 7);
+    EXPECT_FALSE(ring.get(item));
+}
+
+TEST(SpscRingTemplate, BatchEnqueueAndGet) {
+    SpscRing<uint16_t, 8> ring;
+    uint16_t in[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    uint16_t out[10];
+    EXPECT_EQ(ring.enqueue(in, 5), 5);
+    EXPECT_EQ(ring.get(out, 3), 3);
+    EXPECT_EQ(ring.enqueue(in + 5, 5), 5);
+    EXPECT_EQ(ring.enqueue(in, 1), 0);
+    EXPECT_EQ(ring.get(out + 3, 10), 7);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(out[i], i + 1);
+    }
+}
+
+// The producer and the consumer run on their own threads, like an ISR and
+// the main loop, and the consumer checks that nothing is lost or reordered.
+static const uint32_t stress_count = 2000000;
+
+TEST_F(SpscRingTest, StressSingleBytes) {
+    std::thread producer([this]() {
+        for (uint32_t i = 0; i < stress_count; i++) {
+            while (!spsc_ring_put(&ring, i & 0xFF)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < stress_count; i++) {
+        uint8_t val;
+        while (!spsc_ring_get(&ring, &val)) {
+            std::this_thread::yield();
+        }
+        errors += val != (i & 0xFF);
+    }
+    producer.join();
+    EXPECT_EQ(errors, 0);
+    EXPECT_TRUE(spsc_ring_empty(&ring));
+}
+
+TEST_F(SpscRingTest, StressBatches) {
+    std::thread producer([this]() {
+        uint8_t buf[7];
+        uint32_t sent = 0;
+        while (sent < stress_count) {
+            uint8_t len = 1 + sent % 7;
+            if (len > stress_count - sent) {
+                len = stress_count - sent;
+            }
+            for (uint8_t i = 0; i < len; i++) {
+                buf[i] = (sent + i) & 0xFF;
+            }
+            uint8_t done = 0;
+            while (done < len) {
+                uint8_t n = spsc_ring_write(&ring, buf + done, len - done);
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+                done += n;
+            }
+            sent += len;
+        }
+    });
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    while (received < stress_count) {
+        uint8_t buf[5];
+        uint8_t len = spsc_ring_read(&ring, buf, sizeof(buf));
+        if (len == 0) {
+            std::this_thread::yield();
+        }
+        for (uint8_t i = 0; i < len; i++) {
+            errors += buf[i] != ((received + i) & 0xFF);
+        }
+        received += len;
+    }
+    producer.join();
+    EXPECT_EQ(errors, 0);
+}
+
+TEST(SpscRingTemplate, Stress) {
+    SpscRing<Item, 32> ring;
+    std::thread producer([&ring]() {
+        for (uint32_t i = 0; i < stress_count; i++) {
+            Item item = {i, (uint16_t)~i, (uint8_t)(i * 3)};
+            while (!ring.enqueue(item)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < stress_count; i++) {
+        Item item;
+        while (!ring.get(item)) {
+            std::this_thread::yield();
+        }
+        errors += item.seq != i || item.a != (uint16_t)~i || item.b != (uint8_t)(i * 3);
+    }
+    producer.join();
+    EXPECT_EQ(errors, 0);
+}
+
+// The ring the way it was done before, with a lock around every operation
+class MutexRing {
+public:
+    bool put(uint8_t data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint8_t next = (head_ + 1) % sizeof(buf_);
+        if (next == tail_) {
+            return false;
+        }
+        buf_[head_] = data;
+        head_ = next;
+        return true;
+    }
+    bool get(uint8_t* data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (head_ == tail_) {
+            return false;
+        }
+        *data = buf_[tail_];
+        tail_ = (tail_ + 1) % sizeof(buf_);
+        return true;
+    }
+private:
+    std::mutex mutex_;
+    uint8_t buf_[256];
+    uint8_t head_ = 0;
+    uint8_t tail_ = 0;
+};
+
+template<typename Put, typename Get>
+static double measure_mbytes_per_second(Put put, Get get) {
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&put]() {
+        for (uint32_t i = 0; i < stress_count; i++) {
+            while (!put(i & 0xFF)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (uint32_t i = 0; i < stress_count; i++) {
+        uint8_t val;
+        while (!get(&val)) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return stress_count / elapsed.count() / 1e6;
+}
+
+// Prints the throughput of the ring next to a locked queue. The timing on a
+// shared machine is too noisy to assert on.
+TEST(SpscRing, DISABLED_Throughput) {
+    MutexRing mutex_ring;
+    double locked = measure_mbytes_per_second(
+        [&](uint8_t v) { return mutex_ring.put(v); },
+        [&](uint8_t* v) { return mutex_ring.get(v); });
+    double lock_free = measure_mbytes_per_second(
+        [&](uint8_t v) { return spsc_ring_put(&full_size_ring, v); },
+        [&](uint8_t* v) { return spsc_ring_get(&full_size_ring, v); });
+    std::cout << "mutex ring " << locked << " MB/s, spsc ring "
+              << lock_free << " MB/s" << std::endl;
+}
@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include <string.h>
+
+extern "C" {
+#include "telemetry.h"
+
+static uint32_t now = 0;
+
+uint32_t timer_read32(void) {
+    return now;
+}
+}
+
+static const uint8_t packet_size = 32;
+static const uint8_t records_per_packet = (packet_size - TELEMETRY_PACKET_HEADER) / sizeof(telemetry_record_t);
+
+class Telemetry : public testing::Test {
+public:
+    Telemetry() {
+        // drain whatever the previous test left behind
+        while (telemetry_fill_packet(packet, packet_size));
+        now = 0;
+    }
+
+    telemetry_record_t record(uint8_t index) {
+        telemetry_record_t result;
+        memcpy(&result, packet + TELEMETRY_PACKET_HEADER + index * sizeof(result), sizeof(result));
+        return result;
+    }
+
+    uint8_t packet[packet_size];
+};
+
+TEST_F(Telemetry, RecordsAreEightBytes) {
+    EXPECT_EQ(sizeof(telemetry_record_t), 8);
+    EXPECT_EQ(records_per_packet, 3);
+}
+
+TEST_F(Telemetry, NothingToSendWithoutRecords) {
+    EXPECT_EQ(telemetry_fill_packet(packet, packet_size), 0);
+}
+
+TEST_F(Telemetry, RecordsArePacked) {
+    now = 1234;
+    telemetry_record(TELEMETRY_KEY_DOWN, 2, 3);
+    now = 1240;
+    telemetry_record(TELEMETRY_REPORT, TELEMETRY_REPORT_KEYBOARD, 0);
+    ASSERT_EQ(telemetry_fill_packet(packet, packet_size), 2);
+    EXPECT_EQ(packet[0], TELEMETRY_PACKET_MARKER);
+    EXPECT_EQ(packet[2], 2);
+    EXPECT_EQ(packet[3], 0);
+    telemetry_record_t first = record(0);
+    EXPECT_EQ(first.type, TELEMETRY_KEY_DOWN);
+    EXPECT_EQ(first.arg, 2);
+    EXPECT_EQ(first.value, 3);
+    EXPECT_EQ(first.time, 1234);
+    EXPECT_EQ(record(1).type, TELEMETRY_REPORT);
+    EXPECT_EQ(record(1).time, 1240);
+    EXPECT_EQ(telemetry_fill_packet(packet, packet_size), 0);
+}
+
+TEST_F(Telemetry, RecordsAreSplitAcrossPackets) {
+    for (uint8_t i = 0; i < 5; i++) {
+        telemetry_record(TELEMETRY_KEY_UP, i, 0);
+    }
+    ASSERT_EQ(telemetry_fill_packet(packet, packet_size), 3);
+    uint8_t sequence = packet[1];
+    EXPECT_EQ(record(2).arg, 2);
+    ASSERT_EQ(telemetry_fill_packet(packet, packet_size), 2);
+    EXPECT_EQ(packet[1], (uint8_t)(sequence + 1));
+    EXPECT_EQ(record(0).arg, 3);
+    EXPECT_EQ(record(1).arg, 4);
+}
+
+TEST_F(Telemetry, DroppedRecordsAreCounted) {
+    uint8_t capacity = (TELEMETRY_BUFFER_SIZE - 1) / sizeof(telemetry_record_t);
+    for (uint8_t i = 0; i < capacity + 5; i++) {
+        telemetry_record(TELEMETRY_KEY_DOWN, i, 0);
+    }
+    ASSERT_EQ(telemetry_fill_packet(packet, packet_size), 3);
+    EXPECT_EQ(packet[3], 5);
+    EXPECT_EQ(record(0).arg, 0);
+    ASSERT_EQ(telemetry_fill_packet(packet, packet_size), 3);
+    EXPECT_EQ(packet[3], 0);
+}
+
+TEST_F(Telemetry, ScanRateIsRecordedEverySecond) {
+    for (now = 0; now < 2500; now++) {
+        telemetry_scan();
+        telemetry_scan();
+    }
+    ASSERT_EQ(telemetry_fill_packet(packet, packet_size), 2);
+    EXPECT_EQ(record(0).type, TELEMETRY_SCAN_RATE);
+    EXPECT_EQ(record(0).time, 1000);
+    EXPECT_EQ(record(1).time, 2000);
+    EXPECT_EQ(record(1).value, 2000);
+}
@@ -0,0 +1,6 @@
+TEST_LIST +=\
+	common_binlog \
+	common_raw_hid_channel \
+	common_spsc_ring \
+	common_telemetry \
+	common_timer_wheel
@@ -0,0 +1,176 @@
+#include "gtest/gtest.h"
+#include <vector>
+
+extern "C" {
+#include "timer_wheel.h"
+
+static uint32_t now = 0;
+
+uint32_t timer_read32(void) {
+    return now;
+}
+}
+
+struct Timeout {
+    timer_wheel_entry_t entry;
+    int id;
+};
+
+static std::vector<std::pair<int, uint32_t>> fired;
+
+static void record(timer_wheel_entry_t* entry) {
+    fired.push_back({TIMER_WHEEL_CONTAINER(entry, Timeout, entry)->id, now});
+}
+
+class TimerWheel : public testing::Test {
+public:
+    TimerWheel() {
+        now = 1000;
+        timer_wheel_init();
+        fired.clear();
+        for (int i = 0; i < 8; i++) {
+            timeouts[i] = Timeout{{}, i};
+        }
+    }
+
+    // advances the virtual time a millisecond at a time, like the scans do
+    void run(uint32_t ms) {
+        for (uint32_t i = 0; i < ms; i++) {
+            now++;
+            timer_wheel_task();
+        }
+    }
+
+    void schedule(int id, uint32_t delay, timer_wheel_callback_t callback = record) {
+        timer_wheel_schedule(&timeouts[id].entry, delay, callback);
+    }
+
+    Timeout timeouts[8];
+};
+
+TEST_F(TimerWheel, FiresAtTheDeadline) {
+    schedule(0, 5);
+    EXPECT_TRUE(timer_wheel_scheduled(&timeouts[0].entry));
+    run(4);
+    EXPECT_TRUE(fired.empty());
+    run(1);
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].second, 1005);
+    EXPECT_FALSE(timer_wheel_scheduled(&timeouts[0].entry));
+    run(100);
+    EXPECT_EQ(fired.size(), 1);
+}
+
+TEST_F(TimerWheel, ZeroDelayFiresOnTheNextMillisecond) {
+    schedule(0, 0);
+    timer_wheel_task();
+    EXPECT_TRUE(fired.empty());
+    run(1);
+    EXPECT_EQ(fired.size(), 1);
+}
+
+TEST_F(TimerWheel, SchedulingAgainRestartsTheTimer) {
+    schedule(0, 10);
+    run(8);
+    schedule(0, 10);
+    run(9);
+    EXPECT_TRUE(fired.empty());
+    run(1);
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].second, 1018);
+}
+
+TEST_F(TimerWheel, CancelledEntriesDontFire) {
+    schedule(0, 3);
+    schedule(1, 3);
+    schedule(2, 3);
+    timer_wheel_cancel(&timeouts[1].entry);
+    timer_wheel_cancel(&timeouts[1].entry);
+    EXPECT_FALSE(timer_wheel_scheduled(&timeouts[1].entry));
+    run(3);
+    ASSERT_EQ(fired.size(), 2);
+    EXPECT_NE(fired[0].first, 1);
+    EXPECT_NE(fired[1].first, 1);
+}
+
+TEST_F(TimerWheel, DeadlinesPastTheWheelWaitForTheirRound) {
+    schedule(0, TIMER_WHEEL_SLOTS * 3 + 2);
+    schedule(1, 2);
+    run(TIMER_WHEEL_SLOTS * 3 + 1);
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].first, 1);
+    run(1);
+    ASSERT_EQ(fired.size(), 2);
+    EXPECT_EQ(fired[1].first, 0);
+    EXPECT_EQ(fired[1].second, 1000 + TIMER_WHEEL_SLOTS * 3 + 2);
+}
+
+TEST_F(TimerWheel, LateTaskFiresEverythingThatExpired) {
+    for (int i = 0; i < 8; i++) {
+        schedule(i, 10 * (i + 1));
+    }
+    now += 45;
+    timer_wheel_task();
+    EXPECT_EQ(fired.size(), 4);
+    now += 1000;
+    timer_wheel_task();
+    EXPECT_EQ(fired.size(), 8);
+}
+
+static void periodic(timer_wheel_entry_t* entry) {
+    record(entry);
+    if (fired.size() < 5) {
+        timer_wheel_schedule(entry, 7, periodic);
+    }
+}
+
+TEST_F(TimerWheel, CallbacksCanScheduleTheirEntryAgain) {
+    schedule(0, 7, periodic);
+    run(100);
+    ASSERT_EQ(fired.size(), 5);
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(fired[i].second, 1000 + 7 * (i + 1));
+    }
+}
+
+static Timeout* pair[2];
+
+static void cancel_other(timer_wheel_entry_t* entry) {
+    record(entry);
+    Timeout* self = TIMER_WHEEL_CONTAINER(entry, Timeout, entry);
+    timer_wheel_cancel(&pair[self == pair[0] ? 1 : 0]->entry);
+}
+
+TEST_F(TimerWheel, CallbacksCanCancelEntriesInTheSameBucket) {
+    // both expire together, whichever runs first cancels the other
+    pair[0] = &timeouts[0];
+    pair[1] = &timeouts[1];
+    schedule(0, 4, cancel_other);
+    schedule(1, 4, cancel_other);
+    schedule(2, 4 + TIMER_WHEEL_SLOTS);
+    run(4);
+    EXPECT_EQ(fired.size(), 1);
+    run(TIMER_WHEEL_SLOTS);
+    ASSERT_EQ(fired.size(), 2);
+    EXPECT_EQ(fired[1].first, 2);
+}
+
+TEST_F(TimerWheel, EntriesWithoutCallbackOnlyStopBeingScheduled) {
+    schedule(0, 3, NULL);
+    run(2);
+    EXPECT_TRUE(timer_wheel_scheduled(&timeouts[0].entry));
+    run(1);
+    EXPECT_FALSE(timer_wheel_scheduled(&timeouts[0].entry));
+    EXPECT_TRUE(fired.empty());
+}
+
+TEST_F(TimerWheel, TimerWrapsAround) {
+    now = UINT32_MAX - 2;
+    timer_wheel_init();
+    schedule(0, 5);
+    run(4);
+    EXPECT_TRUE(fired.empty());
+    run(1);
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].second, 2);
+}
@@ -0,0 +1,84 @@
+#include "timer_wheel.h"
+#include "timer.h"
+
+#define SLOT(time) ((time) & (TIMER_WHEEL_SLOTS - 1))
+
+static timer_wheel_entry_t *slots[TIMER_WHEEL_SLOTS];
+/* the last millisecond whose bucket has been walked */
+static uint32_t wheel_time = 0;
+
+static inline bool expired(const timer_wheel_entry_t *entry, uint32_t now)
+{
+    return (int32_t)(entry->deadline - now) <= 0;
+}
+
+void timer_wheel_init(void)
+{
+    for (uint8_t i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        slots[i] = NULL;
+    }
+    wheel_time = timer_read32();
+}
+
+void timer_wheel_schedule(timer_wheel_entry_t *entry, uint32_t delay, timer_wheel_callback_t callback)
+{
+    timer_wheel_cancel(entry);
+    entry->callback = callback;
+    entry->deadline = timer_read32() + (delay ? delay : 1);
+    timer_wheel_entry_t **slot = &slots[SLOT(entry->deadline)];
+    entry->next = *slot;
+    *slot = entry;
+    entry->scheduled = true;
+}
+
+void timer_wheel_cancel(timer_wheel_entry_t *entry)
+{
+    if (!entry->scheduled) {
+        return;
+    }
+    for (timer_wheel_entry_t **link = &slots[SLOT(entry->deadline)]; *link; link = &(*link)->next) {
+        if (*link == entry) {
+            *link = entry->next;
+            break;
+        }
+    }
+    entry->scheduled = false;
+}
+
+static void run_slot(uint8_t slot, uint32_t now)
+{
+    timer_wheel_entry_t **link = &slots[slot];
+    while (*link) {
+        timer_wheel_entry_t *entry = *link;
+        if (!expired(entry, now)) {
+            // a later round of the wheel
+            link = &entry->next;
+            continue;
+        }
+        *link = entry->next;
+        entry->scheduled = false;
+        if (entry->callback) {
+            entry->callback(entry);
+        }
+        // the callback may have changed the chain
+        link = &slots[slot];
+    }
+}
+
+void timer_wheel_task(void)
+{
+    uint32_t now = timer_read32();
+    uint32_t behind = now - wheel_time;
+    if (behind == 0) {
+        return;
+    }
+    // walking every bucket once finds everything that has expired
+    if (behind > TIMER_WHEEL_SLOTS) {
+        behind = TIMER_WHEEL_SLOTS;
+    }
+    uint32_t time = now - behind;
+    wheel_time = now;
+    while (behind--) {
+        run_slot(SLOT(++time), now);
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Timer wheel
+ *
+ * Features register a deadline with an entry of their own instead of
+ * polling timer_elapsed() on every scan. Scheduled entries are chained into
+ * one of TIMER_WHEEL_SLOTS buckets by their deadline, and timer_wheel_task()
+ * only walks the buckets of the milliseconds that have passed since it last
+ * ran, so a scan costs the same however many features have timeouts.
+ *
+ * Entries are only touched from the main loop, never from an interrupt.
+ */
+
+/* buckets, a power of two */
+#ifndef TIMER_WHEEL_SLOTS
+#define TIMER_WHEEL_SLOTS 16
+#endif
+
+#if TIMER_WHEEL_SLOTS & (TIMER_WHEEL_SLOTS - 1)
+#error "TIMER_WHEEL_SLOTS must be a power of two"
+#endif
+
+typedef struct timer_wheel_entry timer_wheel_entry_t;
+
+/* Called once the deadline has passed, the entry is no longer scheduled and
+ * can be scheduled again from here.
+ */
+typedef void (*timer_wheel_callback_t)(timer_wheel_entry_t *entry);
+
+struct timer_wheel_entry {
+    timer_wheel_entry_t *next;
+    timer_wheel_callback_t callback;
+    uint32_t deadline;
+    bool scheduled;
+};
+
+/* the struct an entry is a member of, for callbacks that need their state */
+#define TIMER_WHEEL_CONTAINER(entry, type, member) ((type *)((uint8_t *)(entry) - offsetof(type, member)))
+
+void timer_wheel_init(void);
+/* (Re)starts the entry, callback may be NULL when the owner only needs
+ * timer_wheel_scheduled(). The deadline is at least 1ms away.
+ */
+void timer_wheel_schedule(timer_wheel_entry_t *entry, uint32_t delay, timer_wheel_callback_t callback);
+void timer_wheel_cancel(timer_wheel_entry_t *entry);
+/* Runs the callbacks of the entries whose deadline has passed */
+void timer_wheel_task(void);
+
+static inline bool timer_wheel_scheduled(const timer_wheel_entry_t *entry)
+{
+    return entry->scheduled;
+}
+
+#endif
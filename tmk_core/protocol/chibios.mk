@@ -5,6 +5,11 @@ CHIBIOS_DIR = $(PROTOCOL_DIR)/chibios
 SRC += $(CHIBIOS_DIR)/usb_main.c
 SRC += $(CHIBIOS_DIR)/main.c
 
+ifeq ($(strip $(SCAN_SCHEDULER_ENABLE)), yes)
+    SRC += $(CHIBIOS_DIR)/scan_scheduler.c
+    OPT_DEFS += -DSCAN_SCHEDULER_ENABLE
+endif
+
 VPATH += $(TMK_PATH)/$(PROTOCOL_DIR)
 VPATH += $(TMK_PATH)/$(CHIBIOS_DIR)
 
@@ -42,6 +42,9 @@
 #include "visualizer/visualizer.h"
 #endif
 #include "suspend.h"
+#ifdef SCAN_SCHEDULER_ENABLE
+#include "scan_scheduler.h"
+#endif
 
 
 /* -------------------------
@@ -104,6 +107,11 @@ int main(void) {
   /* init printf */
   init_printf(NULL,sendchar_pf);
 
+#ifdef SCAN_SCHEDULER_ENABLE
+  /* before the threads that can wake it up */
+  scan_scheduler_init();
+#endif
+
 #ifdef SERIAL_LINK_ENABLE
   init_serial_link();
 #endif
@@ -182,5 +190,11 @@ int main(void) {
     }
 
     keyboard_task();
+#if defined(CONSOLE_ENABLE) && defined(BINLOG_ENABLE)
+    binlog_task();
+#endif
+#ifdef SCAN_SCHEDULER_ENABLE
+    scan_scheduler_wait();
+#endif
   }
 }
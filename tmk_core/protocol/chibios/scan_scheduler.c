@@ -0,0 +1,64 @@
+#include "scan_scheduler.h"
+#include "keyboard.h"
+
+#define SCAN_PERIOD US2ST(1000000UL / SCAN_RATE)
+#define SCAN_IDLE_PERIOD US2ST(1000000UL / SCAN_IDLE_RATE)
+
+static binary_semaphore_t wakeup;
+/* set by a key interrupt, the matrix may be debouncing a press */
+static volatile bool key_interrupt = false;
+static systime_t scan_start;
+static systime_t last_active;
+static scan_scheduler_stats_t stats;
+
+void scan_scheduler_init(void)
+{
+    chBSemObjectInit(&wakeup, true);
+    scan_start = last_active = chVTGetSystemTime();
+    scan_scheduler_reset_stats();
+}
+
+void scan_scheduler_wait(void)
+{
+    systime_t now = chVTGetSystemTime();
+    stats.scans++;
+    if (keyboard_matrix_active() || key_interrupt) {
+        key_interrupt = false;
+        last_active = now;
+    }
+    systime_t period = now - last_active < MS2ST(SCAN_IDLE_TIMEOUT) ? SCAN_PERIOD : SCAN_IDLE_PERIOD;
+    systime_t busy = now - scan_start;
+    if (busy < period) {
+        // returns early if something wants a scan now
+        if (chBSemWaitTimeout(&wakeup, period - busy) == MSG_OK) {
+            stats.wakeups++;
+        }
+        stats.idle_ticks += chVTGetSystemTime() - now;
+    }
+    // when late a pending wakeup is left for the next wait, it may have come
+    // after the matrix was read
+    scan_start = chVTGetSystemTime();
+}
+
+void scan_scheduler_wakeup_i(void)
+{
+    key_interrupt = true;
+    chBSemSignalI(&wakeup);
+}
+
+void scan_scheduler_wakeup(void)
+{
+    chBSemSignal(&wakeup);
+}
+
+const scan_scheduler_stats_t *scan_scheduler_stats(void)
+{
+    return &stats;
+}
+
+void scan_scheduler_reset_stats(void)
+{
+    stats.scans = 0;
+    stats.wakeups = 0;
+    stats.idle_ticks = 0;
+}
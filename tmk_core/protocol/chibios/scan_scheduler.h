@@ -0,0 +1,54 @@
+#ifndef SCAN_SCHEDULER_H
+#define SCAN_SCHEDULER_H
+
+#include <stdint.h>
+#include "ch.h"
+
+/* Scan scheduler
+ *
+ * Instead of calling keyboard_task() back to back, the main thread sleeps
+ * until the next scan is due, so the idle thread can WFI in between. Scans
+ * run at SCAN_RATE while keys are held or changing, and drop to
+ * SCAN_IDLE_RATE once the matrix has been quiet for SCAN_IDLE_TIMEOUT ms.
+ *
+ * A board that gets an interrupt when a key goes down (a PAL or EXT
+ * callback on the columns) calls scan_scheduler_wakeup_i() from it, which
+ * scans at once and goes back to the full rate. Threads that have new input
+ * for the scan, like the serial link, call scan_scheduler_wakeup().
+ */
+
+/* scans per second while active */
+#ifndef SCAN_RATE
+#define SCAN_RATE 1000
+#endif
+
+/* scans per second while idle */
+#ifndef SCAN_IDLE_RATE
+#define SCAN_IDLE_RATE 100
+#endif
+
+/* ms without a key down or changing before the idle rate is used */
+#ifndef SCAN_IDLE_TIMEOUT
+#define SCAN_IDLE_TIMEOUT 1000
+#endif
+
+typedef struct {
+    uint32_t scans;
+    /* scans started early by a wakeup */
+    uint32_t wakeups;
+    /* system ticks the main thread has slept between scans */
+    uint32_t idle_ticks;
+} scan_scheduler_stats_t;
+
+void scan_scheduler_init(void);
+/* Sleeps until the next scan is due, called after keyboard_task() */
+void scan_scheduler_wait(void);
+/* Key interrupt, from a locked ISR context */
+void scan_scheduler_wakeup_i(void);
+/* Input from another thread, scans at once without leaving the idle rate */
+void scan_scheduler_wakeup(void);
+
+const scan_scheduler_stats_t *scan_scheduler_stats(void);
+void scan_scheduler_reset_stats(void);
+
+#endif
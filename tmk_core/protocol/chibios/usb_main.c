@@ -15,6 +15,7 @@
  * GPL v2 or later.
  */
 
+#include <string.h>
 #include "ch.h"
 #include "hal.h"
 
@@ -771,6 +772,7 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
   switch(event) {
   case USB_EVENT_RESET:
     //TODO: from ISR! print("[R]");
+    host_keyboard_forget();
     return;
 
   case USB_EVENT_ADDRESS:
@@ -806,6 +808,7 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
   case USB_EVENT_WAKEUP:
     //TODO: from ISR! print("[W]");
     suspend_wakeup_init();
+    host_keyboard_forget();
 #ifdef SLEEP_LED_ENABLE
     sleep_led_disable();
     // NOTE: converters may not accept this
@@ -1120,6 +1123,7 @@ void send_keyboard(report_keyboard_t *report) {
   osalSysLock();
   if(usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
     osalSysUnlock();
+    host_keyboard_forget();
     return;
   }
   osalSysUnlock();
@@ -1362,6 +1366,25 @@ int8_t sendchar(uint8_t c) {
   return(obqPutTimeout(&console_buf_queue, c, US2ST(100)));
 }
 
+#ifdef BINLOG_ENABLE
+/* Queues the whole report, or nothing when there is no empty buffer */
+bool binlog_send(uint8_t *packet, uint8_t length) {
+  if(length != CONSOLE_EPSIZE)
+    return false;
+  osalSysLock();
+  if(usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
+    osalSysUnlock();
+    return false;
+  }
+  osalSysUnlock();
+  if(obqGetEmptyBufferTimeout(&console_buf_queue, TIME_IMMEDIATE) != MSG_OK)
+    return false;
+  memcpy(console_buf_queue.ptr, packet, CONSOLE_EPSIZE);
+  obqPostFullBuffer(&console_buf_queue, CONSOLE_EPSIZE);
+  return true;
+}
+#endif /* BINLOG_ENABLE */
+
 #else /* CONSOLE_ENABLE */
 int8_t sendchar(uint8_t c) {
   (void)c;
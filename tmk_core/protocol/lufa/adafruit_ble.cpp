@@ -8,7 +8,7 @@
 #include "pincontrol.h"
 #include "timer.h"
 #include "action_util.h"
-#include "ringbuffer.hpp"
+#include "adafruit_ble_queue.hpp"
 #include <string.h>
 
 // These are the pin assignments for the 32u4 boards.
@@ -61,46 +61,44 @@ struct sdep_msg {
   uint8_t payload[SdepMaxPayload];
 } __attribute__((packed));
 
-// The recv latency is relatively high, so when we're hammering keys quickly,
-// we want to avoid waiting for the responses in the matrix loop.  We maintain
-// a short queue for that.  Since there is quite a lot of space overhead for
-// the AT command representation wrapped up in SDEP, we queue the minimal
-// information here.
-
-enum queue_type {
-  QTKeyReport, // 1-byte modifier + 6-byte key report
-  QTConsumer,  // 16-bit key code
-#ifdef MOUSE_ENABLE
-  QTMouseMove, // 4-byte mouse report
+// The number of commands that may be sent before their responses have been
+// read.  The module handles one command at a time, so by default we wait for
+// each response before sending the next command; raising this lets the next
+// report be clocked out while the module is still responding to the previous
+// one.
+#ifndef SdepMaxInFlight
+#define SdepMaxInFlight 1
 #endif
-};
-
-struct queue_item {
-  enum queue_type queue_type;
-  uint16_t added;
-  union __attribute__((packed)) {
-    struct __attribute__((packed)) {
-      uint8_t modifier;
-      uint8_t keys[6];
-    } key;
-
-    uint16_t consumer;
-    struct __attribute__((packed)) {
-      int8_t x, y, scroll, pan;
-      uint8_t buttons;
-    } mousemove;
-  };
-};
+static_assert(SdepMaxInFlight >= 1 && SdepMaxInFlight < 8,
+              "SdepMaxInFlight must be between 1 and 7");
+// The smallest power of two that holds SdepMaxInFlight entries
+#define SdepRespBufSize \
+  (SdepMaxInFlight < 2 ? 2 : SdepMaxInFlight < 4 ? 4 : 8)
 
 // Items that we wish to send
-static RingBuffer<queue_item, 40> send_buf;
-// Pending response; while pending, we can't send any more requests.
-// This records the time at which we sent the command for which we
+static ReportQueue<32> send_buf;
+// Pending responses; while the window is full, we can't send any more
+// requests.  This records the time at which we sent the commands for which we
 // are expecting a response.
-static RingBuffer<uint16_t, 2> resp_buf;
+static RingBuffer<uint16_t, SdepRespBufSize> resp_buf;
+
+#ifdef MOUSE_ENABLE
+// The buttons are latched by the module, so they only need to be sent
+// when they change
+static uint8_t last_buttons = 0;
+#endif
 
 static bool process_queue_item(struct queue_item *item, uint16_t timeout);
 
+// After a reset or a connection change the host may not have the last
+// reports, so they are sent again even if they haven't changed
+static void forget_sent_reports(void) {
+  send_buf.forget_sent();
+#ifdef MOUSE_ENABLE
+  last_buttons = 0;
+#endif
+}
+
 enum sdep_type {
   SdepCommand = 0x10,
   SdepResponse = 0x20,
@@ -349,14 +347,16 @@ static void send_buf_send_one(uint16_t timeout = SdepTimeout) {
   struct queue_item item;
 
   // Don't send anything more until we get an ACK
-  if (!resp_buf.empty()) {
+  if (resp_buf.size() >= SdepMaxInFlight) {
     return;
   }
 
-  if (!send_buf.peek(item)) {
+  if (send_buf.empty()) {
     return;
   }
-  if (process_queue_item(&item, timeout)) {
+  // Process the item in place, so that a partially sent mouse report
+  // isn't sent twice when it is retried
+  if (process_queue_item(&send_buf.front(), timeout)) {
     // commit that peek
     send_buf.get(item);
     dprintf("send_buf_send_one: have %d remaining\n", (int)send_buf.size());
@@ -382,6 +382,7 @@ static bool ble_init(void) {
   state.initialized = false;
   state.configured = false;
   state.is_connected = false;
+  forget_sent_reports();
 
   pinMode(AdafruitBleIRQPin, PinDirectionInput);
   pinMode(AdafruitBleCSPin, PinDirectionOutput);
@@ -588,6 +589,7 @@ static void set_connected(bool connected) {
       print("****** BLE DISCONNECT!!!!\n");
     }
     state.is_connected = connected;
+    forget_sent_reports();
 
     // TODO: if modifiers are down on the USB interface and
     // we cut over to BLE or vice versa, they will remain stuck.
@@ -607,7 +609,14 @@ void adafruit_ble_task(void) {
     return;
   }
   resp_buf_read_one(true);
-  send_buf_send_one(SdepShortTimeout);
+  // Send as many queued reports as the response window allows
+  while (!send_buf.empty() && resp_buf.size() < SdepMaxInFlight) {
+    uint8_t queued = send_buf.size();
+    send_buf_send_one(SdepShortTimeout);
+    if (send_buf.size() == queued) {
+      break;
+    }
+  }
 
   if (resp_buf.empty() && (state.event_flags & UsingEvents) &&
       digitalRead(AdafruitBleIRQPin)) {
@@ -669,7 +678,6 @@ void adafruit_ble_task(void) {
 
 static bool process_queue_item(struct queue_item *item, uint16_t timeout) {
   char cmdbuf[48];
-  char fmtbuf[64];
 
   // Arrange to re-check connection after keys have settled
   state.last_connection_update = timer_read();
@@ -683,40 +691,35 @@ static bool process_queue_item(struct queue_item *item, uint16_t timeout) {
 
   switch (item->queue_type) {
     case QTKeyReport:
-      strcpy_P(fmtbuf,
-          PSTR("AT+BLEKEYBOARDCODE=%02x-00-%02x-%02x-%02x-%02x-%02x-%02x"));
-      snprintf(cmdbuf, sizeof(cmdbuf), fmtbuf, item->key.modifier,
-               item->key.keys[0], item->key.keys[1], item->key.keys[2],
-               item->key.keys[3], item->key.keys[4], item->key.keys[5]);
+      ble_format_key_report(cmdbuf, *item);
       return at_command(cmdbuf, NULL, 0, true, timeout);
 
     case QTConsumer:
-      strcpy_P(fmtbuf, PSTR("AT+BLEHIDCONTROLKEY=0x%04x"));
-      snprintf(cmdbuf, sizeof(cmdbuf), fmtbuf, item->consumer);
+      ble_format_consumer(cmdbuf, *item);
       return at_command(cmdbuf, NULL, 0, true, timeout);
 
 #ifdef MOUSE_ENABLE
     case QTMouseMove:
-      strcpy_P(fmtbuf, PSTR("AT+BLEHIDMOUSEMOVE=%d,%d,%d,%d"));
-      snprintf(cmdbuf, sizeof(cmdbuf), fmtbuf, item->mousemove.x,
-          item->mousemove.y, item->mousemove.scroll, item->mousemove.pan);
-      if (!at_command(cmdbuf, NULL, 0, true, timeout)) {
-        return false;
-      }
-      strcpy_P(cmdbuf, PSTR("AT+BLEHIDMOUSEBUTTON="));
-      if (item->mousemove.buttons & MOUSE_BTN1) {
-        strcat(cmdbuf, "L");
-      }
-      if (item->mousemove.buttons & MOUSE_BTN2) {
-        strcat(cmdbuf, "R");
+      if (item->mousemove.x || item->mousemove.y || item->mousemove.scroll ||
+          item->mousemove.pan) {
+        ble_format_mouse_move(cmdbuf, *item);
+        if (!at_command(cmdbuf, NULL, 0, true, timeout)) {
+          return false;
+        }
+        // The move is done; if sending the buttons fails only those are
+        // retried
+        item->mousemove.x = item->mousemove.y = 0;
+        item->mousemove.scroll = item->mousemove.pan = 0;
       }
-      if (item->mousemove.buttons & MOUSE_BTN3) {
-        strcat(cmdbuf, "M");
+      if (item->mousemove.buttons == last_buttons) {
+        return true;
       }
-      if (item->mousemove.buttons == 0) {
-        strcat(cmdbuf, "0");
+      ble_format_mouse_buttons(cmdbuf, *item);
+      if (!at_command(cmdbuf, NULL, 0, true, timeout)) {
+        return false;
       }
-      return at_command(cmdbuf, NULL, 0, true, timeout);
+      last_buttons = item->mousemove.buttons;
+      return true;
 #endif
     default:
       return true;
@@ -740,7 +743,7 @@ bool adafruit_ble_send_keys(uint8_t hid_modifier_mask, uint8_t *keys,
     item.key.keys[4] = nkeys >= 4 ? keys[4] : 0;
     item.key.keys[5] = nkeys >= 5 ? keys[5] : 0;
 
-    if (!send_buf.enqueue(item)) {
+    if (!send_buf.enqueue_report(item)) {
       if (!didWait) {
         dprint("wait for buf space\n");
         didWait = true;
@@ -765,8 +768,9 @@ bool adafruit_ble_send_consumer_key(uint16_t keycode, int hold_duration) {
 
   item.queue_type = QTConsumer;
   item.consumer = keycode;
+  item.added = timer_read();
 
-  while (!send_buf.enqueue(item)) {
+  while (!send_buf.enqueue_report(item)) {
     send_buf_send_one();
   }
   return true;
@@ -783,8 +787,9 @@ bool adafruit_ble_send_mouse_move(int8_t x, int8_t y, int8_t scroll,
   item.mousemove.scroll = scroll;
   item.mousemove.pan = pan;
   item.mousemove.buttons = buttons;
+  item.added = timer_read();
 
-  while (!send_buf.enqueue(item)) {
+  while (!send_buf.enqueue_report(item)) {
     send_buf_send_one();
   }
   return true;
@@ -0,0 +1,262 @@
+#pragma once
+// Report queue for the Adafruit BLE module.
+//
+// The recv latency is relatively high, so when we're hammering keys quickly,
+// we want to avoid waiting for the responses in the matrix loop.  We maintain
+// a short queue for that.  Since there is quite a lot of space overhead for
+// the AT command representation wrapped up in SDEP, we queue the minimal
+// information here.
+//
+// Reports that are superseded before they are sent are collapsed in the
+// queue, so that the queue doesn't back up when reports are generated faster
+// than the module accepts them:
+//  - A key or consumer report identical to the previous one is dropped,
+//    until forget_sent() says the host may not have that one any more
+//  - Consecutive mouse moves with the same buttons are summed
+//
+// This file doesn't depend on the AVR hardware so that it can be unit tested.
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ringbuffer.hpp"
+#include "report.h"
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+// Keep the command strings in flash
+#define ble_append_str(dest, str) ble_append_P(dest, PSTR(str))
+#define ble_strlen strlen_P
+#define ble_memcpy memcpy_P
+#else
+#define ble_append_str(dest, str) ble_append_P(dest, str)
+#define ble_strlen strlen
+#define ble_memcpy memcpy
+#endif
+
+enum queue_type {
+  QTKeyReport, // 1-byte modifier + 6-byte key report
+  QTConsumer,  // 16-bit key code
+#ifdef MOUSE_ENABLE
+  QTMouseMove, // 4-byte mouse report
+#endif
+};
+
+struct queue_item {
+  enum queue_type queue_type;
+  uint16_t added;
+  union __attribute__((packed)) {
+    struct __attribute__((packed)) {
+      uint8_t modifier;
+      uint8_t keys[6];
+    } key;
+
+    uint16_t consumer;
+    struct __attribute__((packed)) {
+      int8_t x, y, scroll, pan;
+      uint8_t buttons;
+    } mousemove;
+  };
+};
+
+template <uint16_t Size>
+class ReportQueue : public RingBuffer<queue_item, Size> {
+ public:
+  // Queue a report, collapsing it with the reports that are already queued
+  // when possible. Returns false when the queue is full.
+  inline bool enqueue_report(const queue_item &item) {
+    switch (item.queue_type) {
+      case QTKeyReport:
+        if (have_key_ && !memcmp(&last_key_, &item.key, sizeof(last_key_))) {
+          ++coalesced_;
+          return true;
+        }
+        break;
+      case QTConsumer:
+        if (have_consumer_ && last_consumer_ == item.consumer) {
+          ++coalesced_;
+          return true;
+        }
+        break;
+#ifdef MOUSE_ENABLE
+      case QTMouseMove:
+        if (merge_mouse_move(item)) {
+          ++coalesced_;
+          return true;
+        }
+        break;
+#endif
+    }
+
+    if (!this->enqueue(item)) {
+      return false;
+    }
+    if (item.queue_type == QTKeyReport) {
+      memcpy(&last_key_, &item.key, sizeof(last_key_));
+      have_key_ = true;
+    } else if (item.queue_type == QTConsumer) {
+      last_consumer_ = item.consumer;
+      have_consumer_ = true;
+    }
+    if (this->size() > max_depth_) {
+      max_depth_ = this->size();
+    }
+    return true;
+  }
+
+  // The next key and consumer reports are queued even if they are the same as
+  // the last ones, for when the host may have lost those, like after the
+  // module was reset or the connection changed
+  inline void forget_sent() {
+    have_key_ = false;
+    have_consumer_ = false;
+  }
+
+  // The newest item in the queue; only valid when the queue isn't empty
+  inline queue_item &back() {
+    return this->buf_[this->prevPosition(this->head_)];
+  }
+
+  inline uint8_t max_depth() const { return max_depth_; }
+  inline uint16_t coalesced() const { return coalesced_; }
+
+ private:
+#ifdef MOUSE_ENABLE
+  static inline bool add_clamped(int8_t &dest, int8_t delta) {
+    int16_t sum = dest + delta;
+    if (sum < -127 || sum > 127) {
+      return false;
+    }
+    dest = sum;
+    return true;
+  }
+
+  inline bool merge_mouse_move(const queue_item &item) {
+    if (this->empty()) {
+      return false;
+    }
+    queue_item &prev = back();
+    if (prev.queue_type != QTMouseMove ||
+        prev.mousemove.buttons != item.mousemove.buttons) {
+      return false;
+    }
+    queue_item merged = prev;
+    if (!add_clamped(merged.mousemove.x, item.mousemove.x) ||
+        !add_clamped(merged.mousemove.y, item.mousemove.y) ||
+        !add_clamped(merged.mousemove.scroll, item.mousemove.scroll) ||
+        !add_clamped(merged.mousemove.pan, item.mousemove.pan)) {
+      return false;
+    }
+    prev = merged;
+    return true;
+  }
+#endif
+
+  struct __attribute__((packed)) {
+    uint8_t modifier;
+    uint8_t keys[6];
+  } last_key_;
+  uint16_t last_consumer_{0};
+  bool have_key_{false};
+  bool have_consumer_{false};
+  uint8_t max_depth_{0};
+  uint16_t coalesced_{0};
+};
+
+// AT command encoding for the queued reports. These are hand rolled rather
+// than using snprintf, which is slow on the AVR.
+
+static inline char ble_hex_digit(uint8_t nibble) {
+  return nibble < 10 ? '0' + nibble : 'a' + nibble - 10;
+}
+
+static inline char *ble_append_hex8(char *dest, uint8_t value) {
+  *dest++ = ble_hex_digit(value >> 4);
+  *dest++ = ble_hex_digit(value & 0xf);
+  return dest;
+}
+
+static inline char *ble_append_int8(char *dest, int8_t value) {
+  uint8_t v = value;
+  if (value < 0) {
+    *dest++ = '-';
+    v = -value;
+  }
+  if (v >= 100) {
+    *dest++ = '0' + v / 100;
+  }
+  if (v >= 10) {
+    *dest++ = '0' + (v / 10) % 10;
+  }
+  *dest++ = '0' + v % 10;
+  return dest;
+}
+
+static inline char *ble_append_P(char *dest, const char *str) {
+  size_t len = ble_strlen(str);
+  ble_memcpy(dest, str, len);
+  return dest + len;
+}
+
+// "AT+BLEKEYBOARDCODE=mm-00-k0-k1-k2-k3-k4-k5"
+// Trailing empty key slots are left out, which the module treats as released
+// keys. A typical report then fits in two SDEP packets rather than three.
+// dest must have room for at least 44 bytes.
+static inline uint8_t ble_format_key_report(char *dest, const queue_item &item) {
+  char *p = ble_append_str(dest, "AT+BLEKEYBOARDCODE=");
+  uint8_t nkeys = 6;
+  while (nkeys > 0 && item.key.keys[nkeys - 1] == 0) {
+    --nkeys;
+  }
+  p = ble_append_hex8(p, item.key.modifier);
+  p = ble_append_str(p, "-00");
+  for (uint8_t i = 0; i < nkeys; ++i) {
+    *p++ = '-';
+    p = ble_append_hex8(p, item.key.keys[i]);
+  }
+  *p = 0;
+  return p - dest;
+}
+
+// "AT+BLEHIDCONTROLKEY=0xkkkk"
+static inline uint8_t ble_format_consumer(char *dest, const queue_item &item) {
+  char *p = ble_append_str(dest, "AT+BLEHIDCONTROLKEY=0x");
+  p = ble_append_hex8(p, item.consumer >> 8);
+  p = ble_append_hex8(p, item.consumer & 0xff);
+  *p = 0;
+  return p - dest;
+}
+
+#ifdef MOUSE_ENABLE
+// "AT+BLEHIDMOUSEMOVE=x,y,scroll,pan"
+static inline uint8_t ble_format_mouse_move(char *dest, const queue_item &item) {
+  char *p = ble_append_str(dest, "AT+BLEHIDMOUSEMOVE=");
+  p = ble_append_int8(p, item.mousemove.x);
+  *p++ = ',';
+  p = ble_append_int8(p, item.mousemove.y);
+  *p++ = ',';
+  p = ble_append_int8(p, item.mousemove.scroll);
+  *p++ = ',';
+  p = ble_append_int8(p, item.mousemove.pan);
+  *p = 0;
+  return p - dest;
+}
+
+// "AT+BLEHIDMOUSEBUTTON=LRM" or "AT+BLEHIDMOUSEBUTTON=0"
+static inline uint8_t ble_format_mouse_buttons(char *dest, const queue_item &item) {
+  char *p = ble_append_str(dest, "AT+BLEHIDMOUSEBUTTON=");
+  if (item.mousemove.buttons & MOUSE_BTN1) {
+    *p++ = 'L';
+  }
+  if (item.mousemove.buttons & MOUSE_BTN2) {
+    *p++ = 'R';
+  }
+  if (item.mousemove.buttons & MOUSE_BTN3) {
+    *p++ = 'M';
+  }
+  if (item.mousemove.buttons == 0) {
+    *p++ = '0';
+  }
+  *p = 0;
+  return p - dest;
+}
+#endif
@@ -88,8 +88,11 @@
 
 #ifdef RAW_ENABLE
 	#include "raw_hid.h"
+	#include "raw_hid_channel.h"
 #endif
 
+#include "telemetry.h"
+
 uint8_t keyboard_idle = 0;
 /* 0: Boot Protocol, 1: Report Protocol(default) */
 uint8_t keyboard_protocol = 1;
@@ -187,17 +190,19 @@ USB_ClassInfo_CDC_Device_t cdc_device =
 
 #ifdef RAW_ENABLE
 
-void raw_hid_send( uint8_t *data, uint8_t length )
+bool raw_hid_send( uint8_t *data, uint8_t length )
 {
+	bool sent = false;
+
 	// TODO: implement variable size packet
 	if ( length != RAW_EPSIZE )
 	{
-		return;
+		return false;
 	}
 
 	if (USB_DeviceState != DEVICE_STATE_Configured)
 	{
-		return;
+		return false;
 	}
 
 	// TODO: decide if we allow calls to raw_hid_send() in the middle
@@ -213,9 +218,11 @@ void raw_hid_send( uint8_t *data, uint8_t length )
 		Endpoint_Write_Stream_LE(data, RAW_EPSIZE, NULL);
 		// Finalize the stream transfer to send the last packet
 		Endpoint_ClearIN();
+		sent = true;
 	}
 
 	Endpoint_SelectEndpoint(ep);
+	return sent;
 }
 
 __attribute__ ((weak))
@@ -254,7 +261,7 @@ static void raw_hid_task(void)
 
 		if ( data_read )
 		{
-			raw_hid_receive( data, sizeof(data) );
+			raw_hid_channel_receive( data, sizeof(data) );
 		}
 	}
 }
@@ -370,6 +377,7 @@ void EVENT_USB_Device_WakeUp()
 {
     print("[W]");
     suspend_wakeup_init();
+    host_keyboard_forget();
 
 #ifdef SLEEP_LED_ENABLE
     sleep_led_disable();
@@ -462,6 +470,9 @@ void EVENT_USB_Device_ConfigurationChanged(void)
     ConfigSuccess &= Endpoint_ConfigureEndpoint(CDC_OUT_EPADDR, EP_TYPE_BULK, CDC_EPSIZE, ENDPOINT_BANK_SINGLE);
     ConfigSuccess &= Endpoint_ConfigureEndpoint(CDC_IN_EPADDR, EP_TYPE_BULK, CDC_EPSIZE, ENDPOINT_BANK_SINGLE);
 #endif
+
+    /* Reports from before the host configured us went nowhere, send the last one again */
+    host_keyboard_forget();
 }
 
 /*
@@ -634,7 +645,11 @@ static void send_keyboard(report_keyboard_t *report)
 
         /* Check if write ready for a polling interval around 1ms */
         while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(4);
-        if (!Endpoint_IsReadWriteAllowed()) return;
+        if (!Endpoint_IsReadWriteAllowed()) {
+            telemetry_record(TELEMETRY_STALL, NKRO_IN_EPNUM, 0);
+            host_keyboard_forget();
+            return;
+        }
 
         /* Write Keyboard Report Data */
         Endpoint_Write_Stream_LE(report, NKRO_EPSIZE, NULL);
@@ -647,7 +662,11 @@ static void send_keyboard(report_keyboard_t *report)
 
         /* Check if write ready for a polling interval around 10ms */
         while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-        if (!Endpoint_IsReadWriteAllowed()) return;
+        if (!Endpoint_IsReadWriteAllowed()) {
+            telemetry_record(TELEMETRY_STALL, KEYBOARD_IN_EPNUM, 0);
+            host_keyboard_forget();
+            return;
+        }
 
         /* Write Keyboard Report Data */
         Endpoint_Write_Stream_LE(report, KEYBOARD_EPSIZE, NULL);
@@ -693,7 +712,10 @@ static void send_mouse(report_mouse_t *report)
 
     /* Check if write ready for a polling interval around 10ms */
     while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
+    if (!Endpoint_IsReadWriteAllowed()) {
+        telemetry_record(TELEMETRY_STALL, MOUSE_IN_EPNUM, 0);
+        return;
+    }
 
     /* Write Mouse Report Data */
     Endpoint_Write_Stream_LE(report, sizeof(report_mouse_t), NULL);
@@ -718,7 +740,10 @@ static void send_system(uint16_t data)
 
     /* Check if write ready for a polling interval around 10ms */
     while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
+    if (!Endpoint_IsReadWriteAllowed()) {
+        telemetry_record(TELEMETRY_STALL, EXTRAKEY_IN_EPNUM, 0);
+        return;
+    }
 
     Endpoint_Write_Stream_LE(&r, sizeof(report_extra_t), NULL);
     Endpoint_ClearIN();
@@ -773,7 +798,10 @@ static void send_consumer(uint16_t data)
 
     /* Check if write ready for a polling interval around 10ms */
     while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
+    if (!Endpoint_IsReadWriteAllowed()) {
+        telemetry_record(TELEMETRY_STALL, EXTRAKEY_IN_EPNUM, 0);
+        return;
+    }
 
     Endpoint_Write_Stream_LE(&r, sizeof(report_extra_t), NULL);
     Endpoint_ClearIN();
@@ -848,6 +876,29 @@ int8_t sendchar(uint8_t c)
 }
 #endif
 
+#if defined(CONSOLE_ENABLE) && defined(BINLOG_ENABLE)
+bool binlog_send(uint8_t *packet, uint8_t length)
+{
+    bool sent = false;
+
+    if (length != CONSOLE_EPSIZE || USB_DeviceState != DEVICE_STATE_Configured)
+        return false;
+
+    uint8_t ep = Endpoint_GetCurrentEndpoint();
+    Endpoint_SelectEndpoint(CONSOLE_IN_EPNUM);
+
+    // The whole report in one go, instead of sendchar() waiting on every byte
+    if (Endpoint_IsEnabled() && Endpoint_IsConfigured() && Endpoint_IsINReady()) {
+        Endpoint_Write_Stream_LE(packet, CONSOLE_EPSIZE, NULL);
+        Endpoint_ClearIN();
+        sent = true;
+    }
+
+    Endpoint_SelectEndpoint(ep);
+    return sent;
+}
+#endif
+
 /*******************************************************************************
  * MIDI
  ******************************************************************************/
@@ -915,7 +966,10 @@ static void usb_send_func(MidiDevice * device, uint16_t cnt, uint8_t byte0, uint
 
 static void usb_get_midi(MidiDevice * device) {
   MIDI_EventPacket_t event;
-  while (MIDI_Device_ReceiveEventPacket(&USB_MIDI_Interface, &event)) {
+  // packets that don't fit wait in the endpoint until the queue has been
+  // worked through, rather than being dropped
+  while (bytequeue_space(&device->input_queue) >= 3 &&
+         MIDI_Device_ReceiveEventPacket(&USB_MIDI_Interface, &event)) {
 
     midi_packet_length_t length = midi_packet_length(event.Data1);
     uint8_t input[3];
@@ -1194,13 +1248,6 @@ int main(void)
 
 #ifdef MIDI_ENABLE
         midi_device_process(&midi_device);
-#ifdef MIDI_ADVANCED
-        midi_task();
-#endif
-#endif
-
-#if defined(RGBLIGHT_ANIMATIONS) & defined(RGBLIGHT_ENABLE)
-        rgblight_task();
 #endif
 
 #ifdef MODULE_ADAFRUIT_BLE
@@ -1214,6 +1261,15 @@ int main(void)
 
 #ifdef RAW_ENABLE
         raw_hid_task();
+        raw_hid_channel_task();
+#endif
+
+#ifdef TELEMETRY_ENABLE
+        telemetry_task();
+#endif
+
+#if defined(CONSOLE_ENABLE) && defined(BINLOG_ENABLE)
+        binlog_task();
 #endif
 
 #if !defined(INTERRUPT_CONTROL_ENDPOINT)
@@ -1252,39 +1308,37 @@ void cc_callback(MidiDevice * device,
 }
 
 #ifdef API_SYSEX_ENABLE
-uint8_t midi_buffer[MIDI_SYSEX_BUFFER] = {0};
+// The message is decoded as it comes in, only the decoded form is stored
+static uint8_t api_buffer[API_SYSEX_MAX_SIZE];
+static uint16_t api_length;
+static bool api_overflow;
+static sysex_decoder_t api_decoder;
 #endif
 
 void sysex_callback(MidiDevice * device, uint16_t start, uint8_t length, uint8_t * data) {
     #ifdef API_SYSEX_ENABLE
-        // SEND_STRING("\n");
-        // send_word(start);
-        // SEND_STRING(": ");
         // Don't store the header
         int16_t pos = start - 4;
-        for (uint8_t place = 0; place < length; place++) {
-            // send_byte(*data);
-            if (pos >= 0) {
-                if (*data == 0xF7) {
-                    // SEND_STRING("\nRD: ");
-                    // for (uint8_t i = 0; i < start + place + 1; i++){
-                    //     send_byte(midi_buffer[i]);
-                    // SEND_STRING(" ");
-                    // }
-                    const unsigned decoded_length = sysex_decoded_length(pos);
-                    uint8_t decoded[API_SYSEX_MAX_SIZE];
-                    sysex_decode(decoded, midi_buffer, pos);
-                    process_api(decoded_length, decoded);
-                    return;
-                }
-                else if (pos >= MIDI_SYSEX_BUFFER) {
-                    return;
-                }
-                midi_buffer[pos] = *data;
+        if (start == 0) {
+            api_length = 0;
+            api_overflow = false;
+            sysex_decoder_init(&api_decoder);
+        }
+        for (uint8_t place = 0; place < length; place++, pos++) {
+            if (pos < 0) {
+                continue;
+            }
+            if (data[place] == 0xF7) {
+                // messages too big for the buffer are dropped
+                if (!api_overflow)
+                    process_api(api_length, api_buffer);
+                return;
+            }
+            if (api_decoder.count != 0 && api_length == API_SYSEX_MAX_SIZE) {
+                api_overflow = true;
+            } else if (!api_overflow) {
+                api_length += sysex_decoder_decode(&api_decoder, api_buffer + api_length, &data[place], 1);
             }
-            // SEND_STRING(" ");
-            data++;
-            pos++;
         }
     #endif
 }
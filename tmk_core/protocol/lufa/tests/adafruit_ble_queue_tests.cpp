@@ -0,0 +1,262 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "adafruit_ble_queue.hpp"
+
+static queue_item key_report(uint8_t modifier, uint8_t key, uint16_t now = 0) {
+    queue_item item;
+    memset(&item, 0, sizeof(item));
+    item.queue_type = QTKeyReport;
+    item.added = now;
+    item.key.modifier = modifier;
+    item.key.keys[0] = key;
+    return item;
+}
+
+static queue_item consumer_report(uint16_t code, uint16_t now = 0) {
+    queue_item item;
+    memset(&item, 0, sizeof(item));
+    item.queue_type = QTConsumer;
+    item.added = now;
+    item.consumer = code;
+    return item;
+}
+
+static queue_item mouse_report(int8_t x, int8_t y, uint8_t buttons, uint16_t now = 0) {
+    queue_item item;
+    memset(&item, 0, sizeof(item));
+    item.queue_type = QTMouseMove;
+    item.added = now;
+    item.mousemove.x = x;
+    item.mousemove.y = y;
+    item.mousemove.buttons = buttons;
+    return item;
+}
+
+// A stand-in for the nRF51 on the other side of the SPI bus. Every AT command
+// is split into SDEP packets of 16 bytes, which take some time to clock out,
+// and the module then takes a while before the response is ready.
+class SpiPeer {
+public:
+    static const uint32_t packet_time = 1;
+    static const uint32_t response_time = 4;
+
+    bool ready(uint32_t now) const { return now >= busy_until_; }
+
+    void send(const char* cmd, uint32_t now) {
+        uint32_t packets = (strlen(cmd) + 15) / 16;
+        busy_until_ = std::max(busy_until_, now) + packets * packet_time + response_time;
+        commands.push_back(cmd);
+        sdep_packets += packets;
+    }
+
+    std::vector<std::string> commands;
+    uint32_t sdep_packets = 0;
+private:
+    uint32_t busy_until_ = 0;
+};
+
+class AdafruitBleQueue : public testing::Test {
+public:
+    // Send the item at the front of the queue to the peer, like
+    // process_queue_item does
+    void send_front(uint32_t now) {
+        char cmd[48];
+        queue_item& item = queue.front();
+        switch (item.queue_type) {
+            case QTKeyReport:
+                ble_format_key_report(cmd, item);
+                peer.send(cmd, now);
+                break;
+            case QTConsumer:
+                ble_format_consumer(cmd, item);
+                peer.send(cmd, now);
+                break;
+            case QTMouseMove:
+                ble_format_mouse_move(cmd, item);
+                peer.send(cmd, now);
+                if (item.mousemove.buttons != last_buttons) {
+                    ble_format_mouse_buttons(cmd, item);
+                    peer.send(cmd, now);
+                    last_buttons = item.mousemove.buttons;
+                }
+                break;
+        }
+        max_latency = std::max(max_latency, now - item.added);
+        queue_item sent;
+        queue.get(sent);
+    }
+
+    void run_until(uint32_t& now, uint32_t end) {
+        for (; now < end; now++) {
+            if (!queue.empty() && peer.ready(now)) {
+                send_front(now);
+            }
+        }
+    }
+
+    ReportQueue<32> queue;
+    SpiPeer peer;
+    uint8_t last_buttons = 0;
+    uint32_t max_latency = 0;
+};
+
+TEST_F(AdafruitBleQueue, DuplicateKeyReportsAreDropped) {
+    EXPECT_TRUE(queue.enqueue_report(key_report(0, 4)));
+    EXPECT_TRUE(queue.enqueue_report(key_report(0, 4)));
+    EXPECT_TRUE(queue.enqueue_report(key_report(0, 0)));
+    EXPECT_TRUE(queue.enqueue_report(key_report(0, 0)));
+    EXPECT_EQ(queue.size(), 2);
+    EXPECT_EQ(queue.coalesced(), 2);
+}
+
+TEST_F(AdafruitBleQueue, KeyReportsAreDedupedAgainstTheLastSent) {
+    queue.enqueue_report(key_report(2, 4));
+    send_front(0);
+    EXPECT_TRUE(queue.enqueue_report(key_report(2, 4)));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(AdafruitBleQueue, ReportsAreSentAgainAfterForgettingTheLastSent) {
+    queue.enqueue_report(key_report(2, 4));
+    queue.enqueue_report(consumer_report(0xE9));
+    send_front(0);
+    send_front(0);
+    queue.forget_sent();
+    EXPECT_TRUE(queue.enqueue_report(key_report(2, 4)));
+    EXPECT_TRUE(queue.enqueue_report(consumer_report(0xE9)));
+    EXPECT_EQ(queue.size(), 2);
+    EXPECT_EQ(queue.coalesced(), 0);
+}
+
+TEST_F(AdafruitBleQueue, PressAndReleaseAreNotCollapsed) {
+    queue.enqueue_report(key_report(0, 4));
+    queue.enqueue_report(key_report(0, 0));
+    queue.enqueue_report(key_report(0, 4));
+    EXPECT_EQ(queue.size(), 3);
+}
+
+TEST_F(AdafruitBleQueue, DuplicateConsumerReportsAreDropped) {
+    queue.enqueue_report(consumer_report(0xE9));
+    queue.enqueue_report(consumer_report(0xE9));
+    queue.enqueue_report(consumer_report(0));
+    EXPECT_EQ(queue.size(), 2);
+}
+
+TEST_F(AdafruitBleQueue, MouseMovesAreSummed) {
+    queue.enqueue_report(mouse_report(10, -5, 0));
+    queue.enqueue_report(mouse_report(10, -5, 0));
+    queue.enqueue_report(mouse_report(3, 0, 0));
+    ASSERT_EQ(queue.size(), 1);
+    EXPECT_EQ(queue.front().mousemove.x, 23);
+    EXPECT_EQ(queue.front().mousemove.y, -10);
+}
+
+TEST_F(AdafruitBleQueue, MouseMovesWithDifferentButtonsAreNotSummed) {
+    queue.enqueue_report(mouse_report(10, 0, 0));
+    queue.enqueue_report(mouse_report(10, 0, MOUSE_BTN1));
+    EXPECT_EQ(queue.size(), 2);
+}
+
+TEST_F(AdafruitBleQueue, MouseMovesAreNotSummedWhenTheyOverflow) {
+    queue.enqueue_report(mouse_report(100, 0, 0));
+    queue.enqueue_report(mouse_report(100, 0, 0));
+    EXPECT_EQ(queue.size(), 2);
+}
+
+TEST_F(AdafruitBleQueue, MouseMovesAreNotSummedAcrossOtherReports) {
+    queue.enqueue_report(mouse_report(10, 0, 0));
+    queue.enqueue_report(key_report(0, 4));
+    queue.enqueue_report(mouse_report(10, 0, 0));
+    EXPECT_EQ(queue.size(), 3);
+}
+
+TEST_F(AdafruitBleQueue, KeyReportIsFormattedWithoutTrailingEmptyKeys) {
+    char cmd[48];
+    queue_item item = key_report(0x02, 0x04);
+    ble_format_key_report(cmd, item);
+    EXPECT_STREQ(cmd, "AT+BLEKEYBOARDCODE=02-00-04");
+    item = key_report(0, 0);
+    ble_format_key_report(cmd, item);
+    EXPECT_STREQ(cmd, "AT+BLEKEYBOARDCODE=00-00");
+    for (int i = 0; i < 6; i++) {
+        item.key.keys[i] = 0xA0 + i;
+    }
+    ble_format_key_report(cmd, item);
+    EXPECT_STREQ(cmd, "AT+BLEKEYBOARDCODE=00-00-a0-a1-a2-a3-a4-a5");
+}
+
+TEST_F(AdafruitBleQueue, ConsumerReportIsFormatted) {
+    char cmd[48];
+    ble_format_consumer(cmd, consumer_report(0x00E9));
+    EXPECT_STREQ(cmd, "AT+BLEHIDCONTROLKEY=0x00e9");
+}
+
+TEST_F(AdafruitBleQueue, MouseReportIsFormatted) {
+    char cmd[48];
+    queue_item item = mouse_report(-128, 127, MOUSE_BTN1 | MOUSE_BTN3);
+    item.mousemove.scroll = -1;
+    ble_format_mouse_move(cmd, item);
+    EXPECT_STREQ(cmd, "AT+BLEHIDMOUSEMOVE=-128,127,-1,0");
+    ble_format_mouse_buttons(cmd, item);
+    EXPECT_STREQ(cmd, "AT+BLEHIDMOUSEBUTTON=LM");
+    item.mousemove.buttons = 0;
+    ble_format_mouse_buttons(cmd, item);
+    EXPECT_STREQ(cmd, "AT+BLEHIDMOUSEBUTTON=0");
+}
+
+TEST_F(AdafruitBleQueue, TypingBurstDoesNotBackUpTheQueue) {
+    // 30 keys rolled 15ms apart, each pressed for 25ms. Like QMK does, every
+    // key event is followed by a redundant report of the same state.
+    uint32_t now = 0;
+    std::vector<uint8_t> down;
+    for (uint32_t t = 0; t < 30 * 15 + 25; t++) {
+        bool changed = false;
+        if (t % 15 == 0 && t < 30 * 15) {
+            down.push_back(4 + t / 15);
+            changed = true;
+        }
+        if (t >= 25 && (t - 25) % 15 == 0 && !down.empty()) {
+            down.erase(down.begin());
+            changed = true;
+        }
+        if (changed) {
+            queue_item item = key_report(0, 0, t);
+            for (size_t i = 0; i < down.size() && i < 6; i++) {
+                item.key.keys[i] = down[i];
+            }
+            ASSERT_TRUE(queue.enqueue_report(item));
+            ASSERT_TRUE(queue.enqueue_report(item));
+        }
+        run_until(now, t + 1);
+    }
+    run_until(now, now + 1000);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(peer.commands.size(), 60);
+    EXPECT_EQ(queue.coalesced(), 60);
+    EXPECT_LE(queue.max_depth(), 4);
+    EXPECT_LE(max_latency, 20);
+    // Without the trailing empty keys most reports fit in two SDEP packets
+    // instead of three
+    EXPECT_LT(peer.sdep_packets, 2.5 * peer.commands.size());
+}
+
+TEST_F(AdafruitBleQueue, MouseMovementDoesNotBackUpTheQueue) {
+    // Mouse reports every 2ms, much faster than the module accepts them
+    uint32_t now = 0;
+    int total_x = 0;
+    for (uint32_t t = 0; t < 1000; t += 2) {
+        ASSERT_TRUE(queue.enqueue_report(mouse_report(3, 0, 0, t)));
+        run_until(now, t + 2);
+    }
+    run_until(now, now + 100);
+    for (auto& cmd : peer.commands) {
+        int x, y, s, p;
+        ASSERT_EQ(sscanf(cmd.c_str(), "AT+BLEHIDMOUSEMOVE=%d,%d,%d,%d", &x, &y, &s, &p), 4);
+        total_x += x;
+    }
+    EXPECT_EQ(total_x, 3 * 500);
+    EXPECT_LE(queue.max_depth(), 2);
+    EXPECT_LE(max_latency, 2 * (SpiPeer::packet_time * 2 + SpiPeer::response_time));
+}
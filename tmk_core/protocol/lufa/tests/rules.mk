@@ -0,0 +1,6 @@
+LUFA_TEST_PATH := $(TMK_PATH)/protocol/lufa/tests
+
+lufa_adafruit_ble_queue_SRC :=\
+	$(LUFA_TEST_PATH)/adafruit_ble_queue_tests.cpp
+lufa_adafruit_ble_queue_DEFS := -DMOUSE_ENABLE
+lufa_adafruit_ble_queue_INC := $(TMK_PATH)/protocol/lufa
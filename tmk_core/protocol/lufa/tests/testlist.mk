@@ -0,0 +1,2 @@
+TEST_LIST +=\
+	lufa_adafruit_ble_queue
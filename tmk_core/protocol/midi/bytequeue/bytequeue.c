@@ -1,4 +1,4 @@
-//this is a single reader [maybe multiple writer?] byte queue
+//this is a single reader, single writer byte queue
 //Copyright 2008 Alex Norman
 //writen by Alex Norman 
 //
@@ -18,48 +18,33 @@
 //along with avr-bytequeue.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "bytequeue.h"
-#include "interrupt_setting.h"
 
 void bytequeue_init(byteQueue_t * queue, uint8_t * dataArray, byteQueueIndex_t arrayLen){
-   queue->length = arrayLen;
-   queue->data = dataArray;
-   queue->start = queue->end = 0;
+   spsc_ring_init(queue, dataArray, arrayLen);
 }
 
 bool bytequeue_enqueue(byteQueue_t * queue, uint8_t item){
-   interrupt_setting_t setting = store_and_clear_interrupt();
-   //full
-   if(((queue->end + 1) % queue->length) == queue->start){
-      restore_interrupt_setting(setting);
-      return false;
-   } else {
-      queue->data[queue->end] = item;
-      queue->end = (queue->end + 1) % queue->length;
-      restore_interrupt_setting(setting);
-      return true;
-   }
+   return spsc_ring_put(queue, item);
 }
 
 byteQueueIndex_t bytequeue_length(byteQueue_t * queue){
-   byteQueueIndex_t len;
-   interrupt_setting_t setting = store_and_clear_interrupt();
-   if(queue->end >= queue->start)
-      len = queue->end - queue->start;
-   else
-      len = (queue->length - queue->start) + queue->end;
-   restore_interrupt_setting(setting);
-   return len;
+   return spsc_ring_count(queue);
 }
 
-//we don't need to avoid interrupts if there is only one reader
+byteQueueIndex_t bytequeue_space(byteQueue_t * queue){
+   return spsc_ring_space(queue);
+}
+
+//only the reader moves the start index, so this needs no locking
 uint8_t bytequeue_get(byteQueue_t * queue, byteQueueIndex_t index){
-   return queue->data[(queue->start + index) % queue->length];
+   return spsc_ring_peek(queue, index);
+}
+
+byteQueueIndex_t bytequeue_peek_run(byteQueue_t * queue, const uint8_t ** run){
+   return spsc_ring_peek_run(queue, run);
 }
 
 //we just update the start index to remove elements
 void bytequeue_remove(byteQueue_t * queue, byteQueueIndex_t numToRemove){
-   interrupt_setting_t setting = store_and_clear_interrupt();
-   queue->start = (queue->start + numToRemove) % queue->length;
-   restore_interrupt_setting(setting);
+   spsc_ring_skip(queue, numToRemove);
 }
-
@@ -1,4 +1,4 @@
-//this is a single reader [maybe multiple writer?] byte queue
+//this is a single reader, single writer byte queue
 //Copyright 2008 Alex Norman
 //writen by Alex Norman 
 //
@@ -26,17 +26,15 @@ extern "C" {
 
 #include <inttypes.h>
 #include <stdbool.h>
+#include "spsc_ring.h"
 
 typedef uint8_t byteQueueIndex_t;
 
-typedef struct {
-	byteQueueIndex_t start;
-	byteQueueIndex_t end;
-	byteQueueIndex_t length;
-	uint8_t * data;
-} byteQueue_t;
+//the queue is a lock free ring, the writer may be an interrupt
+typedef spsc_ring_t byteQueue_t;
 
 //you must have a queue, an array of data which the queue will use, and the length of that array
+//the length must be a power of two, and the queue holds length - 1 bytes
 void bytequeue_init(byteQueue_t * queue, uint8_t * dataArray, byteQueueIndex_t arrayLen);
 
 //add an item to the queue, returns false if the queue is full
@@ -45,9 +43,14 @@ bool bytequeue_enqueue(byteQueue_t * queue, uint8_t item);
 //get the length of the queue
 byteQueueIndex_t bytequeue_length(byteQueue_t * queue);
 
+byteQueueIndex_t bytequeue_space(byteQueue_t * queue);
+
 //this grabs data at the index given [starting at queue->start]
 uint8_t bytequeue_get(byteQueue_t * queue, byteQueueIndex_t index);
 
+//points run at the longest contiguous stretch of queued bytes and returns its length
+byteQueueIndex_t bytequeue_peek_run(byteQueue_t * queue, const uint8_t ** run);
+
 //update the index in the queue to reflect data that has been dealt with 
 void bytequeue_remove(byteQueue_t * queue, byteQueueIndex_t numToRemove);
 
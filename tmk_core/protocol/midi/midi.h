@@ -55,7 +55,9 @@ void midi_device_init(MidiDevice * device); // [implementation in midi_device.c]
  * @brief Process input data
  *
  * This method drives the input processing, you must call this method frequently
- * if you expect to have your input callbacks called.
+ * if you expect to have your input callbacks called. At most
+ * MIDI_PROCESS_BUDGET queued bytes are processed per call, the rest are left
+ * for the next one.
  *
  * @param device the device to process
 */
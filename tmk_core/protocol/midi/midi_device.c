@@ -26,6 +26,7 @@
 //forward declarations, internally used to call the callbacks
 void midi_input_callbacks(MidiDevice * device, uint16_t cnt, uint8_t byte0, uint8_t byte1, uint8_t byte2);
 void midi_process_byte(MidiDevice * device, uint8_t input);
+static void midi_process_run(MidiDevice * device, const uint8_t * run, uint8_t len);
 
 void midi_device_init(MidiDevice * device){
   device->input_state = IDLE;
@@ -77,14 +78,55 @@ void midi_device_process(MidiDevice * device) {
   if(device->pre_input_process_callback)
     device->pre_input_process_callback(device);
 
-  //pull stuff off the queue and process
-  byteQueueIndex_t len = bytequeue_length(&device->input_queue);
-  uint16_t i;
-  //TODO limit number of bytes processed?
-  for(i = 0; i < len; i++) {
-    uint8_t val = bytequeue_get(&device->input_queue, 0);
-    midi_process_byte(device, val);
-    bytequeue_remove(&device->input_queue, 1);
+  //pull stuff off the queue and process it a contiguous run at a time
+  uint8_t budget = MIDI_PROCESS_BUDGET;
+  const uint8_t * run;
+  byteQueueIndex_t len;
+  while (budget > 0 && (len = bytequeue_peek_run(&device->input_queue, &run)) > 0) {
+    if (len > budget)
+      len = budget;
+    midi_process_run(device, run, len);
+    bytequeue_remove(&device->input_queue, len);
+    budget -= len;
+  }
+}
+
+static inline bool midi_is_databyte(uint8_t theByte) {
+  return !(theByte & 0x80);
+}
+
+//complete messages in the run are handed to the callbacks straight from the
+//run, everything else goes through the byte at a time state machine
+static void midi_process_run(MidiDevice * device, const uint8_t * run, uint8_t len) {
+  uint8_t i = 0;
+  while (i < len) {
+    const uint8_t * data = run + i;
+    const uint8_t remaining = len - i;
+    if (device->input_count == 1 && device->input_state == THREE_BYTE_MESSAGE &&
+        remaining >= 2 && midi_is_databyte(data[0]) && midi_is_databyte(data[1])) {
+      //running status, the status byte is still in the input buffer
+      device->input_buffer[1] = data[0];
+      device->input_buffer[2] = data[1];
+      midi_input_callbacks(device, 3, device->input_buffer[0], data[0], data[1]);
+      i += 2;
+    } else if (device->input_count == 1 && device->input_state == TWO_BYTE_MESSAGE &&
+        midi_is_databyte(data[0])) {
+      device->input_buffer[1] = data[0];
+      midi_input_callbacks(device, 2, device->input_buffer[0], data[0], 0);
+      i += 1;
+    } else if (device->input_state == SYSEX_MESSAGE && device->input_count % 3 == 0 &&
+        remaining >= 3 && midi_is_databyte(data[0]) && midi_is_databyte(data[1]) &&
+        midi_is_databyte(data[2])) {
+      device->input_buffer[0] = data[0];
+      device->input_buffer[1] = data[1];
+      device->input_buffer[2] = data[2];
+      device->input_count += 3;
+      midi_input_callbacks(device, device->input_count, data[0], data[1], data[2]);
+      i += 3;
+    } else {
+      midi_process_byte(device, data[0]);
+      i += 1;
+    }
   }
 }
 
@@ -49,7 +49,16 @@ extern "C" {
 
 #include "midi_function_types.h"
 #include "bytequeue/bytequeue.h"
-#define MIDI_INPUT_QUEUE_LENGTH 192
+//must be a power of two
+#ifndef MIDI_INPUT_QUEUE_LENGTH
+#define MIDI_INPUT_QUEUE_LENGTH 128
+#endif
+
+//the most input bytes a single midi_device_process call works through,
+//so that a burst of input can't hold up the rest of the main loop
+#ifndef MIDI_PROCESS_BUDGET
+#define MIDI_PROCESS_BUDGET 32
+#endif
 
 typedef enum {
    IDLE, 
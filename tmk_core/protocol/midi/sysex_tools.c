@@ -97,3 +97,57 @@ uint16_t sysex_decode(uint8_t *decoded, const uint8_t *source, const uint16_t le
    }
 }
 
+void sysex_encoder_init(sysex_encoder_t *encoder){
+   encoder->msbs = 0;
+   encoder->count = 0;
+}
+
+static uint8_t sysex_encoder_output(sysex_encoder_t *encoder, uint8_t *encoded){
+   uint8_t j;
+   encoded[0] = encoder->msbs;
+   for(j = 0; j < encoder->count; j++)
+      encoded[1 + j] = encoder->data[j];
+   return encoder->count + 1;
+}
+
+uint16_t sysex_encoder_encode(sysex_encoder_t *encoder, uint8_t *encoded, const uint8_t *source, uint16_t length){
+   uint16_t written = 0;
+   uint16_t i;
+   for(i = 0; i < length; i++) {
+      uint8_t current = source[i];
+      encoder->msbs |= (0x80 & current) >> (1 + encoder->count);
+      encoder->data[encoder->count++] = 0x7F & current;
+      if (encoder->count == 7) {
+         written += sysex_encoder_output(encoder, encoded + written);
+         sysex_encoder_init(encoder);
+      }
+   }
+   return written;
+}
+
+uint8_t sysex_encoder_finish(sysex_encoder_t *encoder, uint8_t *encoded){
+   uint8_t written = 0;
+   if (encoder->count)
+      written = sysex_encoder_output(encoder, encoded);
+   sysex_encoder_init(encoder);
+   return written;
+}
+
+void sysex_decoder_init(sysex_decoder_t *decoder){
+   decoder->msbs = 0;
+   decoder->count = 0;
+}
+
+uint16_t sysex_decoder_decode(sysex_decoder_t *decoder, uint8_t *decoded, const uint8_t *source, uint16_t length){
+   uint16_t written = 0;
+   uint16_t i;
+   for(i = 0; i < length; i++) {
+      if (decoder->count == 0) {
+         decoder->msbs = source[i];
+      } else {
+         decoded[written++] = (0x7F & source[i]) | (0x80 & (decoder->msbs << decoder->count));
+      }
+      decoder->count = (decoder->count + 1) % 8;
+   }
+   return written;
+}
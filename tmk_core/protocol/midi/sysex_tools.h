@@ -86,6 +86,76 @@ uint16_t sysex_encode(uint8_t *encoded, const uint8_t *source, uint16_t length);
  */
 uint16_t sysex_decode(uint8_t *decoded, const uint8_t *source, uint16_t length);
 
+/**
+ * @brief State of an incremental encoder.
+ *
+ * Holds the part of a 7 byte section that hasn't been encoded yet, so a
+ * message can be encoded in pieces of any size as it is sent.
+ */
+typedef struct {
+   uint8_t msbs;
+   uint8_t count;
+   uint8_t data[7];
+} sysex_encoder_t;
+
+/**
+ * @brief State of an incremental decoder.
+ */
+typedef struct {
+   uint8_t msbs;
+   uint8_t count;
+} sysex_decoder_t;
+
+/**
+ * @brief Start encoding a new message.
+ */
+void sysex_encoder_init(sysex_encoder_t *encoder);
+
+/**
+ * @brief Encode the next part of a message.
+ *
+ * Only complete 8 byte sections are output, the rest is kept in the encoder
+ * until more data comes in or sysex_encoder_finish is called.
+ *
+ * @param encoder The encoder state.
+ * @param encoded The output data buffer, must be at least (length / 7 + 1) * 8 bytes long.
+ * @param source The input buffer of data to be encoded.
+ * @param length The number of bytes from the input buffer to encode.
+ *
+ * @return number of bytes encoded.
+ */
+uint16_t sysex_encoder_encode(sysex_encoder_t *encoder, uint8_t *encoded, const uint8_t *source, uint16_t length);
+
+/**
+ * @brief Output what is left of the message and start a new one.
+ *
+ * @param encoder The encoder state.
+ * @param encoded The output data buffer, must be at least 8 bytes long.
+ *
+ * @return number of bytes encoded.
+ */
+uint8_t sysex_encoder_finish(sysex_encoder_t *encoder, uint8_t *encoded);
+
+/**
+ * @brief Start decoding a new message.
+ */
+void sysex_decoder_init(sysex_decoder_t *decoder);
+
+/**
+ * @brief Decode the next part of a message.
+ *
+ * The input can be split anywhere, the decoder keeps track of where in a
+ * section it is.
+ *
+ * @param decoder The decoder state.
+ * @param decoded The output data buffer, must be at least length bytes long.
+ * @param source The input buffer of data to be decoded.
+ * @param length The number of bytes from the input buffer to decode.
+ *
+ * @return number of bytes decoded.
+ */
+uint16_t sysex_decoder_decode(sysex_decoder_t *decoder, uint8_t *decoded, const uint8_t *source, uint16_t length);
+
 /**@}*/
 
 #ifdef __cplusplus
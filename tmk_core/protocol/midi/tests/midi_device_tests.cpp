@@ -0,0 +1,146 @@
+#include "gtest/gtest.h"
+#include <vector>
+#include <algorithm>
+
+// the midi headers include this inside extern "C", where its template can't be
+#include "spsc_ring.h"
+#include "midi.h"
+
+struct Message {
+    uint16_t count;
+    uint8_t bytes[3];
+
+    bool operator==(const Message& other) const {
+        return count == other.count && std::equal(bytes, bytes + 3, other.bytes);
+    }
+};
+
+static std::vector<Message> messages;
+static std::vector<uint8_t> sysex;
+static std::vector<uint8_t> stream;
+static size_t stream_position;
+
+static void catchall(MidiDevice* device, uint16_t count, uint8_t byte0, uint8_t byte1, uint8_t byte2) {
+    messages.push_back(Message{count, {byte0, byte1, byte2}});
+}
+
+static void sysex_callback(MidiDevice* device, uint16_t start, uint8_t length, uint8_t* data) {
+    EXPECT_EQ(start, sysex.size());
+    sysex.insert(sysex.end(), data, data + length);
+}
+
+// feeds the stream in the same way as the USB endpoint, as much as fits
+static void feed_stream(MidiDevice* device) {
+    while (stream_position < stream.size() && bytequeue_space(&device->input_queue) > 0) {
+        midi_device_input(device, 1, &stream[stream_position++]);
+    }
+}
+
+class MidiInput : public testing::Test {
+public:
+    MidiInput() {
+        midi_device_init(&device);
+        device.input_catchall_callback = catchall;
+        messages.clear();
+        sysex.clear();
+        stream.clear();
+        stream_position = 0;
+    }
+
+    void input(std::vector<uint8_t> bytes) {
+        for (uint8_t byte : bytes) {
+            ASSERT_TRUE(bytequeue_enqueue(&device.input_queue, byte));
+        }
+    }
+
+    // processes the queue, checking that no call goes over the budget
+    unsigned process_all() {
+        unsigned calls = 0;
+        while (bytequeue_length(&device.input_queue) > 0 || stream_position < stream.size()) {
+            unsigned before = stream_position - bytequeue_length(&device.input_queue);
+            midi_device_process(&device);
+            unsigned processed = stream_position - bytequeue_length(&device.input_queue) - before;
+            EXPECT_LE(processed, MIDI_PROCESS_BUDGET);
+            EXPECT_GT(processed, 0);
+            calls++;
+        }
+        return calls;
+    }
+
+    MidiDevice device;
+};
+
+TEST_F(MidiInput, ProcessStopsAtTheBudget) {
+    for (int i = 0; i < 40; i++) {
+        input({MIDI_NOTEON, 60, 100});
+    }
+    midi_device_process(&device);
+    EXPECT_EQ(bytequeue_length(&device.input_queue), 120 - MIDI_PROCESS_BUDGET);
+    EXPECT_EQ(messages.size(), MIDI_PROCESS_BUDGET / 3);
+    midi_device_process(&device);
+    midi_device_process(&device);
+    midi_device_process(&device);
+    EXPECT_EQ(bytequeue_length(&device.input_queue), 0);
+    EXPECT_EQ(messages.size(), 40);
+}
+
+TEST_F(MidiInput, RunsGiveTheSameMessagesAsSingleBytes) {
+    const std::vector<uint8_t> bytes = {
+        MIDI_NOTEON | 2, 60, 100, 61, 101, MIDI_CLOCK, 62, 102,
+        MIDI_PROGCHANGE | 3, 5, 6, 7,
+        MIDI_CC, 1, MIDI_START, 2, 3, 4,
+        SYSEX_BEGIN, 1, 2, 3, 4, MIDI_CLOCK, 5, 6, 7, 8, SYSEX_END,
+        MIDI_TUNEREQUEST, MIDI_PITCHBEND, 0, 64,
+    };
+    std::vector<Message> expected;
+    for (uint8_t byte : bytes) {
+        input({byte});
+        midi_device_process(&device);
+    }
+    std::swap(expected, messages);
+    ASSERT_EQ(expected.size(), 17);
+
+    // start at every position in the ring, so the runs are split everywhere
+    for (int offset = 0; offset < MIDI_INPUT_QUEUE_LENGTH; offset += 7) {
+        midi_device_init(&device);
+        device.input_catchall_callback = catchall;
+        device.input_queue.head = device.input_queue.tail = offset;
+        messages.clear();
+        input(bytes);
+        process_all();
+        EXPECT_EQ(messages, expected) << "offset " << offset;
+    }
+}
+
+TEST_F(MidiInput, LargeRunningStatusStreamIsProcessedInBoundedCalls) {
+    const unsigned notes = 20000;
+    stream.push_back(MIDI_NOTEON);
+    for (unsigned i = 0; i < notes; i++) {
+        stream.push_back(i & 0x7F);
+        stream.push_back((i >> 7) & 0x7F);
+    }
+    midi_device_set_pre_input_process_func(&device, feed_stream);
+    unsigned calls = process_all();
+
+    EXPECT_EQ(calls, (stream.size() + MIDI_PROCESS_BUDGET - 1) / MIDI_PROCESS_BUDGET);
+    ASSERT_EQ(messages.size(), notes);
+    for (unsigned i = 0; i < notes; i++) {
+        EXPECT_EQ(messages[i], (Message{3, {MIDI_NOTEON, uint8_t(i & 0x7F), uint8_t((i >> 7) & 0x7F)}}));
+    }
+}
+
+TEST_F(MidiInput, LargeSysexIsReassembled) {
+    std::vector<uint8_t> payload;
+    for (unsigned i = 0; i < 5000; i++) {
+        payload.push_back((i * 7) & 0x7F);
+    }
+    stream.push_back(SYSEX_BEGIN);
+    stream.insert(stream.end(), payload.begin(), payload.end());
+    stream.push_back(SYSEX_END);
+    device.input_sysex_callback = sysex_callback;
+    midi_device_set_pre_input_process_func(&device, feed_stream);
+    unsigned calls = process_all();
+
+    EXPECT_EQ(calls, (stream.size() + MIDI_PROCESS_BUDGET - 1) / MIDI_PROCESS_BUDGET);
+    EXPECT_EQ(sysex, stream);
+}
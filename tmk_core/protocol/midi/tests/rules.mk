@@ -0,0 +1,15 @@
+MIDI_TEST_PATH := $(TMK_PATH)/protocol/midi/tests
+
+midi_device_SRC :=\
+	$(MIDI_TEST_PATH)/midi_device_tests.cpp \
+	$(TMK_PATH)/protocol/midi/midi_device.c \
+	$(TMK_PATH)/protocol/midi/midi.c \
+	$(TMK_PATH)/protocol/midi/bytequeue/bytequeue.c
+midi_device_INC :=\
+	$(TMK_PATH)/protocol/midi \
+	$(TMK_PATH)/common
+
+midi_sysex_tools_SRC :=\
+	$(MIDI_TEST_PATH)/sysex_tools_tests.cpp \
+	$(TMK_PATH)/protocol/midi/sysex_tools.c
+midi_sysex_tools_INC := $(TMK_PATH)/protocol/midi
@@ -0,0 +1,3 @@
+TEST_LIST +=\
+	midi_device \
+	midi_sysex_tools
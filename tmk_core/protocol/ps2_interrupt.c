@@ -45,6 +45,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "ps2.h"
 #include "ps2_io.h"
 #include "print.h"
+#include "spsc_ring.h"
 
 
 #define WAIT(stat, us, err) do { \
@@ -231,49 +232,27 @@ void ps2_host_set_led(uint8_t led)
  * Ring buffer to store scan codes from keyboard
  *------------------------------------------------------------------*/
 #define PBUF_SIZE 32
-static uint8_t pbuf[PBUF_SIZE];
-static uint8_t pbuf_head = 0;
-static uint8_t pbuf_tail = 0;
+SPSC_RING_DEFINE(pbuf, PBUF_SIZE);
+/* The ISR is the only producer and the main loop the only consumer, so the
+ * ring needs no interrupt locking */
 static inline void pbuf_enqueue(uint8_t data)
 {
-    uint8_t sreg = SREG;
-    cli();
-    uint8_t next = (pbuf_head + 1) % PBUF_SIZE;
-    if (next != pbuf_tail) {
-        pbuf[pbuf_head] = data;
-        pbuf_head = next;
-    } else {
+    if (!spsc_ring_put(&pbuf, data)) {
         print("pbuf: full\n");
     }
-    SREG = sreg;
 }
 static inline uint8_t pbuf_dequeue(void)
 {
     uint8_t val = 0;
-
-    uint8_t sreg = SREG;
-    cli();
-    if (pbuf_head != pbuf_tail) {
-        val = pbuf[pbuf_tail];
-        pbuf_tail = (pbuf_tail + 1) % PBUF_SIZE;
-    }
-    SREG = sreg;
-
+    spsc_ring_get(&pbuf, &val);
     return val;
 }
 static inline bool pbuf_has_data(void)
 {
-    uint8_t sreg = SREG;
-    cli();
-    bool has_data = (pbuf_head != pbuf_tail);
-    SREG = sreg;
-    return has_data;
+    return !spsc_ring_empty(&pbuf);
 }
 static inline void pbuf_clear(void)
 {
-    uint8_t sreg = SREG;
-    cli();
-    pbuf_head = pbuf_tail = 0;
-    SREG = sreg;
+    spsc_ring_clear(&pbuf);
 }
 
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""Prints the console output of a keyboard built with BINLOG_ENABLE.
+
+The keyboard only sends the addresses of its format strings and the raw
+arguments, the strings are read from the firmware ELF the keyboard was
+flashed with. See docs/binlog.md. Needs the hid module (pip install hid).
+
+    python3 util/binlog_decode.py .build/planck_rev4_default.elf
+"""
+import re
+import struct
+import sys
+
+import hid
+
+USAGE_PAGE = 0xFF31
+USAGE = 0x74
+TEXT = 0x80
+EM_AVR = 83
+SHT_PROGBITS = 1
+SHF_ALLOC = 2
+
+CONVERSION = re.compile(r'%([-0]*)(\d*)([lL]?)(.)')
+
+
+class Firmware:
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1 or self.data[5] != 1:
+            sys.exit('%s is not a 32 bit little endian ELF' % path)
+        machine, = struct.unpack_from('<H', self.data, 18)
+        shoff, = struct.unpack_from('<I', self.data, 32)
+        shentsize, shnum = struct.unpack_from('<HH', self.data, 46)
+        # the sizes of the promoted arguments
+        if machine == EM_AVR:
+            self.int_size, self.long_size, self.pointer_size = 2, 4, 2
+        else:
+            self.int_size, self.long_size, self.pointer_size = 4, 4, 4
+        self.sections = []
+        for i in range(shnum):
+            _, kind, flags, addr, offset, size = struct.unpack_from('<IIIIII', self.data, shoff + i * shentsize)
+            if kind == SHT_PROGBITS and flags & SHF_ALLOC:
+                self.sections.append((addr, offset, size))
+
+    def string(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.index(b'\0', start)
+                return self.data[start:end].decode('latin-1')
+        return '<unknown string %x>' % address
+
+
+def integer(raw, signed):
+    return int.from_bytes(raw, 'little', signed=signed)
+
+
+def format_record(firmware, string, args):
+    """Does what xprintf would have done on the keyboard"""
+    out = []
+    position = 0
+    last = 0
+    for match in CONVERSION.finditer(string):
+        flags, width, long_flag, kind = match.groups()
+        out.append(string[last:match.start()])
+        last = match.end()
+        if kind == '%':
+            out.append('%')
+            continue
+        if kind == 's':
+            end = args.find(b'\0', position)
+            if end < 0:
+                out.append('<missing>')
+                break
+            text = args[position:end].decode('latin-1')
+            position = end + 1
+        else:
+            size = firmware.pointer_size if kind == 'S' else firmware.long_size if long_flag else firmware.int_size
+            if position + size > len(args):
+                out.append('<missing>')
+                break
+            raw = args[position:position + size]
+            position += size
+            if kind == 'S':
+                text = firmware.string(integer(raw, False))
+            elif kind in 'di':
+                text = str(integer(raw, True))
+            elif kind == 'c':
+                text = chr(raw[0])
+            else:
+                base = {'u': 'd', 'x': 'x', 'X': 'X', 'b': 'b', 'o': 'o'}.get(kind)
+                if base is None:
+                    text = '<%%%s>' % kind
+                else:
+                    text = format(integer(raw, False), base)
+        if width:
+            pad = '0' if '0' in flags else ' '
+            text = text.ljust(int(width)) if '-' in flags else text.rjust(int(width), pad)
+        out.append(text)
+    else:
+        out.append(string[last:])
+    return ''.join(out)
+
+
+def decode_packet(firmware, packet):
+    if packet[0]:
+        yield '\n-- %d messages dropped\n' % packet[0]
+    position = 1
+    while position < len(packet) and packet[position]:
+        header = packet[position]
+        address = integer(packet[position + 1:position + 1 + firmware.pointer_size], False)
+        start = position + 1 + firmware.pointer_size
+        end = start + (header & ~TEXT) - 1
+        string = firmware.string(address)
+        yield string if header & TEXT else format_record(firmware, string, packet[start:end])
+        position = end
+
+
+def find_device():
+    for info in hid.enumerate():
+        if info['usage_page'] == USAGE_PAGE and info['usage'] == USAGE:
+            return info['path']
+    sys.exit('No console device found')
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('usage: %s firmware.elf' % sys.argv[0])
+    firmware = Firmware(sys.argv[1])
+    device = hid.device()
+    device.open_path(find_device())
+    while True:
+        packet = bytes(device.read(64))
+        if packet:
+            for text in decode_packet(firmware, packet):
+                sys.stdout.write(text)
+            sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
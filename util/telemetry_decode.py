@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Prints the telemetry stream of a keyboard built with TELEMETRY_ENABLE.
+
+See docs/telemetry.md for the format. Needs the hid module (pip install hid).
+"""
+import struct
+import sys
+
+import hid
+
+USAGE_PAGE = 0xFF60
+USAGE = 0x61
+PACKET_MARKER = 0x54
+HEADER_SIZE = 4
+RECORD = struct.Struct('<BBHI')
+
+REPORTS = ['keyboard', 'mouse', 'system', 'consumer']
+
+
+def describe(kind, arg, value):
+    if kind == 1:
+        return 'scan rate %d/s' % value
+    if kind in (2, 3):
+        return 'key %s row %d col %d' % ('down' if kind == 2 else 'up', arg, value)
+    if kind == 4:
+        name = REPORTS[arg] if arg < len(REPORTS) else str(arg)
+        return 'report %s %04x' % (name, value)
+    if kind == 5:
+        return 'stall endpoint %d' % arg
+    if kind == 6:
+        return 'tap %d row %d col %d' % (arg, value >> 8, value & 0xFF)
+    if kind == 7:
+        return 'hold (%s) row %d col %d' % ('interrupted' if arg else 'timeout', value >> 8, value & 0xFF)
+    if kind == 8:
+        return 'combo %d %s' % (arg, 'fired' if value else 'timed out')
+    if kind == 9:
+        return 'variable %d [%d] = %04x' % (arg >> 4, arg & 0xF, value)
+    if kind == 10:
+        return 'variable %d %s line %d' % (arg & 0x7F, 'changed by' if arg & 0x80 else 'unchanged at', value)
+    return 'unknown %d arg %d value %d' % (kind, arg, value)
+
+
+def find_device():
+    for info in hid.enumerate():
+        if info['usage_page'] == USAGE_PAGE and info['usage'] == USAGE:
+            return info['path']
+    sys.exit('No raw HID device found')
+
+
+def main():
+    device = hid.device()
+    device.open_path(find_device())
+    sequence = None
+    last_key = None
+    while True:
+        packet = bytes(device.read(64))
+        if len(packet) < HEADER_SIZE or packet[0] != PACKET_MARKER:
+            continue
+        if sequence is not None and packet[1] != (sequence + 1) & 0xFF:
+            print('-- lost packets')
+        sequence = packet[1]
+        if packet[3]:
+            print('-- %d events dropped' % packet[3])
+        for i in range(packet[2]):
+            kind, arg, value, time = RECORD.unpack_from(packet, HEADER_SIZE + i * RECORD.size)
+            line = '%10d %s' % (time, describe(kind, arg, value))
+            if kind in (2, 3):
+                last_key = time
+            elif kind == 4 and arg == 0 and last_key is not None:
+                line += ' (%d ms after the key)' % (time - last_key)
+                last_key = None
+            print(line)
+
+
+if __name__ == '__main__':
+    main()